@@ -111,6 +111,83 @@ async function loadStoredConfig() {
             }
         }
 
+        if (config["level-mode"]) {
+            const levelModeSelect = document.getElementById('level-mode');
+            if (levelModeSelect) {
+                levelModeSelect.value = config["level-mode"];
+            }
+        }
+
+        if (config.weighting) {
+            const weightingSelect = document.getElementById('weighting');
+            if (weightingSelect) {
+                weightingSelect.value = config.weighting;
+            }
+        }
+
+        if (config["band-mode"]) {
+            const bandModeSelect = document.getElementById('band-mode');
+            if (bandModeSelect) {
+                bandModeSelect.value = config["band-mode"];
+            }
+        }
+
+        if (config["transient-window"] !== undefined) {
+            const transientWindowSelect = document.getElementById('transient-window');
+            if (transientWindowSelect) {
+                transientWindowSelect.value = String(config["transient-window"]);
+            }
+        }
+
+        if (config["transient-threshold"] !== undefined) {
+            const transientThresholdInput = document.getElementById('transient-threshold');
+            if (transientThresholdInput) {
+                transientThresholdInput.value = config["transient-threshold"];
+            }
+        }
+
+        if (config["channel-aggregation"]) {
+            const aggregationSelect = document.getElementById('channel-aggregation');
+            if (aggregationSelect) {
+                aggregationSelect.value = config["channel-aggregation"];
+            }
+        }
+
+        if (config["channel-weights"] !== undefined) {
+            const weightsInput = document.getElementById('channel-weights');
+            if (weightsInput) {
+                weightsInput.value = config["channel-weights"];
+            }
+        }
+
+        if (config["adaptive-sampling"] !== undefined) {
+            const adaptiveSelect = document.getElementById('adaptive-sampling');
+            if (adaptiveSelect) {
+                adaptiveSelect.value = String(config["adaptive-sampling"]);
+            }
+        }
+
+        if (config["override-hold"] !== undefined) {
+            const holdSelect = document.getElementById('override-hold');
+            if (holdSelect) {
+                holdSelect.value = String(config["override-hold"]);
+            }
+        }
+
+        if (config["recording-mode"]) {
+            const recordingModeSelect = document.getElementById('recording-mode');
+            if (recordingModeSelect) {
+                recordingModeSelect.value = config["recording-mode"];
+            }
+        }
+
+        if (config["calibration-offset"] !== undefined) {
+            const offsetInput = document.getElementById('calibration-offset');
+            if (offsetInput) {
+                offsetInput.value = config["calibration-offset"];
+            }
+        }
+
         // Update connection status if SSID is present
         if (config.ssid) {
             updateConnectionStatus(true);
@@ -377,10 +454,167 @@ function updateConnectionStatus(status) {
     }
 }
 
+// Venue calibration: start a measurement, then poll its progress
+let calibrationTimer = null;
+
+async function startCalibration(phase) {
+    const body = new URLSearchParams({phase: phase});
+    if (phase === 'quiet' || phase === 'busy') {
+        body.append('duration', document.getElementById('calibration-duration').value);
+        body.append('quiet-volume', document.getElementById('calibration-quiet-volume').value);
+        body.append('busy-volume', document.getElementById('calibration-busy-volume').value);
+    }
+    try {
+        const response = await fetch('/calibrate', {
+            method: 'POST',
+            headers: {
+                'Content-Type': 'application/x-www-form-urlencoded',
+            },
+            body: body.toString()
+        });
+        if (!response.ok) {
+            throw new Error(await response.text());
+        }
+        debugLog(`Calibration request sent: ${phase}`);
+        setTimeout(loadCalibration, 500);
+    } catch (error) {
+        showStatus('Calibration failed: ' + error.message, 'error');
+        debugLog('Calibration error: ' + error.message);
+    }
+}
+
+async function loadCalibration() {
+    try {
+        const response = await fetch('/calibration');
+        if (!response.ok) {
+            return;
+        }
+        const calibration = await response.json();
+        const progress = document.getElementById('calibration-progress');
+        if (progress) {
+            const measured = `quiet ${calibration["quiet-level"] !== undefined ? calibration["quiet-level"].toFixed(3) : '-'}, ` +
+                             `busy ${calibration["busy-level"] !== undefined ? calibration["busy-level"].toFixed(3) : '-'}`;
+            if (calibration.phase !== 'idle') {
+                progress.textContent = `Measuring the ${calibration.phase} room: ` +
+                                       `${Math.round(calibration.progress * 100)}%, ${calibration["remaining-s"]} s left (${measured})`;
+            } else {
+                progress.textContent = (calibration.calibrated ? 'Calibrated: ' : 'Not calibrated: ') + measured;
+            }
+        }
+        ['quiet-volume', 'busy-volume'].forEach(field => {
+            const input = document.getElementById('calibration-' + field);
+            if (input && calibration[field] !== undefined && document.activeElement !== input) {
+                input.value = calibration[field];
+            }
+        });
+
+        clearTimeout(calibrationTimer);
+        if (calibration.phase !== 'idle') {
+            calibrationTimer = setTimeout(loadCalibration, 2000);
+        }
+    } catch (error) {
+        debugLog('Error loading calibration: ' + error.message);
+    }
+}
+
+async function saveSchedule() {
+    const body = new URLSearchParams({
+        rules: document.getElementById('schedule-rules').value,
+        timezone: document.getElementById('schedule-timezone').value.trim()
+    });
+    try {
+        const response = await fetch('/schedule', {
+            method: 'POST',
+            headers: {
+                'Content-Type': 'application/x-www-form-urlencoded',
+            },
+            body: body.toString()
+        });
+        if (!response.ok) {
+            throw new Error(await response.text());
+        }
+        showStatus('Schedule saved', 'success');
+        setTimeout(loadSchedule, 500);
+    } catch (error) {
+        showStatus('Saving the schedule failed: ' + error.message, 'error');
+        debugLog('Schedule error: ' + error.message);
+    }
+}
+
+async function loadSchedule() {
+    try {
+        const response = await fetch('/schedule');
+        if (!response.ok) {
+            return;
+        }
+        const schedule = await response.json();
+        document.getElementById('schedule-rules').value = schedule.rules.join('\n');
+        document.getElementById('schedule-timezone').value = schedule.timezone;
+        const status = document.getElementById('schedule-status');
+        if (status) {
+            const envelope = schedule.envelope;
+            status.textContent = schedule["time-synced"]
+                ? `Now ${schedule["local-time"]}: volume ${envelope.min}-${envelope.max}, bias ${envelope.bias}`
+                : 'Clock not set yet; the schedule applies once the time is synced';
+        }
+    } catch (error) {
+        debugLog('Error loading schedule: ' + error.message);
+    }
+}
+
+async function triggerRecording() {
+    try {
+        const response = await fetch('/recordings/trigger', {method: 'POST'});
+        if (!response.ok) {
+            throw new Error(await response.text());
+        }
+        showStatus('Recording a snippet', 'success');
+        setTimeout(loadRecordings, 10000); // Pre-roll plus about 8 s
+    } catch (error) {
+        showStatus('Recording failed: ' + error.message, 'error');
+        debugLog('Recording error: ' + error.message);
+    }
+}
+
+async function loadRecordings() {
+    const list = document.getElementById('recording-list');
+    if (!list) {
+        return;
+    }
+    try {
+        const response = await fetch('/recordings');
+        if (!response.ok) {
+            list.textContent = 'Recording not available';
+            return;
+        }
+        const status = await response.json();
+        list.innerHTML = '';
+        status.recordings.forEach(recording => {
+            const item = document.createElement('li');
+            const link = document.createElement('a');
+            link.href = `/recordings/audio?snippet=${recording.snippet}`;
+            link.textContent = `Snippet ${recording.snippet}`;
+            const when = recording["age-seconds"] !== undefined
+                ? `${Math.round(recording["age-seconds"] / 60)} min ago` : 'before the last restart';
+            item.appendChild(link);
+            item.append(` - ${recording.reason}, ${recording.seconds.toFixed(1)} s, ${when}`);
+            list.appendChild(item);
+        });
+        if (status.recordings.length === 0) {
+            list.textContent = 'No recordings yet';
+        }
+    } catch (error) {
+        debugLog('Error loading recordings: ' + error.message);
+    }
+}
+
 // Add window load event listener
 window.addEventListener('load', () => {
     debugLog('Page loaded');
     loadStoredConfig();
     loadCurrentSensitivity();
+    loadCalibration();
+    loadSchedule();
+    loadRecordings();
 });
 
@@ -0,0 +1,120 @@
+#include "adaptive_sampler.h"
+#include <math.h>
+
+AdaptiveSampler::AdaptiveSampler()
+    : _stableSeconds(0)
+    , _lowDuty(false)
+    , _primed(false)
+    , _mean(0)
+    , _deviation(0)
+    , _stable(false)
+    , _stableSinceMs(0)
+    , _lastTimestampMs(0)
+    , _wakeCount(0)
+    , _processedBlocks(0)
+    , _settlingBlocks(0)
+    , _standbyBlocks(0) {
+}
+
+void AdaptiveSampler::setStableSeconds(uint16_t seconds) {
+    if (seconds != 0 && (seconds < MIN_STABLE_SECONDS || seconds > MAX_STABLE_SECONDS)) {
+        return;
+    }
+    _stableSeconds = seconds;
+    if (seconds == 0 && _lowDuty) {
+        wake();
+    }
+}
+
+uint16_t AdaptiveSampler::getStableSeconds() const {
+    return _stableSeconds;
+}
+
+bool AdaptiveSampler::addReading(float level, uint32_t timestampMs) {
+    if (isnan(level)) {
+        return false;
+    }
+    if (!_primed) {
+        _mean = level;
+        _deviation = 0;
+        _lastTimestampMs = timestampMs;
+        _primed = true;
+        return false;
+    }
+
+    // Smoothing by time, as readings come 20 times slower at low duty
+    float seconds = (timestampMs - _lastTimestampMs) / 1000.0f;
+    _lastTimestampMs = timestampMs;
+    float alpha = seconds >= STABILITY_SECONDS ? 1.0f : seconds / STABILITY_SECONDS;
+    float error = level - _mean;
+    bool changed = _change.add(level) != 0;
+
+    bool woke = false;
+    if (_lowDuty) {
+        float limit = fmaxf(WAKE_DEVIATIONS * ChangeDetector::MAD_TO_SIGMA * _deviation,
+                            MIN_WAKE_DEVIATION * _mean);
+        if (changed || fabsf(error) > limit) {
+            wake();
+            woke = true;
+        }
+    }
+    // Windows a second apart vary more than adjacent ones; the deviation
+    // learned at full rate stays the yardstick while at low duty
+    _mean += alpha * error;
+    if (_lowDuty) {
+        return false;
+    }
+    _deviation += alpha * (fabsf(error) - _deviation);
+    if (woke) {
+        return true;
+    }
+
+    if (_stableSeconds == 0 || changed || _deviation > STABLE_DEVIATION * _mean) {
+        _stable = false;
+        return false;
+    }
+    if (!_stable) {
+        _stable = true;
+        _stableSinceMs = timestampMs;
+    }
+    if (timestampMs - _stableSinceMs >= static_cast<uint32_t>(_stableSeconds) * 1000) {
+        _lowDuty = true;
+        return true;
+    }
+    return false;
+}
+
+bool AdaptiveSampler::isLowDuty() const {
+    return _lowDuty;
+}
+
+void AdaptiveSampler::countProcessed(uint32_t blocks) {
+    _processedBlocks += blocks;
+}
+
+void AdaptiveSampler::countSettling(uint32_t blocks) {
+    _settlingBlocks += blocks;
+}
+
+void AdaptiveSampler::countStandby(uint32_t blocks) {
+    _standbyBlocks += blocks;
+}
+
+SamplingStats AdaptiveSampler::getStats() const {
+    SamplingStats stats;
+    stats.lowDuty = _lowDuty;
+    stats.wakeCount = _wakeCount;
+    uint64_t total = _processedBlocks + _settlingBlocks + _standbyBlocks;
+    float active = total > 0 ? static_cast<float>(_processedBlocks + _settlingBlocks) / total : 1.0f;
+    float processed = total > 0 ? static_cast<float>(_processedBlocks) / total : 1.0f;
+    stats.activePercent = active * 100;
+    stats.processedPercent = processed * 100;
+    stats.currentMa = active * ADC_CURRENT_MA + processed * DSP_CURRENT_MA;
+    return stats;
+}
+
+void AdaptiveSampler::wake() {
+    _lowDuty = false;
+    _stable = false;
+    _wakeCount++;
+}
@@ -0,0 +1,80 @@
+#ifndef ADAPTIVE_SAMPLER_H
+#define ADAPTIVE_SAMPLER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "change_detector.h"
+
+// What the sampling has cost since boot, published with every reading
+struct SamplingStats {
+    bool lowDuty;           // Sampling one window per LOW_DUTY_PERIOD_MS
+    float activePercent;    // Share of the time the ADC was running
+    float processedPercent; // Share of the time's blocks that went through the DSP
+    float currentMa;        // Average sampling current proxy, see AdaptiveSampler
+    uint32_t wakeCount;     // Returns from low to full rate
+};
+
+// Decides when the sound sensor may drop to a low duty cycle.
+//
+// The level is stable while its mean absolute deviation from a running mean
+// (both smoothed over STABILITY_SECONDS) stays within STABLE_DEVIATION of
+// that mean and the CUSUM change detector stays quiet. After the configured
+// stable time the sensor samples one window every LOW_DUTY_PERIOD_MS and
+// leaves the ADC off in between. Any of those windows straying more than
+// WAKE_DEVIATIONS from the mean, or a change point across them, returns it
+// to full rate at once.
+//
+// The current proxy weights the time the ADC ran and the time's share of
+// processed blocks with typical ESP32 figures; it compares modes and sites,
+// it is not a measurement of the supply.
+class AdaptiveSampler {
+public:
+    AdaptiveSampler();
+
+    // 0 disables the low duty cycle (and wakes a sampler in it)
+    void setStableSeconds(uint16_t seconds);
+    uint16_t getStableSeconds() const;
+
+    // Every window's level; returns true when the duty cycle changed
+    bool addReading(float level, uint32_t timestampMs);
+    bool isLowDuty() const;
+
+    // Block accounting: processed blocks run ADC and DSP, settling blocks
+    // only the ADC, standby blocks neither
+    void countProcessed(uint32_t blocks);
+    void countSettling(uint32_t blocks);
+    void countStandby(uint32_t blocks);
+    SamplingStats getStats() const;
+
+    static constexpr uint16_t MIN_STABLE_SECONDS = 10;
+    static constexpr uint16_t MAX_STABLE_SECONDS = 3600;
+    static constexpr uint32_t LOW_DUTY_PERIOD_MS = 1000;
+    static constexpr float STABILITY_SECONDS = 5.0f;
+    static constexpr float STABLE_DEVIATION = 0.06f;  // Of the mean level
+    static constexpr float WAKE_DEVIATIONS = 4.0f;
+    // Deviation of a steady level is tiny; jumps below this fraction of the
+    // mean never wake the sampler
+    static constexpr float MIN_WAKE_DEVIATION = 0.03f;
+    static constexpr float ADC_CURRENT_MA = 5.0f;   // SAR ADC and I2S DMA running
+    static constexpr float DSP_CURRENT_MA = 15.0f;  // One core busy with the pipeline
+
+private:
+    uint16_t _stableSeconds;
+    bool _lowDuty;
+    bool _primed;
+    float _mean;
+    float _deviation;          // Smoothed |level - mean|
+    bool _stable;
+    uint32_t _stableSinceMs;
+    uint32_t _lastTimestampMs;
+    ChangeDetector _change;
+    uint32_t _wakeCount;
+
+    uint64_t _processedBlocks;
+    uint64_t _settlingBlocks;
+    uint64_t _standbyBlocks;
+
+    void wake();
+};
+
+#endif // ADAPTIVE_SAMPLER_H
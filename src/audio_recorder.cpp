@@ -0,0 +1,409 @@
+#include "audio_recorder.h"
+
+AudioRecorder::AudioRecorder()
+    : _partition(nullptr)
+    , _sectorCount(0)
+    , _mode(static_cast<uint8_t>(RecordingMode::OFF))
+    , _pendingTrigger(static_cast<uint8_t>(RecordingReason::NONE))
+    , _lastAutoTriggerMs(0)
+    , _autoTriggered(false)
+    , _nextNumber(0)
+    , _current(-1)
+    , _fill(0)
+    , _activeMode(static_cast<uint8_t>(RecordingMode::OFF))
+    , _snippet(0)
+    , _reason(RecordingReason::NONE)
+    , _postChunks(0)
+    , _dcQ8(0)
+    , _dcPrimed(false)
+    , _droppedBlocks(0)
+    , _writeSector(0)
+    , _sequence(0)
+    , _boot(0)
+    , _writtenSectors(0) {
+    for (size_t i = 0; i < CHUNK_COUNT; i++) {
+        _states[i] = FREE;
+        _numbers[i] = 0;
+    }
+}
+
+bool AudioRecorder::begin() {
+    _partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, PARTITION_SUBTYPE, PARTITION_LABEL);
+    if (!_partition) {
+        Serial.println("Audio recorder: no \"audio\" partition, recording disabled");
+        return false;
+    }
+    _sectorCount = _partition->size / SECTOR_SIZE;
+    if (_sectorCount < PRE_TRIGGER_CHUNKS + POST_TRIGGER_CHUNKS) {
+        Serial.println("Audio recorder: partition too small");
+        _partition = nullptr;
+        return false;
+    }
+
+    // The newest sector is the ring's head; snippet numbers and the boot
+    // count carry on from the newest values found
+    bool found = false;
+    uint32_t newestSector = 0;
+    SectorHeader newest = {};
+    uint16_t lastSnippet = 0;
+    for (uint32_t sector = 0; sector < _sectorCount; sector++) {
+        SectorHeader header;
+        if (readHeader(sector, header) && (!found || header.sequence > newest.sequence)) {
+            found = true;
+            newest = header;
+            newestSector = sector;
+            lastSnippet = header.snippet;
+        }
+    }
+    if (found) {
+        _writeSector = (newestSector + 1) % _sectorCount;
+        _sequence = newest.sequence + 1;
+        _boot = newest.boot + 1;
+        _snippet = lastSnippet;
+    }
+    Serial.printf("Audio recorder: %u sectors (%.0f s at %u Hz), boot %u, %u sectors written so far\n",
+                  _sectorCount, getCapacitySeconds(), SAMPLE_RATE, _boot, _sequence.load());
+    return true;
+}
+
+bool AudioRecorder::isAvailable() const {
+    return _partition != nullptr;
+}
+
+void AudioRecorder::setMode(RecordingMode mode) {
+    _mode = static_cast<uint8_t>(mode);
+}
+
+RecordingMode AudioRecorder::getMode() const {
+    return static_cast<RecordingMode>(_mode.load());
+}
+
+bool AudioRecorder::trigger(RecordingReason reason, uint32_t nowMs) {
+    if (!_partition || getMode() != RecordingMode::TRIGGERED || reason == RecordingReason::NONE) {
+        return false;
+    }
+    if (reason == RecordingReason::LEVEL_CHANGE) {
+        if (_autoTriggered && nowMs - _lastAutoTriggerMs < TRIGGER_HOLDOFF_MS) {
+            return false;
+        }
+        _autoTriggered = true;
+        _lastAutoTriggerMs = nowMs;
+    }
+    _pendingTrigger = static_cast<uint8_t>(reason);
+    return true;
+}
+
+void AudioRecorder::addBlock(const uint16_t* samples, size_t count) {
+    uint8_t mode = _mode.load();
+    if (!_partition || (mode == static_cast<uint8_t>(RecordingMode::OFF) &&
+                        _activeMode == static_cast<uint8_t>(RecordingMode::OFF))) {
+        return;
+    }
+    if (mode != _activeMode) {
+        _activeMode = mode;
+        _postChunks = 0;
+        if (mode == static_cast<uint8_t>(RecordingMode::CONTINUOUS)) {
+            startSnippet(RecordingReason::CONTINUOUS);
+        } else if (mode == static_cast<uint8_t>(RecordingMode::OFF)) {
+            // Keep what is already queued, start clean next time
+            if (_current >= 0) {
+                _states[_current] = FREE;
+                _current = -1;
+            }
+            _dcPrimed = false;
+            _decimator.reset();
+            return;
+        }
+    }
+    uint8_t reason = _pendingTrigger.exchange(static_cast<uint8_t>(RecordingReason::NONE));
+    if (reason != static_cast<uint8_t>(RecordingReason::NONE) &&
+        mode == static_cast<uint8_t>(RecordingMode::TRIGGERED)) {
+        startSnippet(static_cast<RecordingReason>(reason));
+    }
+
+    if (count > SampleSource::BLOCK_SIZE) {
+        count = SampleSource::BLOCK_SIZE;
+    }
+    memcpy(_scratch, samples, count * sizeof(uint16_t));
+    size_t outputCount = count / DECIMATION;
+    _decimator.process(_scratch, outputCount);
+
+    bool dropped = false;
+    for (size_t i = 0; i < outputCount; i++) {
+        if (_current < 0 && !acquireChunk()) {
+            dropped = true;
+            break;
+        }
+        // Bias tracked over about 128 ms; counts * 16 spans 16 bits
+        int32_t valueQ8 = static_cast<int32_t>(_scratch[i]) << 8;
+        if (!_dcPrimed) {
+            _dcQ8 = valueQ8;
+            _dcPrimed = true;
+        }
+        _dcQ8 += (valueQ8 - _dcQ8) >> 10;
+        int32_t sample = (valueQ8 - _dcQ8) >> 4;
+        sample = sample > INT16_MAX ? INT16_MAX : sample < INT16_MIN ? INT16_MIN : sample;
+        _chunks[_current].samples[_fill++] = static_cast<int16_t>(sample);
+        if (_fill >= SAMPLES_PER_SECTOR) {
+            finishChunk();
+        }
+    }
+    if (dropped) {
+        _droppedBlocks++;
+    }
+}
+
+void AudioRecorder::startSnippet(RecordingReason reason) {
+    if (_postChunks > 0 && reason != RecordingReason::CONTINUOUS) {
+        _postChunks = POST_TRIGGER_CHUNKS; // Retriggered: the snippet just runs on
+        return;
+    }
+    _snippet++;
+    _reason = reason;
+    _postChunks = reason == RecordingReason::CONTINUOUS ? 0 : POST_TRIGGER_CHUNKS;
+
+    // Pre-roll: the chunks completed just before, back to the first gap
+    uint32_t newest = _current >= 0 ? _nextNumber - 1 : _nextNumber;
+    for (uint32_t back = 1; back <= PRE_TRIGGER_CHUNKS; back++) {
+        uint32_t number = newest - back;
+        size_t index = number % CHUNK_COUNT;
+        if (_states[index].load() != HELD || _numbers[index] != number) {
+            break;
+        }
+        _chunks[index].header.snippet = _snippet;
+        _chunks[index].header.reason = static_cast<uint8_t>(reason);
+        _states[index] = PENDING;
+    }
+}
+
+bool AudioRecorder::acquireChunk() {
+    // Chunks are filled in ring order, so the next one is the oldest
+    size_t index = static_cast<size_t>(_nextNumber % CHUNK_COUNT);
+    uint8_t state = _states[index].load();
+    if (state != FREE && state != HELD) {
+        return false; // Still waiting for the writer
+    }
+    _states[index] = FILLING;
+    _numbers[index] = _nextNumber++;
+    _chunks[index].header.timestampMs = millis();
+    _current = static_cast<int>(index);
+    _fill = 0;
+    return true;
+}
+
+void AudioRecorder::finishChunk() {
+    Chunk& chunk = _chunks[_current];
+    bool keep = _activeMode == static_cast<uint8_t>(RecordingMode::CONTINUOUS) || _postChunks > 0;
+    if (keep) {
+        chunk.header.snippet = _snippet;
+        chunk.header.reason = static_cast<uint8_t>(_reason);
+        if (_postChunks > 0) {
+            _postChunks--;
+        }
+    }
+    _states[_current] = keep ? PENDING : HELD;
+    _current = -1;
+    _fill = 0;
+}
+
+size_t AudioRecorder::writePending() {
+    if (!_partition) {
+        return 0;
+    }
+    size_t written = 0;
+    for (;;) {
+        int oldest = -1;
+        for (size_t i = 0; i < CHUNK_COUNT; i++) {
+            if (_states[i].load() == PENDING &&
+                (oldest < 0 || static_cast<int32_t>(_numbers[i] - _numbers[oldest]) < 0)) {
+                oldest = static_cast<int>(i);
+            }
+        }
+        if (oldest < 0) {
+            return written;
+        }
+        _states[oldest] = WRITING;
+        Chunk& chunk = _chunks[oldest];
+        chunk.header.magic = SECTOR_MAGIC;
+        chunk.header.sequence = _sequence;
+        chunk.header.boot = _boot;
+
+        size_t offset = _writeSector * SECTOR_SIZE;
+        esp_err_t err = esp_partition_erase_range(_partition, offset, SECTOR_SIZE);
+        if (err == ESP_OK) {
+            err = esp_partition_write(_partition, offset, &chunk, SECTOR_SIZE);
+        }
+        _states[oldest] = FREE;
+        if (err != ESP_OK) {
+            Serial.printf("Audio recorder: flash write failed (%d)\n", err);
+            return written;
+        }
+        _sequence++;
+        _writeSector = (_writeSector + 1) % _sectorCount;
+        _writtenSectors++;
+        written++;
+    }
+}
+
+bool AudioRecorder::readHeader(uint32_t sector, SectorHeader& header) const {
+    return esp_partition_read(_partition, sector * SECTOR_SIZE, &header, sizeof(header)) == ESP_OK &&
+           header.magic == SECTOR_MAGIC && header.sequence != 0xFFFFFFFF;
+}
+
+size_t AudioRecorder::listRecordings(RecordingInfo* recordings, size_t maxCount) const {
+    if (!_partition || maxCount == 0) {
+        return 0;
+    }
+    // Walk back from the head; a snippet is a run of consecutive sequence
+    // numbers with one snippet number and boot
+    SectorHeader newest = {};
+    uint32_t head = _sectorCount;
+    for (uint32_t sector = 0; sector < _sectorCount; sector++) {
+        SectorHeader header;
+        if (readHeader(sector, header) && (head == _sectorCount || header.sequence > newest.sequence)) {
+            newest = header;
+            head = sector;
+        }
+    }
+    if (head == _sectorCount) {
+        return 0;
+    }
+
+    size_t count = 0;
+    RecordingInfo* current = nullptr;
+    uint32_t expectedSequence = newest.sequence;
+    for (uint32_t back = 0; back < _sectorCount; back++) {
+        uint32_t sector = (head + _sectorCount - back) % _sectorCount;
+        SectorHeader header;
+        if (!readHeader(sector, header) || header.sequence != expectedSequence) {
+            break;
+        }
+        expectedSequence--;
+        if (!current || current->snippet != header.snippet || current->boot != header.boot) {
+            if (count >= maxCount) {
+                break;
+            }
+            current = &recordings[count++];
+            current->snippet = header.snippet;
+            current->boot = header.boot;
+            current->reason = static_cast<RecordingReason>(header.reason);
+            current->sectorCount = 0;
+        }
+        current->firstSector = sector;
+        current->firstSequence = header.sequence;
+        current->startMs = header.timestampMs;
+        current->sectorCount++;
+    }
+    // The oldest snippet may have lost its start to the ring; it is still
+    // listed with what is left
+    return count;
+}
+
+bool AudioRecorder::findRecording(uint16_t snippet, RecordingInfo& recording) const {
+    RecordingInfo recordings[MAX_RECORDINGS];
+    size_t count = listRecordings(recordings, MAX_RECORDINGS);
+    for (size_t i = 0; i < count; i++) {
+        if (recordings[i].snippet == snippet) {
+            recording = recordings[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+bool AudioRecorder::findLatestRecording(RecordingInfo& recording) const {
+    return listRecordings(&recording, 1) == 1;
+}
+
+size_t AudioRecorder::getWavSize(const RecordingInfo& recording) const {
+    return WAV_HEADER_SIZE + recording.sectorCount * SAMPLES_PER_SECTOR * sizeof(int16_t);
+}
+
+void AudioRecorder::writeWavHeader(const RecordingInfo& recording, uint8_t* header) const {
+    uint32_t dataSize = static_cast<uint32_t>(getWavSize(recording) - WAV_HEADER_SIZE);
+    auto put16 = [&header](size_t at, uint16_t value) {
+        header[at] = value & 0xFF;
+        header[at + 1] = value >> 8;
+    };
+    auto put32 = [&put16](size_t at, uint32_t value) {
+        put16(at, value & 0xFFFF);
+        put16(at + 2, value >> 16);
+    };
+    memcpy(header, "RIFF", 4);
+    put32(4, dataSize + WAV_HEADER_SIZE - 8);
+    memcpy(header + 8, "WAVEfmt ", 8);
+    put32(16, 16);                          // fmt chunk size
+    put16(20, 1);                           // PCM
+    put16(22, 1);                           // Mono
+    put32(24, SAMPLE_RATE);
+    put32(28, SAMPLE_RATE * sizeof(int16_t)); // Byte rate
+    put16(32, sizeof(int16_t));             // Block align
+    put16(34, 16);                          // Bits per sample
+    memcpy(header + 36, "data", 4);
+    put32(40, dataSize);
+}
+
+size_t AudioRecorder::readWav(const RecordingInfo& recording, size_t offset, uint8_t* buffer,
+                              size_t length) const {
+    size_t total = getWavSize(recording);
+    if (!_partition || offset >= total) {
+        return 0;
+    }
+    if (length > total - offset) {
+        length = total - offset;
+    }
+
+    size_t done = 0;
+    if (offset < WAV_HEADER_SIZE) {
+        uint8_t header[WAV_HEADER_SIZE];
+        writeWavHeader(recording, header);
+        done = min(length, WAV_HEADER_SIZE - offset);
+        memcpy(buffer, header + offset, done);
+    }
+
+    // Sample data, one sector at a time; a sector the ring has reused since
+    // the listing reads as silence so the length stays as announced
+    const size_t sectorBytes = SAMPLES_PER_SECTOR * sizeof(int16_t);
+    while (done < length) {
+        size_t dataOffset = offset + done - WAV_HEADER_SIZE;
+        uint32_t k = static_cast<uint32_t>(dataOffset / sectorBytes);
+        size_t within = dataOffset % sectorBytes;
+        size_t n = min(length - done, sectorBytes - within);
+        uint32_t sector = (recording.firstSector + k) % _sectorCount;
+        SectorHeader header;
+        if (readHeader(sector, header) && header.sequence == recording.firstSequence + k) {
+            if (esp_partition_read(_partition, sector * SECTOR_SIZE + HEADER_SIZE + within,
+                                   buffer + done, n) != ESP_OK) {
+                memset(buffer + done, 0, n);
+            }
+        } else {
+            memset(buffer + done, 0, n);
+        }
+        done += n;
+    }
+    return done;
+}
+
+uint8_t AudioRecorder::getBoot() const {
+    return _boot;
+}
+
+uint32_t AudioRecorder::getSectorCount() const {
+    return _sectorCount;
+}
+
+float AudioRecorder::getCapacitySeconds() const {
+    return static_cast<float>(_sectorCount) * SAMPLES_PER_SECTOR / SAMPLE_RATE;
+}
+
+uint32_t AudioRecorder::getWrittenSectors() const {
+    return _writtenSectors.load();
+}
+
+uint32_t AudioRecorder::getDroppedBlocks() const {
+    return _droppedBlocks.load();
+}
+
+uint32_t AudioRecorder::getEraseCycles() const {
+    return _sectorCount > 0 ? _sequence.load() / _sectorCount : 0;
+}
@@ -0,0 +1,170 @@
+#ifndef AUDIO_RECORDER_H
+#define AUDIO_RECORDER_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <esp_partition.h>
+#include "sample_source.h"
+#include "decimator.h"
+
+enum class RecordingMode : uint8_t {
+    OFF,
+    TRIGGERED,   // Snippets around triggers: pre-roll from RAM, then POST_TRIGGER_CHUNKS
+    CONTINUOUS   // Everything; the flash ring holds the last getCapacitySeconds()
+};
+
+enum class RecordingReason : uint8_t {
+    NONE,
+    MANUAL,        // POST /recordings/trigger
+    LEVEL_CHANGE,  // Change point in the level
+    CONTINUOUS
+};
+
+// One snippet as found in flash: consecutive sectors of one trigger
+struct RecordingInfo {
+    uint16_t snippet;
+    uint8_t boot;          // Boot the snippet was recorded in, see getBoot()
+    RecordingReason reason;
+    uint32_t firstSector;
+    uint32_t firstSequence;
+    uint32_t sectorCount;
+    uint32_t startMs;      // millis() at the first sample in that boot
+};
+
+// Raw audio of the reference microphone, kept in a dedicated flash partition
+// for listening back to complaints.
+//
+// The sampling task hands over every analysis block (addBlock()); it is
+// decimated to 8 kHz, freed of its bias and scaled to 16 bits into RAM
+// chunks of one flash sector each. A writer task stores the chunks that
+// belong to a recording (writePending()): each is one erase and one write of
+// a whole, aligned 4 KB sector, and the sectors form a ring over the
+// partition. The sampling side never waits for flash; when the writer falls
+// behind, blocks are dropped and counted instead.
+//
+// Every sector starts with a small header (sequence, snippet, boot, time),
+// so the ring and its snippets are rebuilt from flash after a reboot and a
+// sector that was overwritten while being served is detected and sent as
+// silence. readWav() produces any byte range of a snippet as a WAV file, for
+// streaming without holding it in RAM.
+//
+// Flash wear: continuous recording erases every sector once per ring
+// capacity (about 80 s), roughly 100 000 cycles in three months, so it is
+// meant for diagnosing a venue for days, not left on. Triggered snippets
+// cost one erase per sector per capacity's worth of snippets.
+class AudioRecorder {
+public:
+    AudioRecorder();
+
+    // Finds the partition and the ring's head; false without a partition,
+    // in which case nothing is recorded
+    bool begin();
+    bool isAvailable() const;
+
+    // Any task; applied at the next block
+    void setMode(RecordingMode mode);
+    RecordingMode getMode() const;
+
+    // Any task; starts a snippet, or extends the running one. Level-change
+    // triggers closer than TRIGGER_HOLDOFF_MS to the previous one are
+    // ignored. False if nothing will be recorded for it.
+    bool trigger(RecordingReason reason, uint32_t nowMs);
+
+    // Sampling task: one analysis block of the reference microphone
+    void addBlock(const uint16_t* samples, size_t count);
+
+    // Writer task: stores completed chunks, oldest first; returns how many
+    size_t writePending();
+
+    // Any task; newest first, at most maxCount. Reads every sector header.
+    size_t listRecordings(RecordingInfo* recordings, size_t maxCount) const;
+    bool findRecording(uint16_t snippet, RecordingInfo& recording) const;
+    bool findLatestRecording(RecordingInfo& recording) const;
+
+    // Snippet as a 16-bit mono WAV file: total size and any byte range
+    size_t getWavSize(const RecordingInfo& recording) const;
+    size_t readWav(const RecordingInfo& recording, size_t offset, uint8_t* buffer, size_t length) const;
+
+    uint8_t getBoot() const;
+    uint32_t getSectorCount() const;
+    float getCapacitySeconds() const;
+    uint32_t getWrittenSectors() const;
+    uint32_t getDroppedBlocks() const;
+    // Erases per sector over the partition's life, from the sequence numbers
+    uint32_t getEraseCycles() const;
+
+    static constexpr const char* PARTITION_LABEL = "audio";
+    static constexpr esp_partition_subtype_t PARTITION_SUBTYPE = static_cast<esp_partition_subtype_t>(0x40);
+    static constexpr uint32_t DECIMATION = 4;
+    static constexpr uint32_t SAMPLE_RATE = SampleSource::SAMPLE_RATE / DECIMATION;  // 8 kHz
+    static constexpr size_t SECTOR_SIZE = 4096;
+    static constexpr size_t HEADER_SIZE = 16;
+    static constexpr size_t SAMPLES_PER_SECTOR = (SECTOR_SIZE - HEADER_SIZE) / sizeof(int16_t);
+    static constexpr size_t CHUNK_COUNT = 8;          // 32 KB of RAM, about 2 s
+    static constexpr size_t PRE_TRIGGER_CHUNKS = 4;   // About 1 s before a trigger
+    static constexpr size_t POST_TRIGGER_CHUNKS = 32; // About 8 s after it
+    static constexpr uint32_t TRIGGER_HOLDOFF_MS = 60000;
+    static constexpr size_t MAX_RECORDINGS = 32;      // Listed and found
+    static constexpr size_t WAV_HEADER_SIZE = 44;
+    static constexpr uint32_t SECTOR_MAGIC = 0x52444E53;  // "SNDR"
+    static_assert(SampleSource::BLOCK_SIZE % DECIMATION == 0, "blocks must decimate evenly");
+
+private:
+    struct SectorHeader {
+        uint32_t magic;
+        uint32_t sequence;     // Per written sector, across boots
+        uint32_t timestampMs;  // millis() at the first sample
+        uint16_t snippet;
+        uint8_t boot;
+        uint8_t reason;
+    };
+    static_assert(sizeof(SectorHeader) == HEADER_SIZE, "header must fill HEADER_SIZE");
+
+    struct Chunk {
+        SectorHeader header;
+        int16_t samples[SAMPLES_PER_SECTOR];
+    };
+    static_assert(sizeof(Chunk) == SECTOR_SIZE, "a chunk is written as one sector");
+
+    // FREE and HELD chunks may be refilled; HELD ones are kept for a
+    // trigger's pre-roll until then
+    enum ChunkState : uint8_t { FREE, FILLING, HELD, PENDING, WRITING };
+
+    const esp_partition_t* _partition;
+    uint32_t _sectorCount;
+    std::atomic<uint8_t> _mode;
+    std::atomic<uint8_t> _pendingTrigger;  // RecordingReason, NONE for none
+    uint32_t _lastAutoTriggerMs;
+    bool _autoTriggered;
+
+    // Sampling task
+    Chunk _chunks[CHUNK_COUNT];
+    std::atomic<uint8_t> _states[CHUNK_COUNT];
+    uint32_t _numbers[CHUNK_COUNT];  // Fill order, to write oldest first
+    uint32_t _nextNumber;
+    int _current;                    // Chunk being filled, -1 while none is free
+    size_t _fill;
+    uint8_t _activeMode;
+    uint16_t _snippet;
+    RecordingReason _reason;
+    size_t _postChunks;              // Still to record for the running trigger
+    int32_t _dcQ8;                   // Bias in ADC counts, 8 fraction bits
+    bool _dcPrimed;
+    uint16_t _scratch[SampleSource::BLOCK_SIZE];
+    CicDecimator<DECIMATION> _decimator;
+    std::atomic<uint32_t> _droppedBlocks;
+
+    // Writer task
+    uint32_t _writeSector;
+    std::atomic<uint32_t> _sequence;
+    uint8_t _boot;
+    std::atomic<uint32_t> _writtenSectors;
+
+    void startSnippet(RecordingReason reason);
+    bool acquireChunk();
+    void finishChunk();
+    bool readHeader(uint32_t sector, SectorHeader& header) const;
+    void writeWavHeader(const RecordingInfo& recording, uint8_t* header) const;
+};
+
+#endif // AUDIO_RECORDER_H
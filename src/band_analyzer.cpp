@@ -0,0 +1,228 @@
+#include "band_analyzer.h"
+#include "leq_meter.h"
+
+namespace {
+
+constexpr size_t N = BandAnalyzer::FFT_SIZE;
+constexpr int WINDOW_BITS = 15;
+constexpr int INPUT_SHIFT = 8;  // x * w >> 8 keeps 12-bit samples within +-2^18
+constexpr size_t OCTAVE_BANDS = 8;
+constexpr size_t THIRD_OCTAVE_BANDS = 22;
+
+// Periodic Hann window in Q15, first half only (w[N - n] = w[n])
+struct HannTable {
+    uint16_t values[N / 2 + 1];
+};
+
+constexpr HannTable makeHann() {
+    HannTable table = {};
+    for (size_t n = 0; n <= N / 2; n++) {
+        double w = 0.5 * (1.0 - constexprCos(2.0 * CONSTEXPR_PI * n / N));
+        table.values[n] = static_cast<uint16_t>(w * (1 << WINDOW_BITS) + 0.5);
+    }
+    return table;
+}
+
+constexpr HannTable HANN = makeHann();
+
+// Sum of squared window values, for converting bin power back to mean square
+constexpr double hannEnergy() {
+    double sum = 0.0;
+    for (size_t n = 0; n < N; n++) {
+        double w = HANN.values[n <= N / 2 ? n : N - n] / static_cast<double>(1 << WINDOW_BITS);
+        sum += w * w;
+    }
+    return sum;
+}
+
+// Bins [first, end) whose centre frequency lies within [lowHz, highHz)
+struct BinRange {
+    uint16_t first;
+    uint16_t end;
+};
+
+constexpr BinRange binRange(double lowHz, double highHz) {
+    double bin = SampleSource::SAMPLE_RATE / static_cast<double>(N);
+    uint16_t first = static_cast<uint16_t>(lowHz / bin);
+    if (first * bin < lowHz) {
+        first++;
+    }
+    uint16_t end = static_cast<uint16_t>(highHz / bin);
+    if (end * bin < highHz) {
+        end++;
+    }
+    if (end <= first) {
+        end = first + 1;  // Narrow low bands get the nearest bin
+    }
+    if (end > N / 2) {
+        end = N / 2;
+    }
+    return BinRange{first, end};
+}
+
+// 2^(x / 6) for integer x, exact enough for band edges
+constexpr double twoPowSixths(int sixths) {
+    constexpr double SIXTH = 1.122462048309373;  // 2^(1/6)
+    double value = 1.0;
+    for (int i = 0; i < (sixths < 0 ? -sixths : sixths); i++) {
+        value = sixths < 0 ? value / SIXTH : value * SIXTH;
+    }
+    return value;
+}
+
+struct BandTable {
+    float centerHz[BandAnalyzer::MAX_BANDS];
+    BinRange bins[BandAnalyzer::MAX_BANDS];
+};
+
+// Base-two bands per IEC 61260 around 1 kHz: octaves at 2^n, thirds at 2^(n/3),
+// edges half a band either side of the centre
+constexpr BandTable makeBands(size_t count, int stepSixths, int firstSixths) {
+    BandTable table = {};
+    for (size_t i = 0; i < count; i++) {
+        int centerSixths = firstSixths + static_cast<int>(i) * stepSixths;
+        double center = 1000.0 * twoPowSixths(centerSixths);
+        table.centerHz[i] = static_cast<float>(center);
+        table.bins[i] = binRange(1000.0 * twoPowSixths(centerSixths - stepSixths / 2),
+                                 1000.0 * twoPowSixths(centerSixths + stepSixths / 2));
+    }
+    return table;
+}
+
+constexpr BandTable OCTAVE_TABLE = makeBands(OCTAVE_BANDS, 6, -24);         // 62.5 Hz - 8 kHz
+constexpr BandTable THIRD_OCTAVE_TABLE = makeBands(THIRD_OCTAVE_BANDS, 2, -24); // 63 Hz - 8 kHz
+constexpr BinRange SPEECH_BINS = binRange(BandAnalyzer::SPEECH_LOW_HZ, BandAnalyzer::SPEECH_HIGH_HZ);
+
+static_assert(OCTAVE_TABLE.bins[OCTAVE_BANDS - 1].end <= N / 2, "octave bands exceed Nyquist");
+static_assert(THIRD_OCTAVE_TABLE.bins[THIRD_OCTAVE_BANDS - 1].end <= N / 2,
+              "third-octave bands exceed Nyquist");
+
+// One-sided bin power sum -> mean square in ADC counts^2 (Parseval)
+constexpr float POWER_TO_MEAN_SQUARE = static_cast<float>(
+    2.0 / (N * hannEnergy() * (1u << (2 * (WINDOW_BITS - INPUT_SHIFT)))));
+
+// Mean square of a full-scale sine in ADC counts^2 (2048^2 / 2)
+constexpr float FULL_SCALE_MEAN_SQUARE = 2097152.0f;
+
+const BandTable* tableFor(BandMode mode) {
+    return mode == BandMode::OCTAVE ? &OCTAVE_TABLE
+         : mode == BandMode::THIRD_OCTAVE ? &THIRD_OCTAVE_TABLE
+         : nullptr;
+}
+
+float binRangePower(const int32_t* spectrum, BinRange range) {
+    float sum = 0.0f;
+    for (size_t k = range.first; k < range.end; k++) {
+        float re = static_cast<float>(spectrum[2 * k]);
+        float im = static_cast<float>(spectrum[2 * k + 1]);
+        sum += re * re + im * im;
+    }
+    return sum;
+}
+
+} // namespace
+
+BandAnalyzer::BandAnalyzer()
+    : _mode(BandMode::OFF)
+    , _history()
+    , _historyHead(0)
+    , _historyFilled(0)
+    , _work()
+    , _bandPower()
+    , _speechPower(0)
+    , _frames(0) {
+}
+
+void BandAnalyzer::setMode(BandMode mode) {
+    if (mode == _mode) {
+        return;
+    }
+    _mode = mode;
+    _historyHead = 0;
+    _historyFilled = 0;
+    for (size_t i = 0; i < MAX_BANDS; i++) {
+        _bandPower[i] = 0;
+    }
+    _speechPower = 0;
+    _frames = 0;
+}
+
+BandMode BandAnalyzer::getMode() const {
+    return _mode;
+}
+
+bool BandAnalyzer::isEnabled() const {
+    return _mode != BandMode::OFF;
+}
+
+size_t BandAnalyzer::getBandCount() const {
+    return getBandCount(_mode);
+}
+
+size_t BandAnalyzer::getBandCount(BandMode mode) {
+    return mode == BandMode::OCTAVE ? OCTAVE_BANDS
+         : mode == BandMode::THIRD_OCTAVE ? THIRD_OCTAVE_BANDS
+         : 0;
+}
+
+float BandAnalyzer::getBandCenter(BandMode mode, size_t band) {
+    const BandTable* table = tableFor(mode);
+    if (table == nullptr || band >= getBandCount(mode)) {
+        return 0.0f;
+    }
+    return table->centerHz[band];
+}
+
+void BandAnalyzer::addBlock(const uint16_t* samples, size_t count, int32_t dcOffset) {
+    if (_mode == BandMode::OFF) {
+        return;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        _history[_historyHead] = static_cast<int16_t>(static_cast<int32_t>(samples[i]) - dcOffset);
+        _historyHead = (_historyHead + 1) & (FFT_SIZE - 1);
+    }
+    _historyFilled += count;
+    if (_historyFilled < FFT_SIZE) {
+        return;
+    }
+    _historyFilled = FFT_SIZE;
+    analyzeFrame();
+}
+
+void BandAnalyzer::analyzeFrame() {
+    // Oldest sample first; _historyHead points at it once the ring is full
+    for (size_t n = 0; n < FFT_SIZE; n++) {
+        int32_t x = _history[(_historyHead + n) & (FFT_SIZE - 1)];
+        int32_t w = HANN.values[n <= FFT_SIZE / 2 ? n : FFT_SIZE - n];
+        _work[n] = (x * w) >> INPUT_SHIFT;
+    }
+
+    FixedFft<FFT_SIZE>::forward(_work);
+
+    const BandTable* table = tableFor(_mode);
+    size_t bands = getBandCount();
+    for (size_t b = 0; b < bands; b++) {
+        _bandPower[b] += binRangePower(_work, table->bins[b]);
+    }
+    _speechPower += binRangePower(_work, SPEECH_BINS);
+    _frames++;
+}
+
+bool BandAnalyzer::finishWindow(float* bandDbfs, float& speechMeanSquare) {
+    if (_frames == 0) {
+        return false;
+    }
+
+    float scale = POWER_TO_MEAN_SQUARE / _frames;
+    size_t bands = getBandCount();
+    for (size_t b = 0; b < bands; b++) {
+        float db = powerToDb(_bandPower[b] * scale / FULL_SCALE_MEAN_SQUARE);
+        bandDbfs[b] = db < LeqMeter::MIN_DBFS ? LeqMeter::MIN_DBFS : db;
+        _bandPower[b] = 0;
+    }
+    speechMeanSquare = _speechPower * scale;
+    _speechPower = 0;
+    _frames = 0;
+    return true;
+}
@@ -0,0 +1,65 @@
+#ifndef BAND_ANALYZER_H
+#define BAND_ANALYZER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "fixed_fft.h"
+#include "sample_source.h"
+
+enum class BandMode : uint8_t {
+    OFF = 0,
+    OCTAVE = 1,        // 8 bands, 63 Hz - 8 kHz
+    THIRD_OCTAVE = 2   // 22 bands, 63 Hz - 8 kHz
+};
+
+// Octave / third-octave band energies from a Hann-windowed 2048-point
+// fixed-point FFT, re-run on every 512-sample block (75% overlap).
+//
+// Per-block budget on the ESP32 at 240 MHz, estimated from operation
+// counts: ~11k 32x32->64 multiplies for the FFT plus 1024 float magnitudes,
+// roughly 0.3-0.4 ms of the 16 ms block period (about 2-3% of one core).
+// RAM: 4 KB sample history, 8 KB FFT work buffer and the band accumulators;
+// twiddle, window and band tables are compile-time constants in flash.
+//
+// At 32 kHz the bin spacing is 15.6 Hz, so the lowest third-octave bands
+// are only one or two bins wide and Hann leakage spreads a tone across
+// neighbouring bands there; from about 200 Hz up band levels are exact.
+class BandAnalyzer {
+public:
+    BandAnalyzer();
+
+    void setMode(BandMode mode);
+    BandMode getMode() const;
+    bool isEnabled() const;
+    size_t getBandCount() const;
+    static size_t getBandCount(BandMode mode);
+    static float getBandCenter(BandMode mode, size_t band);
+
+    // Adds one block of raw ADC samples, minus the tracked DC offset, and
+    // analyzes the latest FFT_SIZE samples; does nothing while off
+    void addBlock(const uint16_t* samples, size_t count, int32_t dcOffset);
+
+    // Averages the frames since the last call into dBFS per band and the mean
+    // square of the speech band (counts^2), then starts a new accumulation.
+    // Returns false if no frame was analyzed.
+    bool finishWindow(float* bandDbfs, float& speechMeanSquare);
+
+    static constexpr size_t FFT_SIZE = 2048;
+    static constexpr size_t MAX_BANDS = 22;
+    static constexpr float SPEECH_LOW_HZ = 355.0f;   // Lower edge of the 500 Hz octave
+    static constexpr float SPEECH_HIGH_HZ = 5657.0f; // Upper edge of the 4 kHz octave
+
+private:
+    BandMode _mode;
+    int16_t _history[FFT_SIZE];
+    size_t _historyHead;
+    size_t _historyFilled;
+    int32_t _work[FFT_SIZE];
+    float _bandPower[MAX_BANDS];
+    float _speechPower;
+    uint32_t _frames;
+
+    void analyzeFrame();
+};
+
+#endif // BAND_ANALYZER_H
@@ -1,5 +1,8 @@
 #include "captive_portal.h"
 #include <IPAddress.h>
+#include "transient_filter.h"
+#include "sound_sensor.h"
+#include "volume_controller.h"
 
 CaptivePortal::CaptivePortal(WiFiManager& wifiManager, APIClient& apiClient,
                            AsyncWebServer& webServer, DNSServer& dnsServer)
@@ -8,7 +11,8 @@ CaptivePortal::CaptivePortal(WiFiManager& wifiManager, APIClient& apiClient,
     , _webServer(webServer)
     , _dnsServer(dnsServer)
     , _isConfigured(false)
-    , _dnsServerStarted(false) {
+    , _dnsServerStarted(false)
+    , _audioRecorder(nullptr) {
 }
 
 bool CaptivePortal::begin() {
@@ -135,6 +139,39 @@ bool CaptivePortal::setupServerRoutes() {
     _webServer.on("/get-stored-config", HTTP_GET, [this](AsyncWebServerRequest *request) {
         handleGetStoredConfig(request);
     });
+
+    _webServer.on("/status", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        handleGetStatus(request);
+    });
+
+    _webServer.on("/calibrate", HTTP_POST, [this](AsyncWebServerRequest *request) {
+        handleCalibrate(request);
+    });
+
+    _webServer.on("/calibration", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        handleGetCalibration(request);
+    });
+
+    _webServer.on("/schedule", HTTP_POST, [this](AsyncWebServerRequest *request) {
+        handleSetSchedule(request);
+    });
+
+    _webServer.on("/schedule", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        handleGetSchedule(request);
+    });
+
+    // Sub-paths first: a route also matches the paths below it
+    _webServer.on("/recordings/audio", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        handleGetRecordingAudio(request);
+    });
+
+    _webServer.on("/recordings/trigger", HTTP_POST, [this](AsyncWebServerRequest *request) {
+        handleTriggerRecording(request);
+    });
+
+    _webServer.on("/recordings", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        handleGetRecordings(request);
+    });
     
     return true;
 }
@@ -231,6 +268,38 @@ void CaptivePortal::handleGetStoredConfig(AsyncWebServerRequest *request) {
         int sensitivity = _wifiManager.getSensitivity();
         doc["sensitivity"] = sensitivity;
         Serial.printf("Current sensitivity: %d\n", sensitivity);
+
+        // Sound metering settings
+        doc["calibration-offset"] = _wifiManager.getCalibrationOffset();
+        static const char* const levelModeNames[] = {"peak", "leq", "speech"};
+        uint8_t levelMode = _wifiManager.getLevelMode();
+        doc["level-mode"] = levelMode < 3 ? levelModeNames[levelMode] : "peak";
+        static const char* const weightingNames[] = {"Z", "A", "C"};
+        uint8_t weighting = _wifiManager.getWeighting();
+        doc["weighting"] = weighting < 3 ? weightingNames[weighting] : "A";
+        static const char* const bandModeNames[] = {"off", "octave", "third"};
+        uint8_t bandMode = _wifiManager.getBandMode();
+        doc["band-mode"] = bandMode < 3 ? bandModeNames[bandMode] : "off";
+        doc["transient-window"] = _wifiManager.getTransientWindow();
+        doc["transient-threshold"] = _wifiManager.getTransientThreshold();
+        static const char* const aggregationNames[] = {"mean", "max", "weighted"};
+        uint8_t aggregation = _wifiManager.getChannelAggregation();
+        doc["channel-aggregation"] = aggregation < 3 ? aggregationNames[aggregation] : "mean";
+        float weights[SampleSource::CHANNELS];
+        String weightList;
+        bool haveWeights = _wifiManager.loadChannelWeights(weights, SampleSource::CHANNELS);
+        for (size_t i = 0; i < SampleSource::CHANNELS; i++) {
+            if (i > 0) {
+                weightList += ",";
+            }
+            weightList += String(haveWeights ? weights[i] : 1.0f, 2);
+        }
+        doc["channel-weights"] = weightList;
+        doc["adaptive-sampling"] = _wifiManager.getAdaptiveSampling();
+        doc["override-hold"] = _wifiManager.getOverrideHold();
+        static const char* const recordingModeNames[] = {"off", "triggered", "continuous"};
+        uint8_t recordingMode = _wifiManager.getRecordingMode();
+        doc["recording-mode"] = recordingMode < 3 ? recordingModeNames[recordingMode] : "triggered";
         
         // Add API connection status if credentials exist
         if (_apiClient.hasValidCredentials()) {
@@ -257,6 +326,10 @@ void CaptivePortal::handleSave(AsyncWebServerRequest *request) {
     String ssid, password, apiUrl, clientId, clientSecret, soundZoneId;
     int sensitivity = 50; // Default value
     bool sensitivityFound = false;
+    String calibrationOffset, levelMode, weighting, bandMode;
+    String transientWindow, transientThreshold;
+    String channelAggregation, channelWeights;
+    String adaptiveSampling, recordingMode, overrideHold;
     
     // Get all parameters
     for (size_t i = 0; i < request->params(); i++) {
@@ -273,6 +346,17 @@ void CaptivePortal::handleSave(AsyncWebServerRequest *request) {
                 sensitivityFound = true;
                 Serial.printf("Received sensitivity value: %d\n", sensitivity);
             }
+            else if (p->name() == "calibration-offset") calibrationOffset = p->value();
+            else if (p->name() == "level-mode") levelMode = p->value();
+            else if (p->name() == "weighting") weighting = p->value();
+            else if (p->name() == "band-mode") bandMode = p->value();
+            else if (p->name() == "transient-window") transientWindow = p->value();
+            else if (p->name() == "transient-threshold") transientThreshold = p->value();
+            else if (p->name() == "channel-aggregation") channelAggregation = p->value();
+            else if (p->name() == "channel-weights") channelWeights = p->value();
+            else if (p->name() == "adaptive-sampling") adaptiveSampling = p->value();
+            else if (p->name() == "recording-mode") recordingMode = p->value();
+            else if (p->name() == "override-hold") overrideHold = p->value();
         }
     }
     
@@ -311,6 +395,88 @@ void CaptivePortal::handleSave(AsyncWebServerRequest *request) {
         } else {
             Serial.println("No sensitivity value in request");
         }
+
+        // Optional sound metering settings
+        if (calibrationOffset.length() > 0) {
+            float offsetDb = calibrationOffset.toFloat();
+            if (offsetDb >= -200.0f && offsetDb <= 200.0f) {
+                _wifiManager.storeCalibrationOffset(offsetDb);
+            } else {
+                Serial.println("Invalid calibration offset received");
+            }
+        }
+        if (levelMode == "peak" || levelMode == "leq" || levelMode == "speech") {
+            _wifiManager.storeLevelMode(levelMode == "peak" ? 0 : levelMode == "leq" ? 1 : 2);
+        }
+        if (weighting == "Z" || weighting == "A" || weighting == "C") {
+            _wifiManager.storeWeighting(weighting == "Z" ? 0 : weighting == "A" ? 1 : 2);
+        }
+        if (bandMode == "off" || bandMode == "octave" || bandMode == "third") {
+            _wifiManager.storeBandMode(bandMode == "off" ? 0 : bandMode == "octave" ? 1 : 2);
+        }
+        if (transientWindow.length() > 0 || transientThreshold.length() > 0) {
+            long window = transientWindow.length() > 0 ? transientWindow.toInt()
+                                                       : _wifiManager.getTransientWindow();
+            float threshold = transientThreshold.length() > 0 ? transientThreshold.toFloat()
+                                                              : _wifiManager.getTransientThreshold();
+            if (window >= 0 && HampelFilter::isValidWindow(static_cast<size_t>(window)) &&
+                HampelFilter::isValidThreshold(threshold)) {
+                _wifiManager.storeTransientFilter(static_cast<uint8_t>(window), threshold);
+            } else {
+                Serial.println("Invalid transient filter settings received");
+            }
+        }
+        if (channelAggregation == "mean" || channelAggregation == "max" || channelAggregation == "weighted") {
+            _wifiManager.storeChannelAggregation(channelAggregation == "mean" ? 0
+                                                 : channelAggregation == "max" ? 1 : 2);
+        }
+        if (channelWeights.length() > 0) {
+            // One comma-separated weight per microphone
+            float weights[SampleSource::CHANNELS];
+            size_t count = 0;
+            bool valid = true;
+            int start = 0;
+            while (valid && start <= static_cast<int>(channelWeights.length())) {
+                int comma = channelWeights.indexOf(',', start);
+                String item = channelWeights.substring(start, comma < 0 ? channelWeights.length() : comma);
+                item.trim();
+                float weight = item.toFloat();
+                valid = count < SampleSource::CHANNELS && item.length() > 0 &&
+                        weight >= 0 && weight <= SoundSensor::MAX_CHANNEL_WEIGHT;
+                if (valid) {
+                    weights[count++] = weight;
+                }
+                if (comma < 0) {
+                    break;
+                }
+                start = comma + 1;
+            }
+            if (valid && count == SampleSource::CHANNELS) {
+                _wifiManager.storeChannelWeights(weights, count);
+            } else {
+                Serial.println("Invalid channel weights received");
+            }
+        }
+        if (adaptiveSampling.length() > 0) {
+            long seconds = adaptiveSampling.toInt();
+            if (seconds == 0 || (seconds >= AdaptiveSampler::MIN_STABLE_SECONDS &&
+                                 seconds <= AdaptiveSampler::MAX_STABLE_SECONDS)) {
+                _wifiManager.storeAdaptiveSampling(static_cast<uint16_t>(seconds));
+            } else {
+                Serial.println("Invalid adaptive sampling time received");
+            }
+        }
+        if (overrideHold.length() > 0) {
+            long minutes = overrideHold.toInt();
+            if (minutes >= 0 && minutes <= static_cast<long>(VolumeController::MAX_OVERRIDE_HOLD_MS / 60000)) {
+                _wifiManager.storeOverrideHold(static_cast<uint16_t>(minutes));
+            } else {
+                Serial.println("Invalid override hold time received");
+            }
+        }
+        if (recordingMode == "off" || recordingMode == "triggered" || recordingMode == "continuous") {
+            _wifiManager.storeRecordingMode(recordingMode == "off" ? 0 : recordingMode == "triggered" ? 1 : 2);
+        }
         
         _isConfigured = true;
         
@@ -330,6 +496,227 @@ void CaptivePortal::handleSave(AsyncWebServerRequest *request) {
     }
 }
 
+void CaptivePortal::setStatusCallback(StatusCallback callback) {
+    _statusCallback = callback;
+}
+
+void CaptivePortal::handleGetStatus(AsyncWebServerRequest *request) {
+    DynamicJsonDocument doc(MAX_STATUS_SIZE);
+    doc["uptime-ms"] = millis();
+    doc["free-heap"] = ESP.getFreeHeap();
+    if (_statusCallback) {
+        _statusCallback(doc);
+    }
+
+    String response;
+    serializeJson(doc, response);
+
+    AsyncWebServerResponse *webResponse = request->beginResponse(200, "application/json", response);
+    addCORSHeaders(webResponse);
+    request->send(webResponse);
+}
+
+void CaptivePortal::setCalibrationCallbacks(CalibrationCallback request, StatusCallback progress) {
+    _calibrationCallback = request;
+    _calibrationStatusCallback = progress;
+}
+
+void CaptivePortal::handleCalibrate(AsyncWebServerRequest *request) {
+    CalibrationRequest calibration = {CalibrationAction::NONE, VenueCalibration::DEFAULT_SECONDS, -1, -1};
+    String phase = request->hasParam("phase", true) ? request->getParam("phase", true)->value() : "";
+    if (phase == "quiet") calibration.action = CalibrationAction::MEASURE_QUIET;
+    else if (phase == "busy") calibration.action = CalibrationAction::MEASURE_BUSY;
+    else if (phase == "cancel") calibration.action = CalibrationAction::CANCEL;
+    else if (phase == "clear") calibration.action = CalibrationAction::CLEAR;
+    else {
+        request->send(400, "text/plain", "phase must be quiet, busy, cancel or clear");
+        return;
+    }
+
+    if (request->hasParam("duration", true)) {
+        long seconds = request->getParam("duration", true)->value().toInt();
+        if (seconds < VenueCalibration::MIN_SECONDS || seconds > VenueCalibration::MAX_SECONDS) {
+            request->send(400, "text/plain", "Invalid duration");
+            return;
+        }
+        calibration.seconds = static_cast<uint16_t>(seconds);
+    }
+    const char* const volumeParams[] = {"quiet-volume", "busy-volume"};
+    int* const volumes[] = {&calibration.quietVolume, &calibration.busyVolume};
+    for (size_t i = 0; i < 2; i++) {
+        if (request->hasParam(volumeParams[i], true)) {
+            long volume = request->getParam(volumeParams[i], true)->value().toInt();
+            if (volume < 0 || volume > VolumeController::MAX_VOLUME) {
+                request->send(400, "text/plain", "Invalid volume");
+                return;
+            }
+            *volumes[i] = static_cast<int>(volume);
+        }
+    }
+
+    if (!_calibrationCallback || !_calibrationCallback(calibration)) {
+        request->send(503, "text/plain", "Calibration is not available now");
+        return;
+    }
+    AsyncWebServerResponse *response = request->beginResponse(200, "text/plain", "Calibration request accepted");
+    addCORSHeaders(response);
+    request->send(response);
+}
+
+void CaptivePortal::handleGetCalibration(AsyncWebServerRequest *request) {
+    DynamicJsonDocument doc(MAX_CONFIG_SIZE);
+    if (_calibrationStatusCallback) {
+        _calibrationStatusCallback(doc);
+    }
+
+    String response;
+    serializeJson(doc, response);
+
+    AsyncWebServerResponse *webResponse = request->beginResponse(200, "application/json", response);
+    addCORSHeaders(webResponse);
+    request->send(webResponse);
+}
+
+void CaptivePortal::setScheduleCallbacks(ScheduleCallback request, StatusCallback status) {
+    _scheduleCallback = request;
+    _scheduleStatusCallback = status;
+}
+
+void CaptivePortal::handleSetSchedule(AsyncWebServerRequest *request) {
+    ScheduleRequest schedule = {};
+    if (request->hasParam("rules", true)) {
+        size_t count, errorRule;
+        if (!VolumeSchedule::parseRules(request->getParam("rules", true)->value().c_str(), schedule.rules,
+                                        VolumeSchedule::MAX_RULES, count, errorRule)) {
+            String message = errorRule > VolumeSchedule::MAX_RULES
+                ? "At most " + String(VolumeSchedule::MAX_RULES) + " rules"
+                : "Invalid rule " + String(errorRule);
+            request->send(400, "text/plain", message);
+            return;
+        }
+        schedule.setRules = true;
+        schedule.ruleCount = static_cast<uint8_t>(count);
+    }
+    if (request->hasParam("timezone", true)) {
+        const String& timezone = request->getParam("timezone", true)->value();
+        if (timezone.length() == 0 || timezone.length() > VolumeSchedule::MAX_TIMEZONE_LENGTH) {
+            request->send(400, "text/plain", "Invalid timezone");
+            return;
+        }
+        strlcpy(schedule.timezone, timezone.c_str(), sizeof(schedule.timezone));
+        schedule.setTimezone = true;
+    }
+    if (!schedule.setRules && !schedule.setTimezone) {
+        request->send(400, "text/plain", "rules or timezone required");
+        return;
+    }
+
+    if (!_scheduleCallback || !_scheduleCallback(schedule)) {
+        request->send(503, "text/plain", "Schedule is not available now");
+        return;
+    }
+    AsyncWebServerResponse *response = request->beginResponse(200, "text/plain", "Schedule saved");
+    addCORSHeaders(response);
+    request->send(response);
+}
+
+void CaptivePortal::handleGetSchedule(AsyncWebServerRequest *request) {
+    DynamicJsonDocument doc(MAX_SCHEDULE_SIZE);
+    if (_scheduleStatusCallback) {
+        _scheduleStatusCallback(doc);
+    }
+
+    String response;
+    serializeJson(doc, response);
+
+    AsyncWebServerResponse *webResponse = request->beginResponse(200, "application/json", response);
+    addCORSHeaders(webResponse);
+    request->send(webResponse);
+}
+
+void CaptivePortal::setAudioRecorder(AudioRecorder* recorder) {
+    _audioRecorder = recorder;
+}
+
+void CaptivePortal::handleGetRecordings(AsyncWebServerRequest *request) {
+    if (!_audioRecorder || !_audioRecorder->isAvailable()) {
+        request->send(503, "text/plain", "Audio recorder is not available");
+        return;
+    }
+    static const char* const modeNames[] = {"off", "triggered", "continuous"};
+    static const char* const reasonNames[] = {"none", "manual", "level-change", "continuous"};
+    DynamicJsonDocument doc(MAX_RECORDINGS_SIZE);
+    doc["mode"] = modeNames[static_cast<uint8_t>(_audioRecorder->getMode())];
+    doc["sample-rate"] = AudioRecorder::SAMPLE_RATE;
+    doc["capacity-seconds"] = _audioRecorder->getCapacitySeconds();
+    doc["sectors-written"] = _audioRecorder->getWrittenSectors();
+    doc["dropped-blocks"] = _audioRecorder->getDroppedBlocks();
+    doc["erase-cycles"] = _audioRecorder->getEraseCycles();
+
+    RecordingInfo recordings[AudioRecorder::MAX_RECORDINGS];
+    size_t count = _audioRecorder->listRecordings(recordings, AudioRecorder::MAX_RECORDINGS);
+    JsonArray list = doc.createNestedArray("recordings");
+    for (size_t i = 0; i < count; i++) {
+        const RecordingInfo& recording = recordings[i];
+        JsonObject item = list.createNestedObject();
+        item["snippet"] = recording.snippet;
+        uint8_t reason = static_cast<uint8_t>(recording.reason);
+        item["reason"] = reason < 4 ? reasonNames[reason] : "none";
+        item["seconds"] = static_cast<float>(recording.sectorCount) * AudioRecorder::SAMPLES_PER_SECTOR /
+                          AudioRecorder::SAMPLE_RATE;
+        // Times of earlier boots mean nothing now
+        if (recording.boot == _audioRecorder->getBoot()) {
+            item["age-seconds"] = (millis() - recording.startMs) / 1000;
+        } else {
+            item["earlier-boot"] = true;
+        }
+    }
+
+    String response;
+    serializeJson(doc, response);
+
+    AsyncWebServerResponse *webResponse = request->beginResponse(200, "application/json", response);
+    addCORSHeaders(webResponse);
+    request->send(webResponse);
+}
+
+void CaptivePortal::handleGetRecordingAudio(AsyncWebServerRequest *request) {
+    if (!_audioRecorder || !_audioRecorder->isAvailable()) {
+        request->send(503, "text/plain", "Audio recorder is not available");
+        return;
+    }
+    RecordingInfo recording;
+    bool found = request->hasParam("snippet")
+        ? _audioRecorder->findRecording(static_cast<uint16_t>(request->getParam("snippet")->value().toInt()),
+                                        recording)
+        : _audioRecorder->findLatestRecording(recording);
+    if (!found) {
+        request->send(404, "text/plain", "No such recording");
+        return;
+    }
+
+    // Streamed straight from flash, one TCP window at a time
+    AudioRecorder* recorder = _audioRecorder;
+    AsyncWebServerResponse *response = request->beginResponse("audio/wav", recorder->getWavSize(recording),
+        [recorder, recording](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+            return recorder->readWav(recording, index, buffer, maxLen);
+        });
+    response->addHeader("Content-Disposition",
+                        "attachment; filename=\"snippet-" + String(recording.snippet) + ".wav\"");
+    addCORSHeaders(response);
+    request->send(response);
+}
+
+void CaptivePortal::handleTriggerRecording(AsyncWebServerRequest *request) {
+    if (!_audioRecorder || !_audioRecorder->trigger(RecordingReason::MANUAL, millis())) {
+        request->send(503, "text/plain", "Recording is not in triggered mode");
+        return;
+    }
+    AsyncWebServerResponse *response = request->beginResponse(202, "text/plain", "Recording a snippet");
+    addCORSHeaders(response);
+    request->send(response);
+}
+
 void CaptivePortal::handleGetSensitivity(AsyncWebServerRequest *request) {
     int sensitivity = _wifiManager.getSensitivity();
     Serial.printf("Returning current sensitivity value: %d\n", sensitivity);
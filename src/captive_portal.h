@@ -7,23 +7,48 @@
 #include <AsyncTCP.h>
 #include <SPIFFS.h>
 #include <ArduinoJson.h>
+#include <functional>
 #include "wifi_manager.h"
 #include "api_client.h"
+#include "sample_source.h"
+#include "venue_calibration.h"
+#include "audio_recorder.h"
+#include "volume_schedule.h"
+#include "preference_learner.h"
 
 class CaptivePortal {
 public:
+    // Fills the /status response; called on the AsyncTCP task
+    using StatusCallback = std::function<void(JsonDocument&)>;
+    // Venue calibration: queue a request (false if it cannot be taken now)
+    // and fill the /calibration progress response; both on the AsyncTCP task
+    using CalibrationCallback = std::function<bool(const CalibrationRequest&)>;
+    // Volume schedule: queue new rules or timezone, and fill /schedule
+    using ScheduleCallback = std::function<bool(const ScheduleRequest&)>;
+
     CaptivePortal(WiFiManager& wifiManager, APIClient& apiClient,
                  AsyncWebServer& webServer, DNSServer& dnsServer);
     
     bool begin();
     void handleClient();
     bool isConfigured();
+    void setStatusCallback(StatusCallback callback);
+    void setCalibrationCallbacks(CalibrationCallback request, StatusCallback progress);
+    void setScheduleCallbacks(ScheduleCallback request, StatusCallback status);
+    // Serves /recordings; without one those routes answer 503
+    void setAudioRecorder(AudioRecorder* recorder);
     
     // Constants
     static constexpr int DNS_PORT = 53;
     static constexpr const char* AP_REDIRECT_URL = "http://192.168.4.1/";
     static constexpr size_t MAX_CONFIG_SIZE = 1024;
+    // Base status, the recent manual volume changes and one "channels" entry
+    // per extra microphone
+    static constexpr size_t MAX_STATUS_SIZE = 2048 + 80 * PreferenceLearner::MAX_RECENT +
+                                              192 * (SampleSource::CHANNELS - 1);
     static constexpr uint32_t RESTART_DELAY = 1000;
+    static constexpr size_t MAX_RECORDINGS_SIZE = 512 + 160 * AudioRecorder::MAX_RECORDINGS;
+    static constexpr size_t MAX_SCHEDULE_SIZE = 512 + 96 * VolumeSchedule::MAX_RULES;
 
 private:
     WiFiManager& _wifiManager;
@@ -34,6 +59,12 @@ private:
     bool _dnsServerStarted;
     bool _needsRestart;
     unsigned long _restartTime;
+    StatusCallback _statusCallback;
+    CalibrationCallback _calibrationCallback;
+    StatusCallback _calibrationStatusCallback;
+    ScheduleCallback _scheduleCallback;
+    StatusCallback _scheduleStatusCallback;
+    AudioRecorder* _audioRecorder;
 
     // Request handlers
     void handleRoot(AsyncWebServerRequest *request);
@@ -41,6 +72,14 @@ private:
     void handleGetSensitivity(AsyncWebServerRequest *request);
     void handleTestConnection(AsyncWebServerRequest *request);
     void handleGetStoredConfig(AsyncWebServerRequest *request);
+    void handleGetStatus(AsyncWebServerRequest *request);
+    void handleCalibrate(AsyncWebServerRequest *request);
+    void handleGetCalibration(AsyncWebServerRequest *request);
+    void handleSetSchedule(AsyncWebServerRequest *request);
+    void handleGetSchedule(AsyncWebServerRequest *request);
+    void handleGetRecordings(AsyncWebServerRequest *request);
+    void handleGetRecordingAudio(AsyncWebServerRequest *request);
+    void handleTriggerRecording(AsyncWebServerRequest *request);
 
     // Helper methods
     bool validateCredentials(const String& apiUrl, const String& clientId,
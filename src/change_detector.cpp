@@ -0,0 +1,67 @@
+#include "change_detector.h"
+#include <math.h>
+
+ChangeDetector::ChangeDetector()
+    : _changes(0) {
+    reset();
+}
+
+void ChangeDetector::reset() {
+    _reference = 0;
+    _deviation = 0;
+    _upSum = 0;
+    _downSum = 0;
+    _count = 0;
+}
+
+int ChangeDetector::add(float value) {
+    if (isnan(value)) {
+        return 0;
+    }
+    if (_count == 0) {
+        _reference = value;
+        _deviation = 0;
+    }
+
+    float sigma = MAD_TO_SIGMA * _deviation;
+    float minSigma = MIN_RELATIVE_SIGMA * fabsf(_reference);
+    if (sigma < minSigma) {
+        sigma = minSigma;
+    }
+
+    // Warm-up: plain running mean and deviation, no alarms
+    float error = value - _reference;
+    if (_count < WARMUP_READINGS) {
+        _count++;
+        _reference += error / _count;
+        _deviation += (fabsf(error) - _deviation) / _count;
+        return 0;
+    }
+
+    if (sigma > 0) {
+        float z = error / sigma;
+        _upSum = fmaxf(0, _upSum + z - DRIFT);
+        _downSum = fmaxf(0, _downSum - z - DRIFT);
+        if (_upSum > THRESHOLD || _downSum > THRESHOLD) {
+            int change = _upSum > THRESHOLD ? 1 : -1;
+            _changes++;
+            // The level has moved on: judge what follows against where it settles
+            _count = 0;
+            _upSum = 0;
+            _downSum = 0;
+            return change;
+        }
+    }
+
+    _reference += error / REFERENCE_READINGS;
+    _deviation += (fabsf(error) - _deviation) / REFERENCE_READINGS;
+    return 0;
+}
+
+float ChangeDetector::getReference() const {
+    return _reference;
+}
+
+uint32_t ChangeDetector::getChangeCount() const {
+    return _changes;
+}
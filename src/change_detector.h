@@ -0,0 +1,50 @@
+#ifndef CHANGE_DETECTOR_H
+#define CHANGE_DETECTOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Two-sided CUSUM change-point detector on the level stream.
+//
+// Each value is standardized against a slowly adapting reference (mean and
+// mean absolute deviation over about REFERENCE_READINGS values) and
+// accumulated into an upward and a downward sum that leak DRIFT sigmas per
+// value. Noise around the reference keeps both sums near zero; a sustained
+// shift of a few sigmas grows one of them by roughly the shift per value
+// until it crosses THRESHOLD. The detector then starts over with a fresh
+// warm-up on the new level. Slow drifts are absorbed by the reference and
+// never alarm, and single spikes are too short to reach the threshold.
+// O(1) per value, no buffers.
+class ChangeDetector {
+public:
+    ChangeDetector();
+
+    void reset();
+
+    // Returns +1 for a significant sustained rise, -1 for a drop, else 0
+    int add(float value);
+
+    float getReference() const;
+    uint32_t getChangeCount() const;
+
+    static constexpr float REFERENCE_READINGS = 600.0f;  // ~30 s of 50 ms windows
+    static constexpr uint32_t WARMUP_READINGS = 100;     // Plain mean, no alarms (~5 s)
+    // Allowance per value, in sigmas; above the usual 0.5 because the levels
+    // are already smoothed and so correlated from one window to the next
+    static constexpr float DRIFT = 1.5f;
+    static constexpr float THRESHOLD = 20.0f;            // Sigmas summed over the change
+    // Steady signals have a tiny deviation; shifts below this fraction of the
+    // reference are never significant
+    static constexpr float MIN_RELATIVE_SIGMA = 0.1f;
+    static constexpr float MAD_TO_SIGMA = 1.2533f;       // Mean absolute deviation of a normal
+
+private:
+    float _reference;
+    float _deviation;  // EMA of |value - reference|
+    float _upSum;
+    float _downSum;
+    uint32_t _count;   // Saturates at WARMUP_READINGS
+    uint32_t _changes;
+};
+
+#endif // CHANGE_DETECTOR_H
@@ -0,0 +1,124 @@
+#include "chatter_detector.h"
+#include <math.h>
+#include "fast_math.h"
+#include "sample_source.h"
+
+namespace {
+
+// RBJ band-pass (constant 0 dB peak) centred on 4 Hz with edges at 2 and
+// 8 Hz, for the level envelope sampled once per block
+constexpr double ENVELOPE_RATE = static_cast<double>(SampleSource::SAMPLE_RATE) / SampleSource::BLOCK_SIZE;
+constexpr double MODULATION_CENTER = 4.0;  // Hz, geometric centre of 2-8 Hz
+constexpr double MODULATION_Q = MODULATION_CENTER / (8.0 - 2.0);
+constexpr double W0 = 2.0 * CONSTEXPR_PI * MODULATION_CENTER / ENVELOPE_RATE;
+constexpr double ALPHA = constexprSin(W0) / (2.0 * MODULATION_Q);
+constexpr float B0 = static_cast<float>(ALPHA / (1.0 + ALPHA));
+constexpr float A1 = static_cast<float>(-2.0 * constexprCos(W0) / (1.0 + ALPHA));
+constexpr float A2 = static_cast<float>((1.0 - ALPHA) / (1.0 + ALPHA));
+
+} // namespace
+
+ChatterDetector::ChatterDetector() {
+    reset();
+}
+
+void ChatterDetector::reset() {
+    _features = ChatterFeatures();
+    _primed = false;
+    _x1 = _x2 = _y1 = _y2 = 0;
+    _modulationPower = 0;
+    _confidence = 0.5f;
+}
+
+void ChatterDetector::addBlock(const int32_t* signal, size_t count, int shift) {
+    if (count < 3) {
+        return;
+    }
+
+    // One pass: sign changes, energy, peak and two autocorrelation lags
+    uint32_t crossings = 0;
+    uint64_t peak = 0;
+    int64_t r0 = 0;
+    int64_t r1 = 0;
+    int64_t r2 = 0;
+    int32_t previous2 = signal[0] >> shift;
+    int32_t previous = signal[1] >> shift;
+    r0 = static_cast<int64_t>(previous2) * previous2 + static_cast<int64_t>(previous) * previous;
+    r1 = static_cast<int64_t>(previous) * previous2;
+    crossings = (previous < 0) != (previous2 < 0);
+    for (size_t i = 2; i < count; i++) {
+        int32_t sample = signal[i] >> shift;
+        int64_t power = static_cast<int64_t>(sample) * sample;
+        r0 += power;
+        r1 += static_cast<int64_t>(sample) * previous;
+        r2 += static_cast<int64_t>(sample) * previous2;
+        crossings += (sample < 0) != (previous < 0);
+        peak = static_cast<uint64_t>(power) > peak ? static_cast<uint64_t>(power) : peak;
+        previous2 = previous;
+        previous = sample;
+    }
+
+    uint64_t meanSquare = static_cast<uint64_t>(r0) / count;
+    if (meanSquare < SILENCE_MEAN_SQUARE) {
+        return; // ADC noise only: features would describe the converter, not the room
+    }
+
+    float zcr = static_cast<float>(crossings) / (count - 1);
+    float crestDb = powerToDb(static_cast<float>(peak) / static_cast<float>(meanSquare));
+    float levelDb = powerToDb(static_cast<float>(meanSquare));
+
+    // Levinson-Durbin to order 2; residual power over signal power
+    float k1 = static_cast<float>(r1) / static_cast<float>(r0);
+    float error1 = 1.0f - k1 * k1;
+    float flatness = error1;
+    if (error1 > 1e-6f) {
+        float k2 = (static_cast<float>(r2) / static_cast<float>(r0) - k1 * k1) / error1;
+        flatness = error1 * (1.0f - k2 * k2);
+    }
+    flatness = flatness < 0 ? 0 : flatness > 1 ? 1 : flatness;
+
+    if (!_primed) {
+        _features.zeroCrossingRate = zcr;
+        _features.zcrVariation = 0;
+        _features.flatness = flatness;
+        _features.crestFactorDb = crestDb;
+        _x1 = _x2 = levelDb;
+        _primed = true;
+    }
+
+    // Syllable-rate modulation of the level envelope
+    float modulation = B0 * (levelDb - _x2) - A1 * _y1 - A2 * _y2;
+    _x2 = _x1;
+    _x1 = levelDb;
+    _y2 = _y1;
+    _y1 = modulation;
+    _modulationPower += SMOOTHING * (modulation * modulation - _modulationPower);
+
+    float zcrDeviation = fabsf(zcr - _features.zeroCrossingRate);
+    _features.zeroCrossingRate += SMOOTHING * (zcr - _features.zeroCrossingRate);
+    float relativeDeviation = zcrDeviation / (_features.zeroCrossingRate + 1e-3f);
+    _features.zcrVariation += SMOOTHING * (relativeDeviation - _features.zcrVariation);
+    _features.flatness += SMOOTHING * (flatness - _features.flatness);
+    _features.crestFactorDb += SMOOTHING * (crestDb - _features.crestFactorDb);
+    _features.modulationDb = fastSqrt(_modulationPower);
+
+    _confidence = classify();
+}
+
+float ChatterDetector::classify() const {
+    float z = BIAS
+            + WEIGHT_ZCR * _features.zeroCrossingRate
+            + WEIGHT_ZCR_VARIATION * _features.zcrVariation
+            + WEIGHT_FLATNESS * _features.flatness
+            + WEIGHT_CREST * _features.crestFactorDb
+            + WEIGHT_MODULATION * _features.modulationDb;
+    return 1.0f / (1.0f + expf(-z));
+}
+
+float ChatterDetector::getConfidence() const {
+    return _confidence;
+}
+
+const ChatterFeatures& ChatterDetector::getFeatures() const {
+    return _features;
+}
@@ -0,0 +1,66 @@
+#ifndef CHATTER_DETECTOR_H
+#define CHATTER_DETECTOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Smoothed block features behind the chatter confidence
+struct ChatterFeatures {
+    float zeroCrossingRate;  // Sign changes per sample
+    float zcrVariation;      // Mean block-to-mean ZCR deviation relative to the mean
+    float flatness;          // 2nd-order LPC residual / signal power, 0 (tonal) to 1 (white)
+    float crestFactorDb;     // Block peak power over mean power
+    float modulationDb;      // RMS of the 2-8 Hz band of the block level envelope, dB
+};
+
+// Crowd-chatter classifier from cheap per-block features.
+//
+// Each block costs one pass over its samples (zero crossings, energy, peak
+// and the lag-1/lag-2 autocorrelation for a 2nd-order LPC whose residual
+// ratio estimates spectral flatness) plus O(1) work on the block level: a
+// 2-8 Hz band-pass of the dB envelope, sampled at the block rate, measures
+// syllable-rate modulation. Features are exponentially averaged over about
+// a second and combined by a logistic model into a 0-1 confidence that the
+// sound is people talking rather than machinery (vacuum, blender, grinder).
+//
+// The weights were fitted on synthetic babble and appliance recordings;
+// tools/replay/evaluate_chatter.py refits them from labelled recordings.
+class ChatterDetector {
+public:
+    ChatterDetector();
+
+    void reset();
+
+    // One block of DC-free samples scaled by 2^shift
+    void addBlock(const int32_t* signal, size_t count, int shift);
+
+    // 0 (machine / steady noise) to 1 (crowd chatter); 0.5 until the first
+    // audible block
+    float getConfidence() const;
+    const ChatterFeatures& getFeatures() const;
+
+    static constexpr float SMOOTHING = 1.0f / 64;      // ~1 s of 16 ms blocks
+    static constexpr uint64_t SILENCE_MEAN_SQUARE = 4;  // 2 counts RMS, ADC noise
+
+    // Logistic model: confidence = 1 / (1 + exp(-(BIAS + sum(WEIGHTS * feature))))
+    static constexpr float BIAS = -7.89f;
+    static constexpr float WEIGHT_ZCR = 0.30f;
+    static constexpr float WEIGHT_ZCR_VARIATION = 5.76f;
+    static constexpr float WEIGHT_FLATNESS = -0.26f;
+    static constexpr float WEIGHT_CREST = 0.35f;
+    static constexpr float WEIGHT_MODULATION = 0.61f;
+
+private:
+    ChatterFeatures _features;
+    bool _primed;
+
+    // Envelope band-pass (biquad, direct form I) and its output power
+    float _x1, _x2, _y1, _y2;
+    float _modulationPower;
+
+    float _confidence;
+
+    float classify() const;
+};
+
+#endif // CHATTER_DETECTOR_H
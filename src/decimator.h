@@ -0,0 +1,213 @@
+#ifndef DECIMATOR_H
+#define DECIMATOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "fast_math.h"
+
+// Compile-time design of the CIC droop compensator: a symmetric FIR fitted
+// by least squares to 1 / H_cic over the passband, with a weighted stopband
+// near the output Nyquist so the correction does not boost aliases. Sizes
+// are small enough (5 unknowns, 96 grid points) to solve in constexpr.
+namespace decimator_design {
+
+constexpr size_t TAPS = 9;
+constexpr size_t HALF = TAPS / 2 + 1;       // Unique coefficients
+constexpr int COEFF_BITS = 14;              // Q14, range +-2
+constexpr double PASSBAND = 0.25;          // Fraction of the output rate (8 kHz at 32 kHz)
+constexpr double STOPBAND = 0.46;
+constexpr double STOPBAND_WEIGHT = 0.1;
+constexpr size_t GRID = 96;
+
+struct Coefficients {
+    int32_t taps[TAPS];
+};
+
+// |H_cic| at x cycles per output sample
+constexpr double cicResponse(double x, uint32_t factor, int order) {
+    if (x == 0.0) {
+        return 1.0;
+    }
+    double ratio = constexprSin(CONSTEXPR_PI * x) /
+                   (factor * constexprSin(CONSTEXPR_PI * x / factor));
+    double magnitude = ratio < 0 ? -ratio : ratio;
+    double result = 1.0;
+    for (int i = 0; i < order; i++) {
+        result *= magnitude;
+    }
+    return result;
+}
+
+// Basis k of the zero-phase response: 1 for the centre tap, 2 cos(2 pi k x) otherwise
+constexpr double basis(size_t k, double x) {
+    return k == 0 ? 1.0 : 2.0 * constexprCos(2.0 * CONSTEXPR_PI * k * x);
+}
+
+constexpr Coefficients design(uint32_t factor, int order) {
+    double normal[HALF][HALF + 1] = {};
+    for (size_t g = 0; g < GRID; g++) {
+        bool pass = g < GRID / 2;
+        double x = pass ? PASSBAND * g / (GRID / 2 - 1)
+                        : STOPBAND + (0.5 - STOPBAND) * (g - GRID / 2) / (GRID / 2 - 1);
+        double weight = pass ? 1.0 : STOPBAND_WEIGHT;
+        double h = cicResponse(x, factor, order);
+        double target = pass ? 1.0 : 0.0;
+        for (size_t i = 0; i < HALF; i++) {
+            double bi = basis(i, x) * h;
+            for (size_t j = 0; j < HALF; j++) {
+                normal[i][j] += weight * bi * basis(j, x) * h;
+            }
+            normal[i][HALF] += weight * bi * target;
+        }
+    }
+
+    // Gaussian elimination; the normal matrix is symmetric positive definite
+    for (size_t col = 0; col < HALF; col++) {
+        for (size_t row = col + 1; row < HALF; row++) {
+            double f = normal[row][col] / normal[col][col];
+            for (size_t k = col; k <= HALF; k++) {
+                normal[row][k] -= f * normal[col][k];
+            }
+        }
+    }
+    double c[HALF] = {};
+    for (size_t i = HALF; i-- > 0;) {
+        double sum = normal[i][HALF];
+        for (size_t k = i + 1; k < HALF; k++) {
+            sum -= normal[i][k] * c[k];
+        }
+        c[i] = sum / normal[i][i];
+    }
+
+    // Quantize, then fix the centre tap so the DC gain is exactly one
+    Coefficients result = {};
+    int32_t sum = 0;
+    for (size_t k = 1; k < HALF; k++) {
+        double scaled = c[k] * (1 << COEFF_BITS);
+        int32_t q = static_cast<int32_t>(scaled + (scaled >= 0 ? 0.5 : -0.5));
+        result.taps[HALF - 1 - k] = q;
+        result.taps[HALF - 1 + k] = q;
+        sum += 2 * q;
+    }
+    result.taps[HALF - 1] = (1 << COEFF_BITS) - sum;
+    return result;
+}
+
+} // namespace decimator_design
+
+// Decimates raw ADC blocks by Factor: an Order-stage CIC filter (integrators
+// at the capture rate, combs at the output rate) followed by a 9-tap FIR that
+// flattens the CIC droop to within 0.1 dB up to a quarter of the output rate
+// (8 kHz, the top octave band) and rolls off to -38 dB at 15 kHz.
+//
+// Content that folds into the passband is only attenuated by the CIC, whose
+// third-order nulls are narrow: from factor 4 up, capture frequencies of
+// 24-28 kHz come back at 8-4 kHz about 28-50 dB down (factor 2: 23-42 dB).
+// Band levels near the top of the passband therefore rely on the microphone
+// and ADC front end rolling off above 16 kHz.
+//
+// CIC registers use wrapping 32-bit arithmetic, which is exact as long as the
+// true output fits (12 + Order * log2(Factor) bits). Output stays in ADC
+// counts with the input's DC bias. Factor 1 is a pass-through.
+template <uint32_t Factor, int Order = 3>
+class CicDecimator {
+    static_assert(Factor >= 1 && Factor <= 16 && (Factor & (Factor - 1)) == 0,
+                  "decimation factor must be a power of two up to 16");
+
+public:
+    static constexpr uint32_t FACTOR = Factor;
+
+    CicDecimator() {
+        reset();
+    }
+
+    void reset() {
+        for (int i = 0; i < Order; i++) {
+            _integrators[i] = 0;
+            _combs[i] = 0;
+        }
+        for (size_t i = 0; i < decimator_design::TAPS; i++) {
+            _history[i] = 0;
+        }
+        _historyHead = 0;
+        _primed = false;
+    }
+
+    // Reads outputCount * Factor samples from buffer and writes outputCount
+    // decimated samples to its start
+    void process(uint16_t* buffer, size_t outputCount) {
+        if (Factor == 1 || outputCount == 0) {
+            return;
+        }
+        if (!_primed) {
+            prime(buffer[0]);
+        }
+        for (size_t i = 0; i < outputCount; i++) {
+            buffer[i] = compensate(decimate(&buffer[i * Factor]));
+        }
+    }
+
+    static constexpr decimator_design::Coefficients COEFFICIENTS =
+        decimator_design::design(Factor, Order);
+
+private:
+    static constexpr int GAIN_BITS = Order * (Factor == 1 ? 0 : Factor == 2 ? 1 : Factor == 4 ? 2
+                                             : Factor == 8 ? 3 : 4);
+    static constexpr int OUTPUT_SHIFT = decimator_design::COEFF_BITS + GAIN_BITS;
+
+    uint32_t _integrators[Order];
+    uint32_t _combs[Order];
+    int32_t _history[decimator_design::TAPS];
+    size_t _historyHead;
+    bool _primed;
+
+    int32_t decimate(const uint16_t* input) {
+        for (uint32_t r = 0; r < Factor; r++) {
+            uint32_t value = input[r];
+            for (int s = 0; s < Order; s++) {
+                _integrators[s] += value;
+                value = _integrators[s];
+            }
+        }
+        uint32_t value = _integrators[Order - 1];
+        for (int s = 0; s < Order; s++) {
+            uint32_t previous = _combs[s];
+            _combs[s] = value;
+            value -= previous;
+        }
+        return static_cast<int32_t>(value);
+    }
+
+    // Settles every stage on the first sample so start-up has no step from 0
+    // to the microphone bias
+    void prime(uint16_t value) {
+        uint16_t constant[Factor];
+        for (uint32_t r = 0; r < Factor; r++) {
+            constant[r] = value;
+        }
+        for (size_t i = 0; i < Order + decimator_design::TAPS; i++) {
+            compensate(decimate(constant));
+        }
+        _primed = true;
+    }
+
+    uint16_t compensate(int32_t cicOutput) {
+        _history[_historyHead] = cicOutput;
+        _historyHead = _historyHead + 1 >= decimator_design::TAPS ? 0 : _historyHead + 1;
+
+        // _historyHead is now the oldest sample; the taps are symmetric
+        int64_t acc = 0;
+        size_t index = _historyHead;
+        for (size_t k = 0; k < decimator_design::TAPS; k++) {
+            acc += static_cast<int64_t>(COEFFICIENTS.taps[k]) * _history[index];
+            index = index + 1 >= decimator_design::TAPS ? 0 : index + 1;
+        }
+        int64_t output = roundingShift(acc, OUTPUT_SHIFT);
+        if (output < 0) {
+            return 0;
+        }
+        return output > 0x0FFF ? 0x0FFF : static_cast<uint16_t>(output);  // 12-bit ADC range
+    }
+};
+
+#endif // DECIMATOR_H
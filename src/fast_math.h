@@ -0,0 +1,201 @@
+#ifndef FAST_MATH_H
+#define FAST_MATH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <math.h>
+#include <string.h>
+
+// Table-driven math for the metering and control path. The ESP32 FPU only
+// handles single precision and has no log or square root instruction, so
+// log10f()/pow() cost far more than a table lookup with linear
+// interpolation, and pow(x, 0.5) even goes through double-precision libm.
+//
+// Each table holds a function of the float mantissa 1 + i/256, built at
+// compile time; the exponent is handled exactly. Worst-case error over the
+// whole float range, asserted by test/test_fast_math:
+//   fastLog2(float)    8e-6 absolute; most of it is the float spacing of
+//                      results near +-128
+//   fastLog2(uint64_t) 5e-6 absolute
+//   fastLog10          6e-6 absolute
+//   powerToDb          6e-5 dB, again the float spacing of results near
+//                      +-380 dB; levels in the metering range are closer
+//   fastSqrt           7e-7 relative
+// Powers of two come out exact. Zero, negative and NaN input give
+// LOG2_OF_ZERO from the logarithms and 0 from fastSqrt.
+// Fourth roots (sqrtf(sqrtf())) and expf stay on libm: table versions timed
+// slower than libm on the host and have no on-target timing to say otherwise.
+
+constexpr int MANTISSA_TABLE_BITS = 8;
+constexpr size_t MANTISSA_TABLE_SIZE = (1u << MANTISSA_TABLE_BITS) + 1;
+constexpr float LOG10_OF_2 = 0.30102999566f;
+constexpr float LOG2_OF_ZERO = -128.0f; // Returned for 0 instead of -infinity
+
+// f(1 + i / 2^MANTISSA_TABLE_BITS), and f(2) as the interpolation end point
+struct MantissaTable {
+    float values[MANTISSA_TABLE_SIZE];
+};
+
+constexpr double CONSTEXPR_PI = 3.14159265358979323846;
+
+// Compile-time trigonometry for filter and table design, never used at run
+// time. Within 1e-15 of libm over [-pi, pi] (tan: 5e-15 relative up to
+// +-1.4 rad); range reduction loses more further out.
+constexpr double constexprSin(double x) {
+    while (x > CONSTEXPR_PI) {
+        x -= 2.0 * CONSTEXPR_PI;
+    }
+    while (x < -CONSTEXPR_PI) {
+        x += 2.0 * CONSTEXPR_PI;
+    }
+    double term = x;
+    double sum = x;
+    for (int k = 1; k < 20; k++) {
+        term *= -x * x / ((2 * k) * (2 * k + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr double constexprCos(double x) {
+    return constexprSin(x + CONSTEXPR_PI / 2.0);
+}
+
+constexpr double constexprTan(double x) {
+    return constexprSin(x) / constexprCos(x);
+}
+
+// Newton's method from max(x, 1); within 1 ulp for x in [1e-30, 1e30], not
+// converged far outside it
+constexpr double constexprSqrt(double x) {
+    if (x <= 0.0) {
+        return 0.0;
+    }
+    double guess = x > 1.0 ? x : 1.0;
+    for (int i = 0; i < 64; i++) {
+        guess = 0.5 * (guess + x / guess);
+    }
+    return guess;
+}
+
+// Natural log for x in [1, 2] via ln(x) = 2 atanh((x - 1) / (x + 1)), within
+// 1e-15; only used to build tables at compile time
+constexpr double constexprLn(double x) {
+    double y = (x - 1.0) / (x + 1.0);
+    double y2 = y * y;
+    double term = y;
+    double sum = 0.0;
+    for (int k = 0; k < 24; k++) {
+        sum += term / (2 * k + 1);
+        term *= y2;
+    }
+    return 2.0 * sum;
+}
+
+enum class MantissaFunction { LOG2, SQRT };
+
+constexpr MantissaTable makeMantissaTable(MantissaFunction function) {
+    MantissaTable table = {};
+    const double ln2 = constexprLn(2.0);
+    for (size_t i = 0; i < MANTISSA_TABLE_SIZE; i++) {
+        double f = static_cast<double>(i) / (1u << MANTISSA_TABLE_BITS);
+        double value = function == MantissaFunction::LOG2 ? constexprLn(1.0 + f) / ln2
+                                                          : constexprSqrt(1.0 + f);
+        table.values[i] = static_cast<float>(value);
+    }
+    return table;
+}
+
+inline constexpr MantissaTable LOG2_TABLE = makeMantissaTable(MantissaFunction::LOG2);
+inline constexpr MantissaTable SQRT_TABLE = makeMantissaTable(MantissaFunction::SQRT);
+
+// 2^(k/2) for the exponent remainder of the square root
+inline constexpr float ROOT2_STEPS[2] = {1.0f, 1.41421356237f};
+
+// Interpolates a table at a 31-bit binary fraction
+inline float interpolateMantissa(const MantissaTable& table, uint32_t fraction) {
+    constexpr int REM_BITS = 31 - MANTISSA_TABLE_BITS;
+    uint32_t index = fraction >> REM_BITS;
+    uint32_t remainder = fraction & ((1u << REM_BITS) - 1);
+    float t = remainder * (1.0f / (1u << REM_BITS));
+    float a = table.values[index];
+    float b = table.values[index + 1];
+    return a + (b - a) * t;
+}
+
+// Splits a positive normal float into its unbiased exponent and a 31-bit
+// mantissa fraction. Subnormals are far below any level measured here and
+// are treated as zero by the callers.
+inline int splitFloat(float x, uint32_t& fraction) {
+    uint32_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    fraction = (bits & 0x7FFFFFu) << 8;
+    return static_cast<int>((bits >> 23) & 0xFF) - 127;
+}
+
+// Builds 2^exponent * mantissa for exponents within the normal float range
+inline float scaleByPowerOfTwo(float mantissa, int exponent) {
+    if (exponent < -126) {
+        return 0.0f;
+    }
+    if (exponent > 127) {
+        return INFINITY;
+    }
+    uint32_t bits = static_cast<uint32_t>(exponent + 127) << 23;
+    float scale;
+    memcpy(&scale, &bits, sizeof(scale));
+    return mantissa * scale;
+}
+
+// log2 of an integer, e.g. a sum of squared samples
+inline float fastLog2(uint64_t x) {
+    if (x == 0) {
+        return LOG2_OF_ZERO;
+    }
+    int msb = 63 - __builtin_clzll(x);
+    uint64_t normalized = msb >= 31 ? (x >> (msb - 31)) : (x << (31 - msb));
+    return msb + interpolateMantissa(LOG2_TABLE, static_cast<uint32_t>(normalized) & 0x7FFFFFFFu);
+}
+
+// log2 of a positive float; non-positive input returns LOG2_OF_ZERO
+inline float fastLog2(float x) {
+    if (!(x >= 1.17549435e-38f)) {
+        return LOG2_OF_ZERO;
+    }
+    uint32_t fraction;
+    int exponent = splitFloat(x, fraction);
+    return exponent + interpolateMantissa(LOG2_TABLE, fraction);
+}
+
+inline float fastLog10(float x) {
+    return fastLog2(x) * LOG10_OF_2;
+}
+
+// 10 * log10(x) for power ratios
+inline float powerToDb(float x) {
+    return 10.0f * LOG10_OF_2 * fastLog2(x);
+}
+
+// Square root; non-positive input returns 0
+inline float fastSqrt(float x) {
+    if (!(x >= 1.17549435e-38f)) {
+        return 0.0f;
+    }
+    uint32_t fraction;
+    int exponent = splitFloat(x, fraction);
+    if (exponent > 127) {
+        return x;  // Infinity
+    }
+    int half = exponent >> 1;  // Floor, so the remainder is 0 or 1
+    return scaleByPowerOfTwo(interpolateMantissa(SQRT_TABLE, fraction) * ROOT2_STEPS[exponent - 2 * half],
+                             half);
+}
+
+// Fixed point: x / 2^shift rounded to nearest (halves away from minus
+// infinity), for Q-format products and accumulators
+template <typename T>
+constexpr T roundingShift(T x, int shift) {
+    return (x + (static_cast<T>(1) << (shift - 1))) >> shift;
+}
+
+#endif // FAST_MATH_H
@@ -0,0 +1,155 @@
+#include "feedback_compensator.h"
+#include <math.h>
+
+FeedbackCompensator::FeedbackCompensator()
+    : _increments()
+    , _stepObservations()
+    , _baseline(0)
+    , _baselineValid(false)
+    , _phase(Phase::IDLE)
+    , _step(0)
+    , _direction(0)
+    , _beforePower(0)
+    , _changeTime(0)
+    , _measureStart(0)
+    , _measureSum(0)
+    , _measureCount(0)
+    , _lastTimestamp(0)
+    , _observations(0)
+    , _dirty(false) {
+}
+
+float FeedbackCompensator::toPower(float level) {
+    float squared = level * level;
+    return squared * squared;
+}
+
+void FeedbackCompensator::addReading(float level, uint32_t timestampMs) {
+    float power = toPower(level);
+    _lastTimestamp = timestampMs;
+
+    if (_phase == Phase::SETTLING && timestampMs - _changeTime >= SETTLE_MS) {
+        _phase = Phase::MEASURING;
+        _measureStart = timestampMs;
+        _measureSum = 0;
+        _measureCount = 0;
+    }
+
+    if (_phase == Phase::MEASURING) {
+        _measureSum += power;
+        _measureCount++;
+        if (timestampMs - _measureStart >= MEASURE_MS) {
+            finishMeasurement();
+        }
+    }
+
+    // The baseline only follows the room while no change is pending
+    if (_phase == Phase::IDLE) {
+        _baseline = _baselineValid ? _baseline + BASELINE_ALPHA * (power - _baseline) : power;
+        _baselineValid = true;
+    }
+}
+
+void FeedbackCompensator::onVolumeChange(int fromVolume, int toVolume, uint32_t timestampMs) {
+    // A measurement cut short by the next step still counts if it is long enough
+    if (_phase == Phase::MEASURING && _lastTimestamp - _measureStart >= MIN_MEASURE_MS) {
+        finishMeasurement();
+    }
+
+    int difference = toVolume - fromVolume;
+    if ((difference != 1 && difference != -1) || fromVolume < 0 || toVolume < 0 ||
+        fromVolume > MAX_VOLUME || toVolume > MAX_VOLUME || !_baselineValid) {
+        cancelMeasurement();
+        return;
+    }
+
+    // Before-power: the settled measurement if one just finished, else the baseline
+    _beforePower = _baseline;
+    _step = (difference > 0 ? toVolume : fromVolume) - 1;
+    _direction = difference;
+    _changeTime = timestampMs;
+    _phase = Phase::SETTLING;
+}
+
+void FeedbackCompensator::cancelMeasurement() {
+    _phase = Phase::IDLE;
+}
+
+void FeedbackCompensator::finishMeasurement() {
+    _phase = Phase::IDLE;
+    if (_measureCount == 0) {
+        return;
+    }
+
+    float afterPower = _measureSum / _measureCount;
+    float observed = (afterPower - _beforePower) * _direction;
+    if (observed < 0) {
+        observed = 0;  // Ambient fell during the step; more volume never lowers power
+    } else if (observed > MAX_INCREMENT) {
+        observed = MAX_INCREMENT;
+    }
+
+    // Running mean until the step is mature, then an exponential average
+    uint8_t& count = _stepObservations[_step];
+    if (count < MATURE_OBSERVATIONS) {
+        count++;
+    }
+    float& increment = _increments[_step];
+    increment += (observed - increment) / count;
+    _observations++;
+    _dirty = true;
+
+    // The new volume's settled level is the baseline for the next step
+    _baseline = afterPower;
+}
+
+float FeedbackCompensator::getFeedbackPower(int volume) const {
+    if (volume > MAX_VOLUME) {
+        volume = MAX_VOLUME;
+    }
+    float power = 0;
+    for (int i = 0; i < volume; i++) {
+        power += _increments[i];
+    }
+    return power;
+}
+
+float FeedbackCompensator::compensate(float level, int volume, float floorLevel) const {
+    float feedbackPower = getFeedbackPower(volume);
+    float floorPower = toPower(floorLevel);
+    float power = toPower(level) - (floorPower > feedbackPower ? floorPower : feedbackPower);
+    if (power <= 0) {
+        return 0;
+    }
+    return sqrtf(sqrtf(power));
+}
+
+void FeedbackCompensator::setIncrements(const float* increments, size_t count) {
+    for (size_t i = 0; i < INCREMENT_COUNT; i++) {
+        float value = i < count ? increments[i] : 0;
+        if (!(value >= 0)) {
+            value = 0;  // Also rejects NaN from a corrupt blob
+        } else if (value > MAX_INCREMENT) {
+            value = MAX_INCREMENT;
+        }
+        _increments[i] = value;
+        _stepObservations[i] = value > 0 ? MATURE_OBSERVATIONS : 0;
+    }
+    _dirty = false;
+}
+
+const float* FeedbackCompensator::getIncrements() const {
+    return _increments;
+}
+
+bool FeedbackCompensator::isDirty() const {
+    return _dirty;
+}
+
+void FeedbackCompensator::clearDirty() {
+    _dirty = false;
+}
+
+uint32_t FeedbackCompensator::getObservationCount() const {
+    return _observations;
+}
@@ -0,0 +1,79 @@
+#ifndef FEEDBACK_COMPENSATOR_H
+#define FEEDBACK_COMPENSATOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Removes our own music from the measured sound level.
+//
+// The speakers add power G(v) to the room at player volume v, so without
+// compensation a louder room raises the volume, which makes the room louder
+// still. G is modelled as a table of per-step increments,
+// G(v) = sum of increment[1..v], with G(0) = 0. Each one-step volume change
+// made by the controller is an experiment: the level before the change and
+// the level once the player has settled give one observation of that step's
+// increment. The first MATURE_OBSERVATIONS of a step are averaged so a fresh
+// model learns during its first climb; later ones are blended in at
+// 1 / MATURE_OBSERVATIONS so the model keeps tracking the venue.
+//
+// Levels are the 0-1 SoundSensor scale, where level^4 is proportional to
+// power, so the model is additive in the power domain.
+class FeedbackCompensator {
+public:
+    FeedbackCompensator();
+
+    // Feed every reading, in order; drives the learning state machine
+    void addReading(float level, uint32_t timestampMs);
+
+    // Call after the player volume was changed by this device
+    void onVolumeChange(int fromVolume, int toVolume, uint32_t timestampMs);
+
+    // Call when the volume changed outside our control (app, other device)
+    void cancelMeasurement();
+
+    // Level with the modelled contribution at the given volume removed, or
+    // the stationary background (floorLevel) if that is larger: a floor
+    // measured while music plays already contains the bleed
+    float compensate(float level, int volume, float floorLevel = 0) const;
+    float getFeedbackPower(int volume) const;
+
+    // Model persistence; the table is marked dirty when it learns
+    void setIncrements(const float* increments, size_t count);
+    const float* getIncrements() const;
+    bool isDirty() const;
+    void clearDirty();
+    uint32_t getObservationCount() const;
+
+    static constexpr int MAX_VOLUME = 16;
+    static constexpr size_t INCREMENT_COUNT = MAX_VOLUME; // Steps 0->1 .. 15->16
+    static constexpr uint32_t SETTLE_MS = 1500;   // Player latency after an API call
+    static constexpr uint32_t MEASURE_MS = 3000;  // Averaging time after settling
+    static constexpr uint32_t MIN_MEASURE_MS = 1000;
+    static constexpr uint8_t MATURE_OBSERVATIONS = 5;
+    static constexpr float BASELINE_ALPHA = 0.05f; // ~1 s at 20 readings/s
+    static constexpr float MAX_INCREMENT = 1.0f;   // Power of one step, level^4 units
+
+private:
+    enum class Phase : uint8_t { IDLE, SETTLING, MEASURING };
+
+    float _increments[INCREMENT_COUNT];
+    uint8_t _stepObservations[INCREMENT_COUNT]; // Saturates at MATURE_OBSERVATIONS
+    float _baseline;         // Recent power before any pending change
+    bool _baselineValid;
+    Phase _phase;
+    int _step;               // Increment index being measured
+    int _direction;          // +1 for up, -1 for down
+    float _beforePower;
+    uint32_t _changeTime;
+    uint32_t _measureStart;
+    float _measureSum;
+    uint32_t _measureCount;
+    uint32_t _lastTimestamp;
+    uint32_t _observations;
+    bool _dirty;
+
+    void finishMeasurement();
+    static float toPower(float level);
+};
+
+#endif // FEEDBACK_COMPENSATOR_H
@@ -0,0 +1,139 @@
+#ifndef FIXED_FFT_H
+#define FIXED_FFT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "fast_math.h"
+
+// In-place fixed-point FFT of N real samples.
+//
+// The real input is treated as N/2 complex points (even samples in the real
+// part, odd samples in the imaginary part), run through an iterative radix-2
+// decimation-in-time FFT and then split into the N/2 + 1 bins of the real
+// spectrum. Twiddles are Q30 and generated at compile time; products use a
+// 64-bit intermediate. No per-stage scaling is applied, so the input must
+// leave log2(N) bits of headroom (for N = 2048, inputs within +-2^19).
+//
+// Output is packed in place: data[0] = X[0], data[1] = X[N/2] (both real),
+// and data[2k], data[2k + 1] = Re X[k], Im X[k] for 0 < k < N/2.
+template <size_t N>
+class FixedFft {
+    static_assert(N >= 8 && (N & (N - 1)) == 0, "FFT size must be a power of two");
+
+public:
+    static constexpr size_t SIZE = N;
+    static constexpr size_t BIN_COUNT = N / 2 + 1;
+
+    static void forward(int32_t* data) {
+        complexFft(data);
+        splitReal(data);
+    }
+
+private:
+    static constexpr size_t M = N / 2;  // Complex points
+    static constexpr int TWIDDLE_SHIFT = 30;
+
+    struct TwiddleTable {
+        int32_t cosine[M];  // cos(2 pi k / N)
+        int32_t sine[M];    // sin(2 pi k / N)
+    };
+
+    static constexpr TwiddleTable makeTwiddles() {
+        TwiddleTable table = {};
+        for (size_t k = 0; k < M; k++) {
+            double angle = 2.0 * CONSTEXPR_PI * static_cast<double>(k) / N;
+            double c = constexprCos(angle) * (1 << TWIDDLE_SHIFT);
+            double s = constexprSin(angle) * (1 << TWIDDLE_SHIFT);
+            table.cosine[k] = static_cast<int32_t>(c + (c >= 0 ? 0.5 : -0.5));
+            table.sine[k] = static_cast<int32_t>(s + (s >= 0 ? 0.5 : -0.5));
+        }
+        return table;
+    }
+
+    static constexpr TwiddleTable TWIDDLES = makeTwiddles();
+
+    static int32_t mulQ30(int32_t a, int32_t b) {
+        return static_cast<int32_t>(roundingShift(static_cast<int64_t>(a) * b, TWIDDLE_SHIFT));
+    }
+
+    static void complexFft(int32_t* data) {
+        // Bit-reversal permutation of the M complex points
+        for (size_t i = 1, j = 0; i < M; i++) {
+            size_t bit = M >> 1;
+            for (; j & bit; bit >>= 1) {
+                j ^= bit;
+            }
+            j |= bit;
+            if (i < j) {
+                int32_t re = data[2 * i];
+                int32_t im = data[2 * i + 1];
+                data[2 * i] = data[2 * j];
+                data[2 * i + 1] = data[2 * j + 1];
+                data[2 * j] = re;
+                data[2 * j + 1] = im;
+            }
+        }
+
+        // Butterflies; W_len^k = exp(-j 2 pi k / len) = TWIDDLES[k * N / len]
+        for (size_t len = 2; len <= M; len <<= 1) {
+            size_t half = len >> 1;
+            size_t step = N / len;
+            for (size_t start = 0; start < M; start += len) {
+                for (size_t k = 0; k < half; k++) {
+                    int32_t wr = TWIDDLES.cosine[k * step];
+                    int32_t wi = -TWIDDLES.sine[k * step];
+                    int32_t* a = &data[2 * (start + k)];
+                    int32_t* b = &data[2 * (start + k + half)];
+                    int32_t tr = mulQ30(b[0], wr) - mulQ30(b[1], wi);
+                    int32_t ti = mulQ30(b[0], wi) + mulQ30(b[1], wr);
+                    b[0] = a[0] - tr;
+                    b[1] = a[1] - ti;
+                    a[0] += tr;
+                    a[1] += ti;
+                }
+            }
+        }
+    }
+
+    // X[k] = (Z[k] + Z*[M-k]) / 2 - j W^k (Z[k] - Z*[M-k]) / 2, W = exp(-j 2 pi / N)
+    static void splitBin(int32_t zr, int32_t zi, int32_t cr, int32_t ci, size_t k,
+                         int32_t& xr, int32_t& xi) {
+        // cr, ci is Z[M-k]; its conjugate enters the formula
+        int32_t er = (zr + cr) / 2;
+        int32_t ei = (zi - ci) / 2;
+        int32_t odr = (zr - cr) / 2;
+        int32_t odi = (zi + ci) / 2;
+        // -j * O = (odi, -odr), then multiply by W^k = (cos, -sin)
+        int32_t wr = TWIDDLES.cosine[k];
+        int32_t wi = -TWIDDLES.sine[k];
+        int32_t pr = odi;
+        int32_t pi = -odr;
+        xr = er + mulQ30(pr, wr) - mulQ30(pi, wi);
+        xi = ei + mulQ30(pr, wi) + mulQ30(pi, wr);
+    }
+
+    static void splitReal(int32_t* data) {
+        int32_t z0r = data[0];
+        int32_t z0i = data[1];
+        data[0] = z0r + z0i;  // X[0]
+        data[1] = z0r - z0i;  // X[N/2]
+
+        for (size_t k = 1; k <= M / 2; k++) {
+            size_t mk = M - k;
+            int32_t zr = data[2 * k], zi = data[2 * k + 1];
+            int32_t cr = data[2 * mk], ci = data[2 * mk + 1];
+            int32_t xr, xi;
+            splitBin(zr, zi, cr, ci, k, xr, xi);
+            if (mk != k) {
+                int32_t yr, yi;
+                splitBin(cr, ci, zr, zi, mk, yr, yi);
+                data[2 * mk] = yr;
+                data[2 * mk + 1] = yi;
+            }
+            data[2 * k] = xr;
+            data[2 * k + 1] = xi;
+        }
+    }
+};
+
+#endif // FIXED_FFT_H
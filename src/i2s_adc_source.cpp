@@ -0,0 +1,199 @@
+#include "i2s_adc_source.h"
+#include <soc/syscon_struct.h>
+
+I2sAdcSource::I2sAdcSource(const int (&pins)[CHANNELS], i2s_port_t port)
+    : _port(port)
+    , _isRunning(false)
+    , _eventQueue(nullptr)
+    , _overrunCount(0)
+    , _fill(0) {
+    for (size_t i = 0; i < CHANNELS; i++) {
+        _pins[i] = pins[i];
+    }
+}
+
+I2sAdcSource::~I2sAdcSource() {
+    end();
+}
+
+bool I2sAdcSource::begin() {
+    if (_isRunning) {
+        return true;
+    }
+
+    // Only ADC1 can be used while WiFi is active
+    for (int i = 0; i < ADC1_CHANNEL_MAX; i++) {
+        _channelIndex[i] = -1;
+    }
+    for (size_t i = 0; i < CHANNELS; i++) {
+        int8_t channel = digitalPinToAnalogChannel(_pins[i]);
+        if (channel < 0 || channel >= ADC1_CHANNEL_MAX || _channelIndex[channel] >= 0) {
+            Serial.printf("I2S ADC: GPIO %d is not an unused ADC1 pin\n", _pins[i]);
+            return false;
+        }
+        _adcChannels[i] = static_cast<adc1_channel_t>(channel);
+        _channelIndex[channel] = static_cast<int8_t>(i);
+    }
+
+    i2s_config_t config = {};
+    config.mode = static_cast<i2s_mode_t>(I2S_MODE_MASTER | I2S_MODE_RX | I2S_MODE_ADC_BUILT_IN);
+    config.sample_rate = CAPTURE_RATE * CHANNELS;
+    config.bits_per_sample = I2S_BITS_PER_SAMPLE_16BIT;
+    config.channel_format = I2S_CHANNEL_FMT_ONLY_LEFT;
+    config.communication_format = I2S_COMM_FORMAT_STAND_MSB;
+    config.intr_alloc_flags = ESP_INTR_FLAG_LEVEL1;
+    config.dma_buf_count = DMA_BUFFER_COUNT;
+    config.dma_buf_len = DMA_BUFFER_LENGTH;
+    config.use_apll = false;
+
+    esp_err_t err = i2s_driver_install(_port, &config, EVENT_QUEUE_SIZE, &_eventQueue);
+    if (err != ESP_OK) {
+        Serial.printf("I2S ADC: driver install failed (%d)\n", err);
+        return false;
+    }
+
+    adc1_config_width(ADC_WIDTH_BIT_12);
+    for (size_t i = 0; i < CHANNELS; i++) {
+        adc1_config_channel_atten(_adcChannels[i], ADC_ATTEN_DB_11);
+    }
+
+    err = i2s_set_adc_mode(ADC_UNIT_1, _adcChannels[0]);
+    if (err == ESP_OK) {
+        err = i2s_adc_enable(_port);
+    }
+    if (err == ESP_OK && CHANNELS > 1) {
+        setScanPattern(_adcChannels); // i2s_adc_enable() reloads a one-entry table
+    }
+    if (err != ESP_OK) {
+        Serial.printf("I2S ADC: failed to start ADC capture (%d)\n", err);
+        i2s_driver_uninstall(_port);
+        _eventQueue = nullptr;
+        return false;
+    }
+
+    _fill = 0;
+    _isRunning = true;
+    for (size_t i = 0; i < CHANNELS; i++) {
+        Serial.printf("I2S ADC: capturing GPIO %d at %u Hz, %u samples per block\n",
+                      _pins[i], CAPTURE_RATE, static_cast<unsigned>(CAPTURE_BLOCK_SIZE));
+    }
+    return true;
+}
+
+void I2sAdcSource::setScanPattern(const adc1_channel_t* channels) {
+    // One byte per conversion, four per register, first entry in the top
+    // byte: channel, width (3 = 12 bit), attenuation (3 = 11 dB)
+    uint32_t table[4] = {};
+    for (size_t i = 0; i < CHANNELS; i++) {
+        uint32_t entry = (static_cast<uint32_t>(channels[i]) << 4) | (3 << 2) | 3;
+        table[i / 4] |= entry << (24 - 8 * (i % 4));
+    }
+    for (size_t i = 0; i < 4; i++) {
+        SYSCON.saradc_sar1_patt_tab[i] = table[i];
+    }
+    SYSCON.saradc_ctrl.sar1_patt_len = CHANNELS - 1;
+}
+
+void I2sAdcSource::end() {
+    if (!_isRunning) {
+        return;
+    }
+    i2s_adc_disable(_port);
+    i2s_driver_uninstall(_port);
+    _eventQueue = nullptr;
+    _isRunning = false;
+}
+
+bool I2sAdcSource::readBlock(uint16_t* buffer, uint32_t timeoutMs) {
+    if (!_isRunning) {
+        return false;
+    }
+
+    drainEvents();
+
+    // Partial reads are kept in the staging block so a short timeout never
+    // drops samples; only complete blocks are handed out.
+    size_t bytesRead = 0;
+    size_t bytesWanted = (SCAN_BLOCK_SIZE - _fill) * sizeof(uint16_t);
+    i2s_read(_port, &_staging[_fill], bytesWanted, &bytesRead,
+             timeoutMs == 0 ? 0 : pdMS_TO_TICKS(timeoutMs));
+    _fill += bytesRead / sizeof(uint16_t);
+
+    if (_fill < SCAN_BLOCK_SIZE) {
+        return false;
+    }
+
+    // The top four bits of each word carry the ADC channel number. The
+    // peripheral swaps 16-bit words in pairs, so the position in the stream
+    // says nothing about the channel; one that comes up short at the block
+    // edge repeats its last sample.
+    size_t filled[CHANNELS] = {};
+    for (size_t i = 0; i < SCAN_BLOCK_SIZE; i++) {
+        uint16_t word = _staging[i];
+        uint8_t channel = word >> 12;
+        int8_t index = channel < ADC1_CHANNEL_MAX ? _channelIndex[channel] : -1;
+        if (index < 0 || filled[index] >= CAPTURE_BLOCK_SIZE) {
+            continue;
+        }
+        buffer[index * CAPTURE_BLOCK_SIZE + filled[index]++] = word & 0x0FFF;
+    }
+    for (size_t c = 0; c < CHANNELS; c++) {
+        uint16_t* block = &buffer[c * CAPTURE_BLOCK_SIZE];
+        uint16_t last = filled[c] > 0 ? block[filled[c] - 1] : ADC_MAX / 2;
+        for (size_t i = filled[c]; i < CAPTURE_BLOCK_SIZE; i++) {
+            block[i] = last;
+        }
+    }
+    _fill = 0;
+    return true;
+}
+
+bool I2sAdcSource::standby(uint16_t* buffer, uint32_t blocks) {
+    (void)buffer;
+    if (!_isRunning) {
+        return false;
+    }
+    if (blocks == 0) {
+        return true;
+    }
+
+    // Drop what the DMA has queued so the first block after the pause is
+    // fresh; the buffer being filled is abandoned by i2s_stop()
+    size_t bytesRead;
+    do {
+        bytesRead = 0;
+        i2s_read(_port, _staging, sizeof(_staging), &bytesRead, 0);
+    } while (bytesRead > 0);
+    _fill = 0;
+    drainEvents();
+
+    i2s_adc_disable(_port);
+    i2s_stop(_port);
+    vTaskDelay(pdMS_TO_TICKS(blocks * CAPTURE_BLOCK_SIZE * 1000 / CAPTURE_RATE));
+    i2s_start(_port);
+    esp_err_t err = i2s_adc_enable(_port);
+    if (err == ESP_OK && CHANNELS > 1) {
+        setScanPattern(_adcChannels);
+    }
+    if (err != ESP_OK) {
+        Serial.printf("I2S ADC: failed to restart ADC capture (%d)\n", err);
+        return false;
+    }
+    return true;
+}
+
+uint32_t I2sAdcSource::getOverrunCount() const {
+    return _overrunCount;
+}
+
+void I2sAdcSource::drainEvents() {
+    if (!_eventQueue) {
+        return;
+    }
+    i2s_event_t event;
+    while (xQueueReceive(_eventQueue, &event, 0) == pdTRUE) {
+        if (event.type == I2S_EVENT_RX_Q_OVF) {
+            _overrunCount++;
+        }
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef I2S_ADC_SOURCE_H
+#define I2S_ADC_SOURCE_H
+
+#include <Arduino.h>
+#include <driver/i2s.h>
+#include <driver/adc.h>
+#include "sample_source.h"
+
+// Continuous ADC1 capture through the I2S peripheral's built-in ADC mode.
+// The DMA engine fills a ring of DMA_BUFFER_COUNT blocks in the background,
+// so readers only copy out finished blocks and never poll the ADC.
+//
+// With several channels the SAR controller's pattern table scans them in
+// turn, so one DMA stream carries interleaved samples at CHANNELS times the
+// capture rate. Every word is tagged with its ADC channel, which is what
+// readBlock() de-interleaves by.
+class I2sAdcSource : public SampleSource {
+public:
+    explicit I2sAdcSource(const int (&pins)[CHANNELS], i2s_port_t port = I2S_NUM_0);
+    ~I2sAdcSource() override;
+
+    bool begin() override;
+    void end() override;
+    bool readBlock(uint16_t* buffer, uint32_t timeoutMs) override;
+    uint32_t getOverrunCount() const override;
+
+    // Powers the ADC down and stops the DMA for the time of the blocks
+    bool standby(uint16_t* buffer, uint32_t blocks) override;
+
+    // DMA ring: 8 buffers of up to 1024 samples (the driver's limit) gives
+    // 128 ms of slack without decimation and 64 ms at a factor of 4
+    static constexpr int DMA_BUFFER_COUNT = 8;
+    static constexpr size_t SCAN_BLOCK_SIZE = CAPTURE_BLOCK_SIZE * CHANNELS;
+    static constexpr int DMA_BUFFER_LENGTH = SCAN_BLOCK_SIZE < 1024 ? SCAN_BLOCK_SIZE : 1024;
+    static constexpr int EVENT_QUEUE_SIZE = 4;
+
+private:
+    int _pins[CHANNELS];
+    int8_t _channelIndex[ADC1_CHANNEL_MAX]; // ADC channel -> our index, -1 if unused
+    adc1_channel_t _adcChannels[CHANNELS];
+    i2s_port_t _port;
+    bool _isRunning;
+    QueueHandle_t _eventQueue;
+    uint32_t _overrunCount;
+    size_t _fill;
+    uint16_t _staging[SCAN_BLOCK_SIZE];
+
+    void setScanPattern(const adc1_channel_t* channels);
+
+    void drainEvents();
+};
+
+#endif // I2S_ADC_SOURCE_H
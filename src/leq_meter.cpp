@@ -0,0 +1,101 @@
+#include "leq_meter.h"
+#include "fast_math.h"
+#include "sample_source.h"
+
+// Mean square of a full-scale sine on the 12-bit ADC is 2048^2 / 2 = 2^21
+static constexpr float FULL_SCALE_SINE_LOG2 = 21.0f;
+
+LeqMeter::LeqMeter() {
+    for (size_t i = 0; i < WINDOW_COUNT; i++) {
+        _windowSeconds[i] = DEFAULT_WINDOWS[i];
+    }
+    reset();
+}
+
+void LeqMeter::reset() {
+    _binHead = 0;
+    _binsFilled = 0;
+    _current.sumSquares = 0;
+    _current.sampleCount = 0;
+    for (size_t i = 0; i < WINDOW_COUNT; i++) {
+        _windowSum[i] = 0;
+        _windowCount[i] = 0;
+    }
+}
+
+bool LeqMeter::setWindow(size_t index, uint16_t seconds) {
+    if (index >= WINDOW_COUNT || seconds == 0 || seconds > MAX_WINDOW_SECONDS) {
+        return false;
+    }
+    _windowSeconds[index] = seconds;
+    rebuildWindow(index);
+    return true;
+}
+
+uint16_t LeqMeter::getWindow(size_t index) const {
+    return index < WINDOW_COUNT ? _windowSeconds[index] : 0;
+}
+
+void LeqMeter::addBlock(uint64_t sumSquares, uint32_t sampleCount) {
+    _current.sumSquares += sumSquares;
+    _current.sampleCount += sampleCount;
+    if (_current.sampleCount >= SampleSource::SAMPLE_RATE) {
+        closeBin();
+    }
+}
+
+void LeqMeter::closeBin() {
+    for (size_t i = 0; i < WINDOW_COUNT; i++) {
+        // Drop the bin that falls out of this window, if it is full
+        if (_binsFilled >= _windowSeconds[i]) {
+            const Bin& expired = _bins[(_binHead + MAX_WINDOW_SECONDS - _windowSeconds[i]) % MAX_WINDOW_SECONDS];
+            _windowSum[i] -= expired.sumSquares;
+            _windowCount[i] -= expired.sampleCount;
+        }
+        _windowSum[i] += _current.sumSquares;
+        _windowCount[i] += _current.sampleCount;
+    }
+
+    _bins[_binHead] = _current;
+    _binHead = (_binHead + 1) % MAX_WINDOW_SECONDS;
+    if (_binsFilled < MAX_WINDOW_SECONDS) {
+        _binsFilled++;
+    }
+    _current.sumSquares = 0;
+    _current.sampleCount = 0;
+}
+
+void LeqMeter::rebuildWindow(size_t index) {
+    _windowSum[index] = 0;
+    _windowCount[index] = 0;
+    size_t bins = _binsFilled < _windowSeconds[index] ? _binsFilled : _windowSeconds[index];
+    for (size_t i = 1; i <= bins; i++) {
+        const Bin& bin = _bins[(_binHead + MAX_WINDOW_SECONDS - i) % MAX_WINDOW_SECONDS];
+        _windowSum[index] += bin.sumSquares;
+        _windowCount[index] += bin.sampleCount;
+    }
+}
+
+float LeqMeter::getLeqDbfs(size_t index) const {
+    if (index >= WINDOW_COUNT) {
+        return MIN_DBFS;
+    }
+    return toDbfs(_windowSum[index], _windowCount[index]);
+}
+
+float LeqMeter::getMeanSquare(size_t index) const {
+    if (index >= WINDOW_COUNT || _windowCount[index] == 0) {
+        return 0.0f;
+    }
+    return static_cast<float>(_windowSum[index]) / static_cast<float>(_windowCount[index]);
+}
+
+float LeqMeter::toDbfs(uint64_t sumSquares, uint64_t sampleCount) {
+    if (sumSquares == 0 || sampleCount == 0) {
+        return MIN_DBFS;
+    }
+    // 10*log10(sum / count / fullScale) using log2 differences, no division
+    float db = 10.0f * LOG10_OF_2 *
+               (fastLog2(sumSquares) - fastLog2(sampleCount) - FULL_SCALE_SINE_LOG2);
+    return db < MIN_DBFS ? MIN_DBFS : db;
+}
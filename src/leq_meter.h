@@ -0,0 +1,58 @@
+#ifndef LEQ_METER_H
+#define LEQ_METER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Equivalent continuous sound level (Leq) over several sliding windows.
+//
+// Blocks contribute their integer sum of squared (DC-free) samples. These
+// are collected into one-second bins, and each window keeps an exact running
+// sum over its most recent bins, so an update costs O(1) per block and O(1)
+// per closed bin regardless of window length.
+//
+// Windows must be configured before blocks are added from another task.
+class LeqMeter {
+public:
+    LeqMeter();
+
+    void reset();
+    bool setWindow(size_t index, uint16_t seconds);
+    uint16_t getWindow(size_t index) const;
+
+    void addBlock(uint64_t sumSquares, uint32_t sampleCount);
+
+    // Leq of a window in dB relative to a full-scale sine (dBFS).
+    // Windows still filling cover the seconds captured so far.
+    float getLeqDbfs(size_t index) const;
+
+    // Mean square of a window in ADC counts squared
+    float getMeanSquare(size_t index) const;
+
+    static float toDbfs(uint64_t sumSquares, uint64_t sampleCount);
+
+    static constexpr size_t WINDOW_COUNT = 3;
+    static constexpr uint16_t MAX_WINDOW_SECONDS = 120;
+    static constexpr uint16_t DEFAULT_WINDOWS[WINDOW_COUNT] = {1, 10, 60};
+    static constexpr float MIN_DBFS = -120.0f;
+
+private:
+    struct Bin {
+        uint64_t sumSquares;
+        uint32_t sampleCount;
+    };
+
+    Bin _bins[MAX_WINDOW_SECONDS];
+    size_t _binHead;     // Next bin slot to write
+    size_t _binsFilled;  // Closed bins, saturates at MAX_WINDOW_SECONDS
+    Bin _current;        // Second in progress
+
+    uint16_t _windowSeconds[WINDOW_COUNT];
+    uint64_t _windowSum[WINDOW_COUNT];
+    uint64_t _windowCount[WINDOW_COUNT];
+
+    void closeBin();
+    void rebuildWindow(size_t index);
+};
+
+#endif // LEQ_METER_H
@@ -0,0 +1,77 @@
+#include "level_percentiles.h"
+
+LevelPercentiles::LevelPercentiles()
+    : _histogram()
+    , _ring()
+    , _head(0)
+    , _count(0)
+    , _window(MAX_VALUES) {
+}
+
+void LevelPercentiles::reset() {
+    for (size_t i = 0; i < BIN_COUNT; i++) {
+        _histogram[i] = 0;
+    }
+    _head = 0;
+    _count = 0;
+}
+
+bool LevelPercentiles::setWindow(size_t values) {
+    if (values == 0 || values > MAX_VALUES) {
+        return false;
+    }
+    _window = values;
+    reset();
+    return true;
+}
+
+size_t LevelPercentiles::getWindow() const {
+    return _window;
+}
+
+size_t LevelPercentiles::getCount() const {
+    return _count;
+}
+
+void LevelPercentiles::add(float dbfs) {
+    float position = (dbfs - MIN_DB) / BIN_DB;
+    uint8_t bin = position <= 0 ? 0
+                : position >= BIN_COUNT - 1 ? BIN_COUNT - 1
+                : static_cast<uint8_t>(position);
+
+    // Once the window is full, the slot about to be written is the oldest value
+    if (_count == _window) {
+        _histogram[_ring[_head]]--;
+    } else {
+        _count++;
+    }
+
+    _ring[_head] = bin;
+    _histogram[bin]++;
+    _head = _head + 1 >= _window ? 0 : _head + 1;
+}
+
+float LevelPercentiles::getLevel(uint8_t percentExceeded) const {
+    if (_count == 0) {
+        return MIN_DB;
+    }
+    if (percentExceeded > 100) {
+        percentExceeded = 100;
+    }
+
+    // Walk down from the loudest bin until more than N% of values lie at or
+    // above it; that bin holds the value exceeded N% of the time. L100 is
+    // the quietest value, the last one the walk reaches
+    size_t threshold = _count * percentExceeded / 100;
+    if (threshold >= _count) {
+        threshold = _count - 1;
+    }
+    size_t above = 0;
+    for (size_t bin = BIN_COUNT; bin-- > 0;) {
+        above += _histogram[bin];
+        if (above > threshold) {
+            return MIN_DB + (bin + 0.5f) * BIN_DB;
+        }
+    }
+    return MIN_DB + 0.5f * BIN_DB;
+}
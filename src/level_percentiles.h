@@ -0,0 +1,49 @@
+#ifndef LEVEL_PERCENTILES_H
+#define LEVEL_PERCENTILES_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Percentile levels (L10, L50, L90, ...) over a sliding window of short-term
+// levels.
+//
+// Levels are quantized to BIN_DB-wide bins of a histogram that always holds
+// exactly the values in the window: a ring of bin indices remembers which
+// bin each value went into, so adding a value and expiring the oldest are
+// O(1). A percentile query scans the histogram (BIN_COUNT steps) and returns
+// the bin centre, so results are within BIN_DB / 2 of the exact
+// sort-based percentile. All storage is fixed-size; no heap is used.
+//
+// The window must be configured before values are added from another task.
+class LevelPercentiles {
+public:
+    LevelPercentiles();
+
+    void reset();
+    bool setWindow(size_t values);
+    size_t getWindow() const;
+    size_t getCount() const;
+
+    void add(float dbfs);
+
+    // Level exceeded percentExceeded % of the time in the window (L_N),
+    // or MIN_DB when the window is empty
+    float getLevel(uint8_t percentExceeded) const;
+
+    static constexpr float MIN_DB = -100.0f;
+    static constexpr float BIN_DB = 0.5f;
+    static constexpr size_t BIN_COUNT = 200;  // -100 to 0 dBFS
+    static constexpr size_t MAX_VALUES = 2400;
+
+private:
+    uint16_t _histogram[BIN_COUNT];
+    uint8_t _ring[MAX_VALUES];  // Bin index of each value in the window
+    size_t _head;
+    size_t _count;
+    size_t _window;
+
+    static_assert(BIN_COUNT <= 256, "bin indices are stored as uint8_t");
+    static_assert(MAX_VALUES <= UINT16_MAX, "histogram counts are uint16_t");
+};
+
+#endif // LEVEL_PERCENTILES_H
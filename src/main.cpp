@@ -6,25 +6,65 @@
 #include <ESPAsyncWebServer.h>
 #include <AsyncTCP.h>
 #include <esp_task_wdt.h>
+#include <time.h>
 #include "wifi_manager.h"
+#include "i2s_adc_source.h"
 #include "sound_sensor.h"
+#include "volume_controller.h"
+#include "volume_scheduler.h"
+#include "volume_schedule.h"
+#include "audio_recorder.h"
 #include "api_client.h"
 #include "captive_portal.h"
 
 // Pin Definitions
 #define RESET_PIN 0  // GPIO 0 for the hardware reset button
 #define SOUND_PIN 36 // GPIO 36 (VP) for sound sensor input
+// One ADC1 GPIO per microphone, reference first; set with SOUND_CHANNEL_COUNT
+#ifndef SOUND_CHANNEL_PINS
+#define SOUND_CHANNEL_PINS SOUND_PIN
+#endif
 
 // Constants
 const int WDT_TIMEOUT = 60; // Extended watchdog timeout in seconds
-const int VOLUME_CHANGE_AMOUNT = 1;
-constexpr unsigned long SOUND_CHECK_INTERVAL = 5000;    // 5 seconds
+constexpr unsigned long SOUND_CHECK_INTERVAL = 1000;    // Minimum spacing; VolumeController paces decisions
 constexpr unsigned long WIFI_CHECK_INTERVAL = 5000;     // 5 seconds
 constexpr unsigned long AP_CHECK_INTERVAL = 1000;       // 1 second
 constexpr unsigned long MEMORY_CHECK_INTERVAL = 30000;  // 30 seconds
+constexpr unsigned long FEEDBACK_SAVE_INTERVAL = 600000; // 10 minutes, limits flash wear
+constexpr float NOISE_FLOOR_SAVE_CHANGE = 0.05f; // Relative level change worth a flash write
+constexpr const char* NTP_SERVER = "pool.ntp.org";
+constexpr const char* NTP_FALLBACK_SERVER = "time.google.com";
+constexpr time_t MIN_VALID_TIME = 1609459200; // 2021-01-01: earlier means NTP has not set the clock
 constexpr int MAX_STARTUP_ATTEMPTS = 3;
 constexpr int STARTUP_RETRY_DELAY = 1000; // 1 second
 
+// Sampling task: runs on the core the WiFi stack is not pinned to, above the
+// loop task priority, so TLS and DNS work in loop() never stall acquisition
+#if CONFIG_ESP32_WIFI_TASK_PINNED_TO_CORE_1
+constexpr BaseType_t SOUND_TASK_CORE = 0;
+#else
+constexpr BaseType_t SOUND_TASK_CORE = 1;
+#endif
+// Bytes. SoundSensor's deepest path (process(), processBlock() and
+// finishWindow() over the Pipeline stages) needs under 1 KB of frames in a
+// host -fstack-usage build with 8 channels and decimation 16; register
+// window spills, the I2S driver read, audioRecorder.addBlock() and the FPU
+// context come on top on the ESP32. logSystemStatus() reports the measured
+// headroom.
+constexpr uint32_t SOUND_TASK_STACK_SIZE = 6144;
+constexpr UBaseType_t SOUND_TASK_MIN_HEADROOM = 1024; // Bytes; less is logged as a warning
+constexpr UBaseType_t SOUND_TASK_PRIORITY = 5;
+constexpr uint32_t SOUND_BLOCK_TIMEOUT = 100; // ms, several block periods
+
+// Flash writer for the audio recorder: the other core, at the loop task's
+// priority; sector erases stall both cores' flash cache for tens of ms,
+// which the DMA ring absorbs
+constexpr BaseType_t RECORDER_TASK_CORE = SOUND_TASK_CORE == 1 ? 0 : 1;
+constexpr uint32_t RECORDER_TASK_STACK_SIZE = 3072;
+constexpr UBaseType_t RECORDER_TASK_PRIORITY = 1;
+constexpr uint32_t RECORDER_POLL_INTERVAL = 50; // ms, a fifth of a chunk
+
 // System states
 enum class SystemState {
     INITIALIZING,
@@ -38,12 +78,20 @@ enum class SystemState {
 WiFiManager wifiManager;
 AsyncWebServer webServer(80);
 DNSServer dnsServer;
-SoundSensor soundSensor(SOUND_PIN);
+constexpr int SOUND_PINS[] = {SOUND_CHANNEL_PINS};
+static_assert(sizeof(SOUND_PINS) / sizeof(SOUND_PINS[0]) == SampleSource::CHANNELS,
+              "SOUND_CHANNEL_PINS must list SOUND_CHANNEL_COUNT pins");
+I2sAdcSource soundSource(SOUND_PINS);
+SoundSensor soundSensor(soundSource);
+VolumeController volumeController;
+VolumeScheduler volumeScheduler;
+VolumeSchedule volumeSchedule;
+VenueCalibration venueCalibration;
+AudioRecorder audioRecorder;
 APIClient apiClient;
 CaptivePortal captivePortal(wifiManager, apiClient, webServer, dnsServer);
 
 // Global variables
-int soundSensitivity = 50;  // Will be loaded from stored value
 bool isSTAConnected = false;
 bool apiInitialized = false;
 SystemState currentState = SystemState::INITIALIZING;
@@ -51,8 +99,57 @@ unsigned long lastSoundCheck = 0;
 unsigned long lastWiFiCheck = 0;
 unsigned long lastAPCheck = 0;
 unsigned long lastMemoryCheck = 0;
+unsigned long lastFeedbackSave = 0;
 unsigned long lastVolumeUpdate = 0;
 int lastVolume = -1;
+float savedNoiseFloor = -1;
+int calibrationQuietVolume = VenueCalibration::DEFAULT_QUIET_VOLUME;
+int calibrationBusyVolume = VenueCalibration::DEFAULT_BUSY_VOLUME;
+char localTimezone[VolumeSchedule::MAX_TIMEZONE_LENGTH + 1] = "UTC0";
+bool timeSyncStarted = false;
+TaskHandle_t soundTaskHandle = nullptr;
+
+// Latest values for the portal's /status and /calibration handlers, which
+// run on the AsyncTCP task; loop() updates them under statusMux
+struct StatusSnapshot {
+    SoundReading reading;
+    float ambientLevel;
+    int volume;
+    uint32_t levelChanges;
+    SchedulerCounters commands;
+    VolumeEnvelope envelope;
+    PreferenceModel preference;
+    uint32_t holdRemainingMs;
+    OverrideSample overrides[PreferenceLearner::MAX_RECENT];  // Newest first
+    size_t overrideCount;
+};
+StatusSnapshot statusSnapshot = {};
+
+struct CalibrationSnapshot {
+    CalibrationPhase phase;
+    float progress;
+    uint32_t remainingSeconds;
+    float quietLevel;
+    float busyLevel;
+    int quietVolume;
+    int busyVolume;
+    bool calibrated;  // Mapping in use
+};
+CalibrationSnapshot calibrationSnapshot = {};
+CalibrationRequest pendingCalibration = {}; // From the portal, taken by loop()
+
+struct ScheduleSnapshot {
+    ScheduleRule rules[VolumeSchedule::MAX_RULES];
+    size_t ruleCount;
+    char timezone[VolumeSchedule::MAX_TIMEZONE_LENGTH + 1];
+    bool timeSynced;
+    uint8_t weekday;
+    uint16_t minuteOfDay;
+    VolumeEnvelope envelope;
+};
+ScheduleSnapshot scheduleSnapshot = {};
+ScheduleRequest pendingSchedule = {};
+portMUX_TYPE statusMux = portMUX_INITIALIZER_UNLOCKED;
 
 // Basic setup functions
 void setupHardware() {
@@ -92,12 +189,67 @@ bool setupFileSystem() {
     return true;
 }
 
+// Acquisition and DSP loop; results reach loop() through the sensor's queue
+void soundTask(void* parameter) {
+    esp_task_wdt_add(NULL);
+    for (;;) {
+        if (soundSensor.process(SOUND_BLOCK_TIMEOUT)) {
+            audioRecorder.addBlock(soundSensor.getReferenceBlock(), SampleSource::BLOCK_SIZE);
+        }
+        esp_task_wdt_reset();
+    }
+}
+
+bool startSoundTask() {
+    BaseType_t result = xTaskCreatePinnedToCore(
+        soundTask, "sound", SOUND_TASK_STACK_SIZE, nullptr,
+        SOUND_TASK_PRIORITY, &soundTaskHandle, SOUND_TASK_CORE);
+    if (result != pdPASS) {
+        Serial.println("Failed to create sound sampling task");
+        return false;
+    }
+    Serial.printf("Sound sampling task started on core %d\n", SOUND_TASK_CORE);
+    return true;
+}
+
+// Stores the recorder's completed chunks, so flash never blocks sampling
+void recorderTask(void* parameter) {
+    for (;;) {
+        audioRecorder.writePending();
+        vTaskDelay(pdMS_TO_TICKS(RECORDER_POLL_INTERVAL));
+    }
+}
+
+bool startAudioRecorder() {
+    if (!audioRecorder.begin()) {
+        return false;
+    }
+    uint8_t mode = wifiManager.getRecordingMode();
+    audioRecorder.setMode(mode <= static_cast<uint8_t>(RecordingMode::CONTINUOUS)
+                              ? static_cast<RecordingMode>(mode) : RecordingMode::TRIGGERED);
+    BaseType_t result = xTaskCreatePinnedToCore(
+        recorderTask, "recorder", RECORDER_TASK_STACK_SIZE, nullptr,
+        RECORDER_TASK_PRIORITY, nullptr, RECORDER_TASK_CORE);
+    if (result != pdPASS) {
+        Serial.println("Failed to create audio recorder task");
+        audioRecorder.setMode(RecordingMode::OFF);
+        return false;
+    }
+    Serial.printf("Audio recorder mode: %d\n", static_cast<int>(audioRecorder.getMode()));
+    return true;
+}
+
 bool initializeModules() {
     bool success = true;
     if (!wifiManager.begin()) {
         Serial.println("Failed to initialize WiFiManager");
         success = false;
     }
+    if (!soundSensor.begin() || !startSoundTask()) {
+        Serial.println("Failed to initialize SoundSensor");
+        success = false;
+    }
+    startAudioRecorder(); // Optional: needs the "audio" partition
     return success;
 }
 
@@ -253,24 +405,465 @@ void handleVolumeControl() {
     }
     
     unsigned long currentMillis = millis();
-    if (currentMillis - lastVolumeCheck >= VOLUME_CHECK_INTERVAL) {
+    unsigned long interval = volumeScheduler.isConfirming() ? VolumeScheduler::CONFIRM_MS : VOLUME_CHECK_INTERVAL;
+    if (currentMillis - lastVolumeCheck >= interval) {
         lastVolumeCheck = currentMillis;
         
         int currentVolume = apiClient.getCurrentVolume();
-        if (currentVolume != -1 && currentVolume != lastVolume) {
-            Serial.printf("Volume changed externally: %d -> %d\n", lastVolume, currentVolume);
+        if (currentVolume == -1) {
+            return;
+        }
+        // Only a change none of our commands explains, seen on two reads in
+        // a row, is someone else's
+        PlayerVolume reported = volumeScheduler.classifyPlayerVolume(currentVolume, lastVolume, currentMillis);
+        if (reported == PlayerVolume::OWN_COMMAND) {
+            Serial.printf("Player volume %d (expected %d) is from our own command\n", currentVolume, lastVolume);
+            lastVolume = currentVolume;
+        } else if (reported == PlayerVolume::UNCONFIRMED) {
+            Serial.printf("Player volume %d (expected %d), confirming\n", currentVolume, lastVolume);
+        } else if (reported == PlayerVolume::MANUAL) {
+            Serial.printf("Volume changed externally: %d -> %d, holding for %u min\n", lastVolume, currentVolume,
+                          volumeController.getOverrideHold() / 60000);
+            time_t now = time(nullptr);
+            uint32_t wallTime = now >= MIN_VALID_TIME ? static_cast<uint32_t>(now) : 0;
+            if (volumeController.onExternalVolumeChange(lastVolume, currentVolume, millis(), wallTime)) {
+                const PreferenceModel& model = volumeController.preference().getModel();
+                Serial.printf("Learned preference: %+.2f steps at level %.2f, slope %+.1f (%u changes)\n",
+                              model.offset, PreferenceLearner::PIVOT_LEVEL, model.slope, model.samples);
+                wifiManager.storePreferenceModel(model);
+            }
+            volumeScheduler.onExternalVolumeChange();
             lastVolume = currentVolume;
         }
     }
 }
 // Core functionality functions
+void logSignalFaults(const SignalHealth& health) {
+    static uint8_t lastFaults = 0;
+    if (health.faults == lastFaults) {
+        return;
+    }
+    for (uint8_t bit = 1; bit != 0; bit <<= 1) {
+        SignalFault fault = static_cast<SignalFault>(bit);
+        if ((health.faults & bit) && !(lastFaults & bit)) {
+            Serial.printf("Microphone fault: %s (DC offset %d, noise floor %u)\n",
+                          SignalDiagnostics::getFaultName(fault), health.dcOffset, health.noiseFloor);
+        } else if (!(health.faults & bit) && (lastFaults & bit)) {
+            Serial.printf("Microphone fault cleared: %s\n", SignalDiagnostics::getFaultName(fault));
+        }
+    }
+    lastFaults = health.faults;
+}
+
+void publishCalibration() {
+    CalibrationSnapshot snapshot;
+    snapshot.phase = venueCalibration.getPhase();
+    snapshot.progress = venueCalibration.getProgress();
+    snapshot.remainingSeconds = venueCalibration.getRemainingSeconds();
+    snapshot.quietLevel = venueCalibration.getQuietLevel();
+    snapshot.busyLevel = venueCalibration.getBusyLevel();
+    snapshot.quietVolume = calibrationQuietVolume;
+    snapshot.busyVolume = calibrationBusyVolume;
+    snapshot.calibrated = volumeController.hasMapping();
+    portENTER_CRITICAL(&statusMux);
+    calibrationSnapshot = snapshot;
+    portEXIT_CRITICAL(&statusMux);
+}
+
+// Fits the mapping once both rooms are measured; the sensitivity mapping
+// stays in use until then
+void applyVenueCalibration() {
+    VolumeMapping mapping;
+    if (venueCalibration.fit(calibrationQuietVolume, calibrationBusyVolume, mapping) &&
+        volumeController.setMapping(mapping)) {
+        Serial.printf("Venue calibration: level %.3f -> volume %d, level %.3f -> volume %d\n",
+                      mapping.quietLevel, mapping.quietVolume, mapping.busyLevel, mapping.busyVolume);
+    } else if (venueCalibration.getQuietLevel() >= 0 && venueCalibration.getBusyLevel() >= 0) {
+        volumeController.clearMapping();
+        Serial.println("Venue calibration: busy room not clearly louder than quiet room, keeping sensitivity");
+    }
+}
+
+void saveVenueCalibration() {
+    wifiManager.storeVenueCalibration(static_cast<uint8_t>(soundSensor.getLevelMode()),
+                                      venueCalibration.getQuietLevel(), venueCalibration.getBusyLevel(),
+                                      static_cast<uint8_t>(calibrationQuietVolume),
+                                      static_cast<uint8_t>(calibrationBusyVolume));
+}
+
+bool requestCalibration(const CalibrationRequest& request) {
+    portENTER_CRITICAL(&statusMux);
+    pendingCalibration = request;
+    portEXIT_CRITICAL(&statusMux);
+    return true;
+}
+
+void handleCalibrationRequest() {
+    portENTER_CRITICAL(&statusMux);
+    CalibrationRequest request = pendingCalibration;
+    pendingCalibration.action = CalibrationAction::NONE;
+    portEXIT_CRITICAL(&statusMux);
+
+    switch (request.action) {
+    case CalibrationAction::NONE:
+        return;
+    case CalibrationAction::MEASURE_QUIET:
+    case CalibrationAction::MEASURE_BUSY: {
+        bool quiet = request.action == CalibrationAction::MEASURE_QUIET;
+        calibrationQuietVolume = request.quietVolume >= 0 ? request.quietVolume : calibrationQuietVolume;
+        calibrationBusyVolume = request.busyVolume >= 0 ? request.busyVolume : calibrationBusyVolume;
+        if (venueCalibration.start(quiet ? CalibrationPhase::QUIET : CalibrationPhase::BUSY, request.seconds)) {
+            Serial.printf("Venue calibration: measuring the %s room for %u s\n", quiet ? "quiet" : "busy",
+                          request.seconds);
+        }
+        break;
+    }
+    case CalibrationAction::CANCEL:
+        venueCalibration.cancel();
+        Serial.println("Venue calibration cancelled");
+        break;
+    case CalibrationAction::CLEAR:
+        venueCalibration.clear();
+        volumeController.clearMapping();
+        wifiManager.clearVenueCalibration();
+        Serial.println("Venue calibration cleared, using sensitivity");
+        break;
+    }
+    publishCalibration();
+}
+
+// Local time, once NTP has set the clock
+bool readLocalTime(struct tm& local) {
+    time_t now = time(nullptr);
+    if (now < MIN_VALID_TIME) {
+        return false;
+    }
+    localtime_r(&now, &local);
+    return true;
+}
+
+void startTimeSync() {
+    if (timeSyncStarted || !WiFi.isConnected()) {
+        return;
+    }
+    configTzTime(localTimezone, NTP_SERVER, NTP_FALLBACK_SERVER);
+    timeSyncStarted = true;
+    Serial.printf("Time sync started, timezone %s\n", localTimezone);
+}
+
+// Hands the controller the schedule's envelope for the current slot; the
+// full range until the clock is set
+void updateVolumeEnvelope() {
+    struct tm local;
+    bool synced = readLocalTime(local);
+    uint16_t minuteOfDay = synced ? local.tm_hour * 60 + local.tm_min : 0;
+    VolumeEnvelope envelope = synced ? volumeSchedule.getEnvelope(local.tm_wday, minuteOfDay)
+                                     : VolumeSchedule::FULL_RANGE;
+    const VolumeEnvelope& previous = volumeController.getEnvelope();
+    if (envelope.minVolume != previous.minVolume || envelope.maxVolume != previous.maxVolume ||
+        envelope.bias != previous.bias) {
+        Serial.printf("Volume envelope: %u-%u, bias %.1f\n", envelope.minVolume, envelope.maxVolume,
+                      envelope.bias / 10.0f);
+    }
+    volumeController.setEnvelope(envelope);
+
+    portENTER_CRITICAL(&statusMux);
+    scheduleSnapshot.timeSynced = synced;
+    scheduleSnapshot.weekday = synced ? local.tm_wday : 0;
+    scheduleSnapshot.minuteOfDay = minuteOfDay;
+    scheduleSnapshot.envelope = envelope;
+    portEXIT_CRITICAL(&statusMux);
+}
+
+void publishSchedule() {
+    portENTER_CRITICAL(&statusMux);
+    scheduleSnapshot.ruleCount = volumeSchedule.getRuleCount();
+    for (size_t i = 0; i < scheduleSnapshot.ruleCount; i++) {
+        scheduleSnapshot.rules[i] = volumeSchedule.getRule(i);
+    }
+    strlcpy(scheduleSnapshot.timezone, localTimezone, sizeof(scheduleSnapshot.timezone));
+    portEXIT_CRITICAL(&statusMux);
+}
+
+bool requestSchedule(const ScheduleRequest& request) {
+    portENTER_CRITICAL(&statusMux);
+    pendingSchedule = request;
+    portEXIT_CRITICAL(&statusMux);
+    return true;
+}
+
+// Rules and timezone take effect at once, no reboot
+void handleScheduleRequest() {
+    portENTER_CRITICAL(&statusMux);
+    ScheduleRequest request = pendingSchedule;
+    pendingSchedule.setRules = false;
+    pendingSchedule.setTimezone = false;
+    portEXIT_CRITICAL(&statusMux);
+
+    if (!request.setRules && !request.setTimezone) {
+        return;
+    }
+    if (request.setRules && volumeSchedule.setRules(request.rules, request.ruleCount)) {
+        wifiManager.storeVolumeSchedule(request.rules, request.ruleCount);
+        Serial.printf("Volume schedule: %u rules\n", request.ruleCount);
+    }
+    if (request.setTimezone) {
+        strlcpy(localTimezone, request.timezone, sizeof(localTimezone));
+        setenv("TZ", localTimezone, 1);
+        tzset();
+        wifiManager.storeTimezone(localTimezone);
+        Serial.printf("Timezone: %s\n", localTimezone);
+    }
+    publishSchedule();
+    updateVolumeEnvelope();
+}
+
+void handleSoundReadings() {
+    // Drain everything the sampling task published since the last pass so
+    // the queue never fills and the latest reading stays current
+    SoundReading reading;
+    bool updated = false;
+    bool calibrating = venueCalibration.getPhase() != CalibrationPhase::IDLE;
+    while (soundSensor.poll(reading)) {
+        volumeController.addReading(reading.level, reading.chatterConfidence, reading.timestamp);
+        if (calibrating) {
+            // The same ambient level the controller decides on
+            float ambientLevel = volumeController.feedback().compensate(reading.level, lastVolume,
+                                                                        reading.noiseFloor);
+            if (venueCalibration.addReading(ambientLevel, reading.timestamp)) {
+                calibrating = false;
+                Serial.printf("Venue calibration: quiet room %.3f, busy room %.3f\n",
+                              venueCalibration.getQuietLevel(), venueCalibration.getBusyLevel());
+                applyVenueCalibration();
+                saveVenueCalibration();
+            }
+        }
+        updated = true;
+    }
+    if (updated) {
+        logSignalFaults(reading.health);
+        portENTER_CRITICAL(&statusMux);
+        statusSnapshot.reading = reading;
+        statusSnapshot.volume = lastVolume;
+        statusSnapshot.levelChanges = volumeController.getChangeCount();
+        statusSnapshot.commands = volumeScheduler.getCounters();
+        statusSnapshot.envelope = volumeController.getEnvelope();
+        statusSnapshot.preference = volumeController.preference().getModel();
+        statusSnapshot.holdRemainingMs = volumeController.getHoldRemaining(millis());
+        statusSnapshot.overrideCount = volumeController.preference().getRecentCount();
+        for (size_t i = 0; i < statusSnapshot.overrideCount; i++) {
+            statusSnapshot.overrides[i] = volumeController.preference().getRecent(i);
+        }
+        portEXIT_CRITICAL(&statusMux);
+        publishCalibration();
+    }
+}
+
+void fillCalibrationStatus(JsonDocument& doc) {
+    portENTER_CRITICAL(&statusMux);
+    CalibrationSnapshot snapshot = calibrationSnapshot;
+    portEXIT_CRITICAL(&statusMux);
+
+    static const char* const phaseNames[] = {"idle", "quiet", "busy"};
+    doc["phase"] = phaseNames[static_cast<uint8_t>(snapshot.phase)];
+    doc["progress"] = snapshot.progress;
+    doc["remaining-s"] = snapshot.remainingSeconds;
+    if (snapshot.quietLevel >= 0) {
+        doc["quiet-level"] = snapshot.quietLevel;
+    }
+    if (snapshot.busyLevel >= 0) {
+        doc["busy-level"] = snapshot.busyLevel;
+    }
+    doc["quiet-volume"] = snapshot.quietVolume;
+    doc["busy-volume"] = snapshot.busyVolume;
+    doc["calibrated"] = snapshot.calibrated;
+}
+
+void fillScheduleStatus(JsonDocument& doc) {
+    portENTER_CRITICAL(&statusMux);
+    ScheduleSnapshot snapshot = scheduleSnapshot;
+    portEXIT_CRITICAL(&statusMux);
+
+    static const char* const dayNames[] = {"sun", "mon", "tue", "wed", "thu", "fri", "sat"};
+    doc["timezone"] = snapshot.timezone;
+    doc["time-synced"] = snapshot.timeSynced;
+    if (snapshot.timeSynced) {
+        char localTime[16];
+        snprintf(localTime, sizeof(localTime), "%s %02u:%02u", dayNames[snapshot.weekday % 7],
+                 snapshot.minuteOfDay / 60, snapshot.minuteOfDay % 60);
+        doc["local-time"] = localTime;
+    }
+    JsonObject envelope = doc.createNestedObject("envelope");
+    envelope["min"] = snapshot.envelope.minVolume;
+    envelope["max"] = snapshot.envelope.maxVolume;
+    envelope["bias"] = snapshot.envelope.bias / 10.0f;
+    JsonArray rules = doc.createNestedArray("rules");
+    for (size_t i = 0; i < snapshot.ruleCount; i++) {
+        char rule[64];
+        VolumeSchedule::formatRule(snapshot.rules[i], rule, sizeof(rule));
+        rules.add(rule);
+    }
+}
+
+void fillStatus(JsonDocument& doc) {
+    portENTER_CRITICAL(&statusMux);
+    StatusSnapshot snapshot = statusSnapshot;
+    portEXIT_CRITICAL(&statusMux);
+
+    float offset = soundSensor.getCalibrationOffset();
+    doc["sequence"] = snapshot.reading.sequence;
+    doc["level"] = snapshot.reading.level;
+    doc["ambient-level"] = snapshot.ambientLevel;
+    doc["volume"] = snapshot.volume;
+
+    JsonArray leq = doc.createNestedArray("leq");
+    for (size_t i = 0; i < LeqMeter::WINDOW_COUNT; i++) {
+        JsonObject window = leq.createNestedObject();
+        window["window-s"] = soundSensor.getLeqWindow(i);
+        window["dbfs"] = snapshot.reading.leqDbfs[i];
+        window["db-spl"] = snapshot.reading.leqDbfs[i] + offset;
+    }
+
+    JsonObject percentiles = doc.createNestedObject("percentiles");
+    percentiles["window-s"] = soundSensor.getPercentileWindow();
+    for (size_t i = 0; i < SoundReading::PERCENTILE_COUNT; i++) {
+        char name[8];
+        snprintf(name, sizeof(name), "L%u", soundSensor.getPercentile(i));
+        JsonObject level = percentiles.createNestedObject(name);
+        level["dbfs"] = snapshot.reading.percentileDbfs[i];
+        level["db-spl"] = snapshot.reading.percentileDbfs[i] + offset;
+    }
+
+    const SignalHealth& health = snapshot.reading.health;
+    JsonObject mic = doc.createNestedObject("mic");
+    JsonArray faults = mic.createNestedArray("faults");
+    for (uint8_t bit = 1; bit != 0; bit <<= 1) {
+        if (health.faults & bit) {
+            faults.add(SignalDiagnostics::getFaultName(static_cast<SignalFault>(bit)));
+        }
+    }
+    mic["clipped-samples"] = health.clippedSamples;
+    mic["clipped-blocks"] = health.clippedBlocks;
+    mic["flat-blocks"] = health.flatBlocks;
+    mic["dc-offset"] = health.dcOffset;
+    mic["dc-drift"] = health.dcDrift;
+    mic["noise-floor"] = health.noiseFloor;
+
+    JsonArray channels = doc.createNestedArray("channels");
+    for (size_t c = 0; c < SampleSource::CHANNELS; c++) {
+        JsonObject channel = channels.createNestedObject();
+        channel["pin"] = SOUND_PINS[c];
+        channel["level"] = snapshot.reading.channelLevels[c];
+        channel["weight"] = soundSensor.getChannelWeight(c);
+        JsonArray channelFaults = channel.createNestedArray("faults");
+        for (uint8_t bit = 1; bit != 0; bit <<= 1) {
+            if (snapshot.reading.channelFaults[c] & bit) {
+                channelFaults.add(SignalDiagnostics::getFaultName(static_cast<SignalFault>(bit)));
+            }
+        }
+    }
+
+    doc["noise-floor-level"] = snapshot.reading.noiseFloor;
+    doc["chatter-confidence"] = snapshot.reading.chatterConfidence;
+    doc["level-changes"] = snapshot.levelChanges;
+    doc["transients-rejected"] = snapshot.reading.transientsRejected;
+    doc["blocks"] = soundSensor.getBlockCount();
+
+    const SamplingStats& sampling = snapshot.reading.sampling;
+    JsonObject samplingStatus = doc.createNestedObject("sampling");
+    samplingStatus["mode"] = sampling.lowDuty ? "low-duty" : "full";
+    samplingStatus["stable-time"] = soundSensor.getAdaptiveSampling();
+    samplingStatus["active-percent"] = sampling.activePercent;
+    samplingStatus["dsp-percent"] = sampling.processedPercent;
+    samplingStatus["current-ma"] = sampling.currentMa;
+    samplingStatus["wakes"] = sampling.wakeCount;
+
+    JsonObject commands = doc.createNestedObject("commands");
+    commands["issued"] = snapshot.commands.issued;
+    commands["coalesced"] = snapshot.commands.coalesced;
+    commands["suppressed"] = snapshot.commands.suppressed;
+    commands["urgent"] = snapshot.commands.urgent;
+    commands["failed"] = snapshot.commands.failed;
+    commands["echoes"] = snapshot.commands.echoes;
+    commands["min-dwell-s"] = volumeScheduler.getMinDwell() / 1000;
+
+    JsonObject envelope = doc.createNestedObject("envelope");
+    envelope["min"] = snapshot.envelope.minVolume;
+    envelope["max"] = snapshot.envelope.maxVolume;
+    envelope["bias"] = snapshot.envelope.bias / 10.0f;
+
+    JsonObject preference = doc.createNestedObject("preference");
+    preference["offset"] = snapshot.preference.offset;
+    preference["slope"] = snapshot.preference.slope;
+    preference["learned"] = snapshot.preference.samples;
+    preference["hold-remaining-s"] = snapshot.holdRemainingMs / 1000;
+    JsonArray overrides = preference.createNestedArray("overrides");
+    for (size_t i = 0; i < snapshot.overrideCount; i++) {
+        JsonObject item = overrides.createNestedObject();
+        item["level"] = snapshot.overrides[i].level;
+        item["from"] = snapshot.overrides[i].fromVolume;
+        item["volume"] = snapshot.overrides[i].volume;
+        if (snapshot.overrides[i].time != 0) {
+            item["time"] = snapshot.overrides[i].time;
+        }
+    }
+    doc["dropped-readings"] = soundSensor.getDroppedReadings();
+}
+
+void saveFeedbackModel() {
+    FeedbackCompensator& feedbackCompensator = volumeController.feedback();
+    if (!feedbackCompensator.isDirty()) {
+        return;
+    }
+    wifiManager.storeFeedbackModel(feedbackCompensator.getIncrements(),
+                                   FeedbackCompensator::INCREMENT_COUNT);
+    feedbackCompensator.clearDirty();
+    Serial.printf("Saved feedback model (%u observations, %.3f at volume %d)\n",
+                  feedbackCompensator.getObservationCount(),
+                  feedbackCompensator.getFeedbackPower(FeedbackCompensator::MAX_VOLUME),
+                  FeedbackCompensator::MAX_VOLUME);
+}
+
+void saveNoiseFloor() {
+    const SoundReading& reading = soundSensor.getLatestReading();
+    if (reading.sequence == 0) {
+        return; // No reading yet
+    }
+    float floorLevel = reading.noiseFloor;
+    if (savedNoiseFloor >= 0 && fabsf(floorLevel - savedNoiseFloor) <= NOISE_FLOOR_SAVE_CHANGE * savedNoiseFloor) {
+        return;
+    }
+    wifiManager.storeNoiseFloor(static_cast<uint8_t>(soundSensor.getLevelMode()), floorLevel);
+    savedNoiseFloor = floorLevel;
+    Serial.printf("Saved noise floor: %.3f\n", floorLevel);
+}
+
+// Sends the scheduler's pending volume once it is due; between decisions
+// too, as the dwell runs out
+void sendScheduledVolume() {
+    int newVolume;
+    if (!isSTAConnected || !WiFi.isConnected() || !apiInitialized ||
+        !volumeScheduler.isCommandDue(millis(), newVolume)) {
+        return;
+    }
+    bool accepted = apiClient.setPlayerVolume(newVolume);
+    volumeScheduler.onCommandSent(newVolume, accepted, millis());
+    if (accepted) {
+        Serial.printf("Volume changed: %d -> %d\n", lastVolume, newVolume);
+        volumeController.onVolumeCommanded(lastVolume, newVolume, millis());
+        lastVolume = newVolume;
+        lastVolumeUpdate = millis();
+    }
+}
+
 void processSound() {
     if (!isSTAConnected || !WiFi.isConnected() || !apiInitialized) {
         return;
     }
 
     float soundLevel = soundSensor.getSoundLevel();
-    Serial.printf("Sound level: %.2f\n", soundLevel);
+    Serial.printf("Sound level: %.2f (Leq %ds: %.1f dBFS, %.1f dB SPL)\n", soundLevel,
+                  soundSensor.getLeqWindow(0), soundSensor.getLeqDbfs(0), soundSensor.getLeqDbSpl(0));
 
     // Verify we have a valid last volume reading
     if (lastVolume == -1) {
@@ -281,25 +874,27 @@ void processSound() {
         }
     }
 
-    // Calculate target volume based on sound level and sensitivity
-    float sensitivityFactor = soundSensitivity / 50.0f; // Convert 0-100 to 0-2 range
-    int targetVolume = constrain(
-        map(round(soundLevel * 100 * sensitivityFactor), 0, 100, 0, 16),
-        0, 16
-    );
-
-    // Only change volume if difference is significant
-    if (abs(targetVolume - lastVolume) >= VOLUME_CHANGE_AMOUNT) {
-        int newVolume = (targetVolume > lastVolume)
-            ? min(16, lastVolume + VOLUME_CHANGE_AMOUNT)
-            : max(0, lastVolume - VOLUME_CHANGE_AMOUNT);
-            
-        if (apiClient.setPlayerVolume(newVolume)) {
-            Serial.printf("Volume changed: %d -> %d\n", lastVolume, newVolume);
-            lastVolume = newVolume;
-            lastVolumeUpdate = millis();
+    VolumeDecision decision = volumeController.decide(soundLevel, soundSensor.getNoiseFloor(), lastVolume, millis());
+    if (decision.surge) {
+        Serial.println("Crowd level changed, reacting now");
+        if (audioRecorder.trigger(RecordingReason::LEVEL_CHANGE, millis())) {
+            Serial.println("Recording a snippet of the change");
         }
     }
+    Serial.printf("Ambient level: %.2f (above floor %.2f and music feedback at volume %d), chatter %.2f%s\n",
+                  decision.ambientLevel, decision.floorLevel, lastVolume, decision.chatterConfidence,
+                  decision.gated ? " - increase held, not chatter" : "");
+    Serial.printf("L%u/L%u/L%u over %ds: %.1f / %.1f / %.1f dB SPL\n",
+                  soundSensor.getPercentile(0), soundSensor.getPercentile(1),
+                  soundSensor.getPercentile(2), soundSensor.getPercentileWindow(),
+                  soundSensor.getPercentileDbSpl(0), soundSensor.getPercentileDbSpl(1),
+                  soundSensor.getPercentileDbSpl(2));
+    portENTER_CRITICAL(&statusMux);
+    statusSnapshot.ambientLevel = decision.ambientLevel;
+    portEXIT_CRITICAL(&statusMux);
+
+    volumeScheduler.request(decision.newVolume, lastVolume, decision.surge);
+    sendScheduledVolume();
 }
 
 void handleReset() {
@@ -322,6 +917,13 @@ void logSystemStatus() {
     Serial.printf("Largest free heap block: %d bytes\n", ESP.getMaxAllocHeap());
     Serial.printf("WiFi Status: %s\n", isSTAConnected ? "Connected" : "Disconnected");
     Serial.printf("API Status: %s\n", apiInitialized ? "Initialized" : "Not Initialized");
+    Serial.printf("Sound blocks: %u (dropped readings: %u)\n",
+                  soundSensor.getBlockCount(), soundSensor.getDroppedReadings());
+    if (soundTaskHandle) {
+        UBaseType_t headroom = uxTaskGetStackHighWaterMark(soundTaskHandle);
+        Serial.printf("Sound task stack: %u of %u bytes never used%s\n", headroom, SOUND_TASK_STACK_SIZE,
+                      headroom < SOUND_TASK_MIN_HEADROOM ? " - LOW" : "");
+    }
     
     if (isSTAConnected) {
         Serial.printf("Signal strength (RSSI): %d dBm\n", WiFi.RSSI());
@@ -371,8 +973,87 @@ void setup() {
     }
 
     // Load sensitivity setting
-    soundSensitivity = wifiManager.getSensitivity();
-    Serial.printf("Loaded saved sensitivity: %d\n", soundSensitivity);
+    volumeController.setSensitivity(wifiManager.getSensitivity());
+    Serial.printf("Loaded saved sensitivity: %d\n", volumeController.getSensitivity());
+
+    // Load sound metering settings
+    soundSensor.setCalibrationOffset(wifiManager.getCalibrationOffset());
+    uint8_t levelMode = wifiManager.getLevelMode();
+    soundSensor.setLevelMode(levelMode <= static_cast<uint8_t>(LevelMode::SPEECH)
+                                 ? static_cast<LevelMode>(levelMode) : LevelMode::PEAK_TO_PEAK);
+    float noiseFloor;
+    if (wifiManager.loadNoiseFloor(levelMode, noiseFloor)) {
+        soundSensor.seedNoiseFloor(noiseFloor);
+        savedNoiseFloor = noiseFloor;
+        Serial.printf("Loaded noise floor: %.3f\n", noiseFloor);
+    }
+    float quietLevel, busyLevel;
+    uint8_t quietVolume, busyVolume;
+    if (wifiManager.loadVenueCalibration(levelMode, quietLevel, busyLevel, quietVolume, busyVolume)) {
+        venueCalibration.setPoints(quietLevel, busyLevel);
+        calibrationQuietVolume = quietVolume;
+        calibrationBusyVolume = busyVolume;
+        applyVenueCalibration();
+    }
+    publishCalibration();
+    ScheduleRule scheduleRules[VolumeSchedule::MAX_RULES];
+    size_t ruleCount = wifiManager.loadVolumeSchedule(scheduleRules, VolumeSchedule::MAX_RULES);
+    if (ruleCount > 0 && !volumeSchedule.setRules(scheduleRules, ruleCount)) {
+        Serial.println("Invalid stored volume schedule, ignoring it");
+    }
+    strlcpy(localTimezone, wifiManager.getTimezone().c_str(), sizeof(localTimezone));
+    setenv("TZ", localTimezone, 1);
+    tzset();
+    publishSchedule();
+    updateVolumeEnvelope();
+    Serial.printf("Volume schedule: %u rules, timezone %s\n", volumeSchedule.getRuleCount(), localTimezone);
+    uint8_t weighting = wifiManager.getWeighting();
+    soundSensor.setWeighting(weighting <= static_cast<uint8_t>(Weighting::C)
+                                 ? static_cast<Weighting>(weighting) : Weighting::A);
+    uint8_t bandMode = wifiManager.getBandMode();
+    soundSensor.setBandMode(bandMode <= static_cast<uint8_t>(BandMode::THIRD_OCTAVE)
+                                ? static_cast<BandMode>(bandMode) : BandMode::OFF);
+    if (!soundSensor.setTransientFilter(wifiManager.getTransientWindow(),
+                                        wifiManager.getTransientThreshold())) {
+        Serial.println("Invalid stored transient filter settings, using defaults");
+    }
+    uint8_t aggregation = wifiManager.getChannelAggregation();
+    soundSensor.setChannelAggregation(aggregation <= static_cast<uint8_t>(ChannelAggregation::WEIGHTED)
+                                          ? static_cast<ChannelAggregation>(aggregation)
+                                          : ChannelAggregation::MEAN);
+    float channelWeights[SampleSource::CHANNELS];
+    if (wifiManager.loadChannelWeights(channelWeights, SampleSource::CHANNELS)) {
+        for (size_t c = 0; c < SampleSource::CHANNELS; c++) {
+            soundSensor.setChannelWeight(c, channelWeights[c]);
+        }
+    }
+    if (!soundSensor.setAdaptiveSampling(wifiManager.getAdaptiveSampling())) {
+        Serial.println("Invalid stored adaptive sampling time, sampling continuously");
+    }
+    if (!volumeController.setOverrideHold(static_cast<uint32_t>(wifiManager.getOverrideHold()) * 60000)) {
+        Serial.println("Invalid stored override hold time, using the default");
+    }
+    PreferenceModel preferenceModel;
+    if (wifiManager.loadPreferenceModel(preferenceModel) &&
+        volumeController.preference().setModel(preferenceModel)) {
+        Serial.printf("Loaded preference: %+.2f steps at level %.2f, slope %+.1f (%u changes)\n",
+                      preferenceModel.offset, PreferenceLearner::PIVOT_LEVEL, preferenceModel.slope,
+                      preferenceModel.samples);
+    }
+    float feedbackModel[FeedbackCompensator::INCREMENT_COUNT];
+    if (wifiManager.loadFeedbackModel(feedbackModel, FeedbackCompensator::INCREMENT_COUNT)) {
+        volumeController.feedback().setIncrements(feedbackModel, FeedbackCompensator::INCREMENT_COUNT);
+        Serial.printf("Loaded feedback model: %.3f at volume %d\n",
+                      volumeController.feedback().getFeedbackPower(FeedbackCompensator::MAX_VOLUME),
+                      FeedbackCompensator::MAX_VOLUME);
+    }
+    Serial.printf("Calibration offset: %.1f dB, level mode: %d, weighting: %d, bands: %d\n",
+                  soundSensor.getCalibrationOffset(), static_cast<int>(soundSensor.getLevelMode()),
+                  static_cast<int>(soundSensor.getWeighting()), static_cast<int>(soundSensor.getBandMode()));
+    Serial.printf("Transient filter: %u windows, %.1f sigma\n",
+                  static_cast<unsigned>(soundSensor.getTransientWindow()), soundSensor.getTransientThreshold());
+    Serial.printf("Adaptive sampling: %s (stable time %u s)\n",
+                  soundSensor.getAdaptiveSampling() > 0 ? "on" : "off", soundSensor.getAdaptiveSampling());
 
     // Try to connect to saved network if credentials exist
     if (wifiManager.hasStoredCredentials()) {
@@ -415,6 +1096,10 @@ void setup() {
 
     // Always ensure AP is running
     wifiManager.createAP();
+    captivePortal.setStatusCallback(fillStatus);
+    captivePortal.setCalibrationCallbacks(requestCalibration, fillCalibrationStatus);
+    captivePortal.setScheduleCallbacks(requestSchedule, fillScheduleStatus);
+    captivePortal.setAudioRecorder(&audioRecorder);
     if (!captivePortal.begin()) {
         Serial.println("Failed to start captive portal");
         currentState = SystemState::ERROR;
@@ -432,6 +1117,10 @@ void loop() {
     captivePortal.handleClient();
     yield();
 
+    handleCalibrationRequest();
+    handleScheduleRequest();
+    handleSoundReadings();
+
     unsigned long currentMillis = millis();
 
     // Check AP mode
@@ -445,21 +1134,35 @@ void loop() {
     if (currentMillis - lastWiFiCheck >= WIFI_CHECK_INTERVAL) {
         lastWiFiCheck = currentMillis;
         handleWiFiConnection();
+        startTimeSync();
+        updateVolumeEnvelope();
         esp_task_wdt_reset();
     }
 
-    // Process sound measurement if connected and API initialized
+    // Process sound measurement if connected and API initialized: at once on
+    // a crowd change, otherwise on the controller's active / idle interval
     if (currentState == SystemState::CONNECTED && 
-        currentMillis - lastSoundCheck >= SOUND_CHECK_INTERVAL) {
+        currentMillis - lastSoundCheck >= SOUND_CHECK_INTERVAL &&
+        volumeController.isDecisionDue(currentMillis)) {
         lastSoundCheck = currentMillis;
         processSound();
-        handleVolumeControl();  // Check for external volume changes
         esp_task_wdt_reset();
     }
+    if (currentState == SystemState::CONNECTED) {
+        sendScheduledVolume();
+        handleVolumeControl();  // Check for external volume changes
+    }
 
     // Check for reset button press
     handleReset();
 
+    // Persist what the feedback model learned
+    if (currentMillis - lastFeedbackSave >= FEEDBACK_SAVE_INTERVAL) {
+        lastFeedbackSave = currentMillis;
+        saveFeedbackModel();
+        saveNoiseFloor();
+    }
+
     // Monitor system health
     if (currentMillis - lastMemoryCheck >= MEMORY_CHECK_INTERVAL) {
         lastMemoryCheck = currentMillis;
@@ -0,0 +1,139 @@
+#include "noise_floor.h"
+#include <math.h>
+
+namespace {
+
+// Sub-windows per day sub-window (3 h of 75 s)
+constexpr uint32_t DAY_SUBWINDOW_LENGTH =
+    static_cast<uint32_t>(NoiseFloorTracker::DAY_HORIZON_SECONDS * NoiseFloorTracker::SUBWINDOWS /
+                          (NoiseFloorTracker::HORIZON_SECONDS * NoiseFloorTracker::DAY_SUBWINDOWS) +
+                          0.5f);
+
+} // namespace
+
+NoiseFloorTracker::NoiseFloorTracker()
+    : _smoothing(1.0f)
+    , _subwindowUpdates(1)
+    , _warmupUpdates(0) {
+    setUpdateInterval(0.05f);
+}
+
+void NoiseFloorTracker::reset() {
+    _smoothed = 0;
+    _primed = false;
+    _updates = 0;
+    _subwindowMinimum = INFINITY;
+    _subwindowCount = 0;
+    for (size_t i = 0; i < SUBWINDOWS; i++) {
+        _minima[i] = INFINITY;
+    }
+    _next = 0;
+    _horizonMinimum = INFINITY;
+    _daySubwindowMinimum = INFINITY;
+    _daySubwindowCount = 0;
+    for (size_t i = 0; i < DAY_SUBWINDOWS; i++) {
+        _dayMinima[i] = INFINITY;
+    }
+    _dayNext = 0;
+    _dayMinimum = INFINITY;
+}
+
+void NoiseFloorTracker::setUpdateInterval(float seconds) {
+    if (!(seconds > 0)) {
+        return;
+    }
+    _smoothing = seconds >= SMOOTHING_SECONDS ? 1.0f : seconds / SMOOTHING_SECONDS;
+    float updates = HORIZON_SECONDS / SUBWINDOWS / seconds;
+    _subwindowUpdates = updates < 1 ? 1 : static_cast<uint32_t>(updates + 0.5f);
+    _warmupUpdates = static_cast<uint32_t>(WARMUP_SECONDS / seconds + 0.5f);
+    reset();
+}
+
+void NoiseFloorTracker::addPower(float power) {
+    if (!(power >= 0)) {
+        return;
+    }
+    if (!_primed) {
+        _smoothed = power;
+        _primed = true;
+    } else {
+        _smoothed += _smoothing * (power - _smoothed);
+    }
+    if (_updates < _warmupUpdates) {
+        _updates++;
+        return;
+    }
+
+    if (_smoothed < _subwindowMinimum) {
+        _subwindowMinimum = _smoothed;
+    }
+    if (++_subwindowCount >= _subwindowUpdates) {
+        closeSubwindow();
+    }
+}
+
+void NoiseFloorTracker::closeSubwindow() {
+    float closed = _subwindowMinimum;
+    _minima[_next] = closed;
+    _next = (_next + 1) % SUBWINDOWS;
+    _subwindowMinimum = INFINITY;
+    _subwindowCount = 0;
+
+    // SUBWINDOWS compares once per sub-window, not per update
+    _horizonMinimum = INFINITY;
+    for (size_t i = 0; i < SUBWINDOWS; i++) {
+        if (_minima[i] < _horizonMinimum) {
+            _horizonMinimum = _minima[i];
+        }
+    }
+
+    // The day ring sees each sub-window once, so it costs no more
+    if (closed < _daySubwindowMinimum) {
+        _daySubwindowMinimum = closed;
+    }
+    if (_daySubwindowMinimum < _dayMinimum) {
+        _dayMinimum = _daySubwindowMinimum;
+    }
+    if (++_daySubwindowCount >= DAY_SUBWINDOW_LENGTH) {
+        closeDaySubwindow();
+    }
+}
+
+void NoiseFloorTracker::closeDaySubwindow() {
+    _dayMinima[_dayNext] = _daySubwindowMinimum;
+    _dayNext = (_dayNext + 1) % DAY_SUBWINDOWS;
+    _daySubwindowMinimum = INFINITY;
+    _daySubwindowCount = 0;
+
+    _dayMinimum = INFINITY;
+    for (size_t i = 0; i < DAY_SUBWINDOWS; i++) {
+        if (_dayMinima[i] < _dayMinimum) {
+            _dayMinimum = _dayMinima[i];
+        }
+    }
+}
+
+void NoiseFloorTracker::seed(float floorPower) {
+    if (!(floorPower >= 0) || isinf(floorPower)) {
+        return;
+    }
+    reset();
+    float minimum = floorPower / BIAS_COMPENSATION;
+    for (size_t i = 0; i < SUBWINDOWS; i++) {
+        _minima[i] = minimum;
+    }
+    _horizonMinimum = minimum;
+    for (size_t i = 0; i < DAY_SUBWINDOWS; i++) {
+        _dayMinima[i] = minimum;
+    }
+    _dayMinimum = minimum;
+}
+
+float NoiseFloorTracker::getFloor() const {
+    float minimum = _subwindowMinimum < _horizonMinimum ? _subwindowMinimum : _horizonMinimum;
+    float ceiling = _dayMinimum * MAX_RISE;
+    if (minimum > ceiling) {
+        minimum = ceiling;
+    }
+    return isinf(minimum) ? 0 : minimum * BIAS_COMPENSATION;
+}
@@ -0,0 +1,82 @@
+#ifndef NOISE_FLOOR_H
+#define NOISE_FLOOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Minimum-statistics estimate of the stationary background (HVAC, fridges)
+// under a power signal.
+//
+// The input is smoothed over about a second, and the floor is the minimum of
+// the smoothed power over a sliding horizon of minutes: speech and crowd
+// noise come and go, so their lulls set the minimum, while a steady source
+// is present in every value. The horizon is split into SUBWINDOWS equal
+// parts whose minima are kept in a ring; each update compares against the
+// running sub-window minimum, and the ring is scanned only when a sub-window
+// closes, so the cost per update is constant and memory is fixed. The floor
+// drops as soon as the background does and rises within one horizon.
+//
+// A crowd that stays loud for longer than the horizon would otherwise become
+// the floor itself. The closed sub-window minima therefore also feed a
+// second ring spanning a day, and the floor is held to at most MAX_RISE
+// above that day's quietest stretch: a busy service cannot lift it, at the
+// price that a background which really steps up by more than MAX_RISE is
+// only fully learned once the quieter past has left the day ring.
+class NoiseFloorTracker {
+public:
+    NoiseFloorTracker();
+
+    void reset();
+
+    // Seconds between addPower() calls; sets the smoothing and the number of
+    // updates per sub-window. Resets the tracker.
+    void setUpdateInterval(float seconds);
+
+    void addPower(float power);
+
+    // Starts from a floor saved earlier instead of from nothing: the whole
+    // horizon is taken to have had this minimum
+    void seed(float floorPower);
+
+    // Bias-compensated floor; 0 until warm-up has passed
+    float getFloor() const;
+
+    static constexpr size_t SUBWINDOWS = 8;
+    static constexpr float HORIZON_SECONDS = 600.0f;   // Longer than any crowd lull
+    static constexpr float SMOOTHING_SECONDS = 1.0f;
+    // Envelopes upstream start from zero; their rise is not a quiet room
+    static constexpr float WARMUP_SECONDS = 3.0f;
+    // The minimum of a fluctuating power sits below its mean; this restores
+    // roughly the mean of a steady source (about +1.8 dB)
+    static constexpr float BIAS_COMPENSATION = 1.5f;
+    // Longest the quiet reference is kept, and how far (power ratio, about
+    // 6 dB) the floor may sit above it
+    static constexpr size_t DAY_SUBWINDOWS = 8;
+    static constexpr float DAY_HORIZON_SECONDS = 86400.0f;
+    static constexpr float MAX_RISE = 4.0f;
+
+private:
+    float _smoothing;
+    uint32_t _subwindowUpdates;
+    uint32_t _warmupUpdates;
+
+    float _smoothed;
+    bool _primed;
+    uint32_t _updates;         // Saturates at _warmupUpdates
+    float _subwindowMinimum;   // Running minimum of the open sub-window
+    uint32_t _subwindowCount;  // Updates in the open sub-window
+    float _minima[SUBWINDOWS]; // Closed sub-windows, oldest overwritten first
+    size_t _next;
+    float _horizonMinimum;     // Minimum of _minima
+
+    float _daySubwindowMinimum;        // Closed sub-windows of the open day sub-window
+    uint32_t _daySubwindowCount;       // Sub-windows closed into it
+    float _dayMinima[DAY_SUBWINDOWS];  // Closed day sub-windows, oldest overwritten first
+    size_t _dayNext;
+    float _dayMinimum;                 // Minimum of _dayMinima and _daySubwindowMinimum
+
+    void closeSubwindow();
+    void closeDaySubwindow();
+};
+
+#endif // NOISE_FLOOR_H
@@ -0,0 +1,72 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <tuple>
+
+// Fraction bits of the working signal written by DcRemoval; weighting and
+// energy stages rely on this headroom
+constexpr int PIPELINE_SIGNAL_SHIFT = 8;
+
+// Per-block data handed from stage to stage. Stages that produce a buffer own
+// it and publish a pointer here, so a pipeline without them carries no buffer.
+template <size_t BlockSize>
+struct PipelineFrame {
+    static constexpr size_t SIZE = BlockSize;
+
+    const uint16_t* raw = nullptr;  // Biased ADC counts from the source
+    int32_t* signal = nullptr;      // DC-free, scaled by 2^PIPELINE_SIGNAL_SHIFT
+    int32_t dcOffset = 0;           // Rounded DC estimate in ADC counts
+    uint16_t blockMin = 0;          // Raw extremes and samples at the ADC rails,
+    uint16_t blockMax = 0;          // from the peak-to-peak detector's pass
+    uint16_t clippedSamples = 0;
+    bool windowComplete = false;    // This block closes a sample window
+    float measure = 0;              // Window detector output, refined by envelopes
+    float level = 0;                // 0-1 level from the mapping stage
+};
+
+// Block-processing chain composed at compile time.
+//
+// Source supplies the constexpr SAMPLE_RATE and BLOCK_SIZE; each Stage has a
+// process(Frame&) that runs once per block, in the order listed. Stages are
+// held by value in a tuple and called through a fold expression, so the
+// whole chain inlines into one function, per-sample loops see a constant
+// trip count, and a stage that is not listed costs neither cycles nor RAM.
+// Stages are reached by type with get<Stage>() for configuration and results.
+template <typename Source, typename... Stages>
+class Pipeline {
+public:
+    static constexpr uint32_t SAMPLE_RATE = Source::SAMPLE_RATE;
+    static constexpr size_t BLOCK_SIZE = Source::BLOCK_SIZE;
+    using Frame = PipelineFrame<BLOCK_SIZE>;
+
+    // Runs one block of BLOCK_SIZE raw samples through every stage; returns
+    // true if the block completed a sample window
+    bool process(const uint16_t* block) {
+        _frame.raw = block;
+        _frame.windowComplete = false;
+        std::apply([this](Stages&... stages) { (stages.process(_frame), ...); }, _stages);
+        return _frame.windowComplete;
+    }
+
+    template <typename Stage>
+    Stage& get() {
+        return std::get<Stage>(_stages);
+    }
+
+    template <typename Stage>
+    const Stage& get() const {
+        return std::get<Stage>(_stages);
+    }
+
+    const Frame& frame() const {
+        return _frame;
+    }
+
+private:
+    std::tuple<Stages...> _stages;
+    Frame _frame;
+};
+
+#endif // PIPELINE_H
@@ -0,0 +1,368 @@
+#ifndef PIPELINE_STAGES_H
+#define PIPELINE_STAGES_H
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "fast_math.h"
+#include "pipeline.h"
+#include "sample_source.h"
+#include "weighting_filter.h"
+#include "leq_meter.h"
+#include "level_percentiles.h"
+#include "band_analyzer.h"
+#include "signal_diagnostics.h"
+#include "transient_filter.h"
+#include "chatter_detector.h"
+
+// Stages for Pipeline<Source, Stage...>. Framing goes first; DcRemoval must
+// precede anything that reads frame.signal or frame.dcOffset; detectors set
+// frame.measure when a window completes, envelopes smooth it and mappings
+// turn it into frame.level.
+
+// Groups blocks into sample windows (50 ms -> 3 blocks of 16 ms)
+class WindowFraming {
+public:
+    void setBlocksPerWindow(size_t blocks) {
+        _blocksPerWindow = blocks == 0 ? 1 : blocks;
+    }
+
+    size_t getBlocksPerWindow() const {
+        return _blocksPerWindow;
+    }
+
+    // Rounds a window length in milliseconds to whole blocks
+    static size_t blocksForWindow(int windowMs) {
+        size_t windowSamples = static_cast<size_t>(windowMs) * SampleSource::SAMPLE_RATE / 1000;
+        return (windowSamples + SampleSource::BLOCK_SIZE / 2) / SampleSource::BLOCK_SIZE;
+    }
+
+    template <typename Frame>
+    void process(Frame& frame) {
+        if (++_blocks >= _blocksPerWindow) {
+            frame.windowComplete = true;
+            _blocks = 0;
+        }
+    }
+
+private:
+    size_t _blocksPerWindow = 3;
+    size_t _blocks = 0;
+};
+
+// Tracks the microphone bias and writes the DC-free, scaled signal
+template <size_t BlockSize>
+class DcRemoval {
+public:
+    int32_t getOffset() const {
+        return roundingShift(_dcOffset, FRACTION_BITS);
+    }
+
+    template <typename Frame>
+    void process(Frame& frame) {
+        static_assert(Frame::SIZE == BlockSize, "DcRemoval block size must match the pipeline");
+        const uint16_t* samples = frame.raw;
+
+        // Seed from the first block so downstream levels are valid immediately
+        if (_dcOffset < 0) {
+            uint32_t sum = 0;
+            for (size_t i = 0; i < BlockSize; i++) {
+                sum += samples[i];
+            }
+            _dcOffset = static_cast<int32_t>((sum << FRACTION_BITS) / BlockSize);
+        }
+
+        int32_t dc = getOffset();
+        uint32_t sum = 0;
+        for (size_t i = 0; i < BlockSize; i++) {
+            sum += samples[i];
+            _signal[i] = (static_cast<int32_t>(samples[i]) - dc) * (1 << PIPELINE_SIGNAL_SHIFT);
+        }
+        int32_t blockMean = static_cast<int32_t>((sum << FRACTION_BITS) / BlockSize);
+        _dcOffset += (blockMean - _dcOffset) >> TRACK_SHIFT;
+
+        frame.signal = _signal;
+        frame.dcOffset = dc;
+    }
+
+private:
+    static constexpr int FRACTION_BITS = 8;
+    static constexpr int TRACK_SHIFT = 6;  // ~64 blocks, about one second
+
+    int32_t _dcOffset = -1;  // Q8 ADC counts, -1 until seeded
+    int32_t _signal[BlockSize];
+};
+
+// Peak-to-peak of the raw samples over the window. Samples at the ADC rails
+// count like any other, so a clipping input reads as full scale instead of
+// falling back to whatever stayed in range. The same pass publishes the
+// block's extremes and clip count for SignalDiagnosticsStage.
+class PeakToPeakDetector {
+public:
+    unsigned int getPeakToPeak() const {
+        return _lastPeakToPeak;
+    }
+
+    template <typename Frame>
+    void process(Frame& frame) {
+        uint16_t blockMin = SampleSource::ADC_MAX;
+        uint16_t blockMax = 0;
+        uint16_t clipped = 0;
+        for (size_t i = 0; i < Frame::SIZE; i++) {
+            uint16_t sample = frame.raw[i];
+            blockMax = sample > blockMax ? sample : blockMax;
+            blockMin = sample < blockMin ? sample : blockMin;
+            clipped += (sample >= SampleSource::ADC_MAX) | (sample == 0);
+        }
+        frame.blockMin = blockMin;
+        frame.blockMax = blockMax;
+        frame.clippedSamples = clipped;
+
+        if (blockMax > _signalMax) {
+            _signalMax = blockMax;
+        }
+        if (blockMin < _signalMin) {
+            _signalMin = blockMin;
+        }
+        if (frame.windowComplete) {
+            _lastPeakToPeak = _signalMax > _signalMin ? _signalMax - _signalMin : 0;
+            frame.measure = static_cast<float>(_lastPeakToPeak);
+            _signalMax = 0;
+            _signalMin = SampleSource::ADC_MAX;
+        }
+    }
+
+private:
+    unsigned int _signalMax = 0;
+    unsigned int _signalMin = SampleSource::ADC_MAX;
+    unsigned int _lastPeakToPeak = 0;
+};
+
+// Clip, flat-line, bias and noise-floor checks on every block; must follow
+// PeakToPeakDetector and DcRemoval
+class SignalDiagnosticsStage {
+public:
+    const SignalHealth& getHealth() const {
+        return _diagnostics.getHealth();
+    }
+
+    template <typename Frame>
+    void process(Frame& frame) {
+        _diagnostics.addBlock(frame.blockMin, frame.blockMax, frame.clippedSamples, frame.dcOffset);
+    }
+
+private:
+    SignalDiagnostics _diagnostics;
+};
+
+// Hampel filter on frame.measure, once per window: an impulse (door slam,
+// dropped tray) is replaced by the median of recent windows before it can
+// reach the envelope
+class TransientRejection {
+public:
+    // Resets the history only when the window changes
+    void configure(size_t window, float threshold) {
+        if (window != _filter.getWindow()) {
+            _filter.setWindow(window);
+        }
+        _filter.setThreshold(threshold);
+    }
+
+    uint32_t getRejectedCount() const {
+        return _filter.getRejectedCount();
+    }
+
+    template <typename Frame>
+    void process(Frame& frame) {
+        if (frame.windowComplete) {
+            frame.measure = _filter.process(frame.measure);
+        }
+    }
+
+private:
+    HampelFilter _filter;
+};
+
+// Exponential moving average of frame.measure, once per window
+class EmaEnvelope {
+public:
+    void setAlpha(float alpha) {
+        if (alpha > 0 && alpha <= 1) {
+            _alpha = alpha;
+        }
+    }
+
+    float getAlpha() const {
+        return _alpha;
+    }
+
+    float getValue() const {
+        return _value;
+    }
+
+    template <typename Frame>
+    void process(Frame& frame) {
+        if (frame.windowComplete) {
+            _value = _alpha * frame.measure + (1 - _alpha) * _value;
+            frame.measure = _value;
+        }
+    }
+
+private:
+    float _alpha = 0.2f;
+    float _value = 0;
+};
+
+// Legacy mapping: square root of the measure normalized to full scale
+class SqrtLevelMapping {
+public:
+    template <typename Frame>
+    void process(Frame& frame) {
+        if (frame.windowComplete) {
+            float normalizedSignal = frame.measure / 4095.0; // Normalize to 0-1 range
+            frame.level = fastSqrt(normalizedSignal); // Apply square root to increase sensitivity to lower sounds
+        }
+    }
+};
+
+// Crowd-chatter features of the unweighted signal; must precede WeightingStage
+class ChatterDetectionStage {
+public:
+    const ChatterDetector& detector() const {
+        return _detector;
+    }
+
+    template <typename Frame>
+    void process(Frame& frame) {
+        _detector.addBlock(frame.signal, Frame::SIZE, PIPELINE_SIGNAL_SHIFT);
+    }
+
+private:
+    ChatterDetector _detector;
+};
+
+// A/C/Z weighting of frame.signal in place
+template <uint32_t SampleRate>
+class WeightingStage {
+public:
+    void setWeighting(Weighting weighting) {
+        if (weighting != _filter.getWeighting()) {
+            _filter.setWeighting(weighting);
+        }
+    }
+
+    Weighting getWeighting() const {
+        return _filter.getWeighting();
+    }
+
+    template <typename Frame>
+    void process(Frame& frame) {
+        _filter.process(frame.signal, Frame::SIZE);
+    }
+
+private:
+    WeightingFilter<SampleRate> _filter{Weighting::A};
+};
+
+// Energy of frame.signal into the Leq windows and the percentile window
+// (one short Leq value per SLOT_BLOCKS blocks)
+class LeqStatistics {
+public:
+    static constexpr size_t SLOT_BLOCKS = 8;  // 128 ms per percentile value
+
+    LeqMeter& meter() {
+        return _leqMeter;
+    }
+
+    const LeqMeter& meter() const {
+        return _leqMeter;
+    }
+
+    LevelPercentiles& percentiles() {
+        return _percentiles;
+    }
+
+    const LevelPercentiles& percentiles() const {
+        return _percentiles;
+    }
+
+    template <typename Frame>
+    void process(Frame& frame) {
+        uint64_t sumSquares = 0;
+        for (size_t i = 0; i < Frame::SIZE; i++) {
+            int64_t value = frame.signal[i];
+            sumSquares += static_cast<uint64_t>(value * value);
+        }
+        // Back to ADC counts squared
+        sumSquares = roundingShift(sumSquares, 2 * PIPELINE_SIGNAL_SHIFT);
+        _leqMeter.addBlock(sumSquares, Frame::SIZE);
+
+        _slotSumSquares += sumSquares;
+        if (++_slotBlocks >= SLOT_BLOCKS) {
+            _percentiles.add(LeqMeter::toDbfs(_slotSumSquares, _slotBlocks * Frame::SIZE));
+            _slotSumSquares = 0;
+            _slotBlocks = 0;
+        }
+    }
+
+private:
+    LeqMeter _leqMeter;
+    LevelPercentiles _percentiles;
+    uint64_t _slotSumSquares = 0;
+    size_t _slotBlocks = 0;
+};
+
+// Octave / third-octave bands of the unweighted signal; results of the last
+// completed window stay available until the next one
+class BandAnalysisStage {
+public:
+    void setMode(BandMode mode) {
+        _analyzer.setMode(mode);
+    }
+
+    BandMode getMode() const {
+        return _analyzer.getMode();
+    }
+
+    // True if the last completed window produced band levels
+    bool hasResult() const {
+        return _bandCount > 0;
+    }
+
+    size_t getBandCount() const {
+        return _bandCount;
+    }
+
+    const float* getBandDbfs() const {
+        return _bandDbfs;
+    }
+
+    float getSpeechMeanSquare() const {
+        return _speechMeanSquare;
+    }
+
+    template <typename Frame>
+    void process(Frame& frame) {
+        _analyzer.addBlock(frame.raw, Frame::SIZE, frame.dcOffset);
+        if (frame.windowComplete) {
+            _bandCount = _analyzer.finishWindow(_bandDbfs, _speechMeanSquare)
+                       ? _analyzer.getBandCount() : 0;
+        }
+    }
+
+private:
+    BandAnalyzer _analyzer;
+    size_t _bandCount = 0;
+    float _bandDbfs[BandAnalyzer::MAX_BANDS] = {};
+    float _speechMeanSquare = 0;
+};
+
+// The original SoundSensor level: peak-to-peak, EMA, square root. Kept as the
+// reference test_legacy_pipeline holds SoundSensor's peak-to-peak mode to
+using LegacyLevelPipeline = Pipeline<SampleSource,
+                                     WindowFraming,
+                                     PeakToPeakDetector,
+                                     EmaEnvelope,
+                                     SqrtLevelMapping>;
+
+#endif // PIPELINE_STAGES_H
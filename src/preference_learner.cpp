@@ -0,0 +1,93 @@
+#include "preference_learner.h"
+#include <math.h>
+#include "fast_math.h"
+
+namespace {
+
+// Prior covariance: no correction, as sure as PRIOR_WEIGHT overrides
+// LEVEL_SPREAD apart would make it
+constexpr float PRIOR_OFFSET_VARIANCE = 1.0f / PreferenceLearner::PRIOR_WEIGHT;
+constexpr float PRIOR_SLOPE_VARIANCE =
+    1.0f / (PreferenceLearner::PRIOR_WEIGHT * PreferenceLearner::LEVEL_SPREAD * PreferenceLearner::LEVEL_SPREAD);
+
+float clampf(float value, float limit) {
+    return fmaxf(-limit, fminf(limit, value));
+}
+
+}  // namespace
+
+PreferenceLearner::PreferenceLearner()
+    : _recent()
+    , _recentCount(0)
+    , _recentNext(0) {
+    reset();
+}
+
+void PreferenceLearner::addOverride(const OverrideSample& sample, float baseTarget) {
+    _recent[_recentNext] = sample;
+    _recentNext = (_recentNext + 1) % MAX_RECENT;
+    if (_recentCount < MAX_RECENT) {
+        _recentCount++;
+    }
+
+    // Recursive least squares on x = (1, level - pivot) with forgetting
+    float x0 = 1.0f;
+    float x1 = sample.level - PIVOT_LEVEL;
+    float* p = _model.covariance;  // p[0] p[1] / p[1] p[2]
+    float px0 = p[0] * x0 + p[1] * x1;
+    float px1 = p[1] * x0 + p[2] * x1;
+    float denominator = FORGETTING + x0 * px0 + x1 * px1;
+    float k0 = px0 / denominator;
+    float k1 = px1 / denominator;
+
+    float residual = clampf(sample.volume - baseTarget, MAX_RESIDUAL);
+    float error = residual - (_model.offset * x0 + _model.slope * x1);
+    _model.offset = clampf(_model.offset + k0 * error, MAX_OFFSET);
+    _model.slope = clampf(_model.slope + k1 * error, MAX_SLOPE);
+
+    p[0] = (p[0] - k0 * px0) / FORGETTING;
+    p[1] = (p[1] - k0 * px1) / FORGETTING;
+    p[2] = (p[2] - k1 * px1) / FORGETTING;
+    // Forgetting inflates what the overrides say nothing about; never beyond the prior
+    p[0] = fminf(p[0], PRIOR_OFFSET_VARIANCE);
+    p[2] = fminf(p[2], PRIOR_SLOPE_VARIANCE);
+    float bound = fastSqrt(p[0] * p[2]);
+    p[1] = fmaxf(-bound, fminf(bound, p[1]));
+    _model.samples++;
+}
+
+float PreferenceLearner::getCorrection(float level) const {
+    return clampf(_model.offset + _model.slope * (level - PIVOT_LEVEL), MAX_CORRECTION);
+}
+
+const PreferenceModel& PreferenceLearner::getModel() const {
+    return _model;
+}
+
+bool PreferenceLearner::setModel(const PreferenceModel& model) {
+    const float* p = model.covariance;
+    if (!(fabsf(model.offset) <= MAX_OFFSET) || !(fabsf(model.slope) <= MAX_SLOPE) ||
+        !(p[0] > 0 && p[0] <= PRIOR_OFFSET_VARIANCE) || !(p[2] > 0 && p[2] <= PRIOR_SLOPE_VARIANCE) ||
+        !(fabsf(p[1]) <= fastSqrt(p[0] * p[2]))) {
+        return false;
+    }
+    _model = model;
+    return true;
+}
+
+void PreferenceLearner::reset() {
+    _model.offset = 0;
+    _model.slope = 0;
+    _model.covariance[0] = PRIOR_OFFSET_VARIANCE;
+    _model.covariance[1] = 0;
+    _model.covariance[2] = PRIOR_SLOPE_VARIANCE;
+    _model.samples = 0;
+}
+
+size_t PreferenceLearner::getRecentCount() const {
+    return _recentCount;
+}
+
+const OverrideSample& PreferenceLearner::getRecent(size_t index) const {
+    return _recent[(_recentNext + MAX_RECENT - 1 - index) % MAX_RECENT];
+}
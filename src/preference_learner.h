@@ -0,0 +1,75 @@
+#ifndef PREFERENCE_LEARNER_H
+#define PREFERENCE_LEARNER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// A manual volume change: what staff chose, at what ambient level
+struct OverrideSample {
+    float level;         // Ambient level of the decision before the change
+    uint8_t fromVolume;
+    uint8_t volume;      // Chosen volume
+    uint32_t time;       // Unix seconds, 0 if the clock was not set
+};
+
+// Learned correction of the level-to-volume mapping, as stored in NVS:
+// offset + slope * (level - PIVOT_LEVEL) steps, with the regression's
+// covariance (upper triangle) so learning resumes where it left off
+struct PreferenceModel {
+    float offset;
+    float slope;
+    float covariance[3];
+    uint32_t samples;
+};
+
+// Learns how staff want the volume from the overrides they make.
+//
+// Each override gives the residual between the chosen volume and the
+// volume the mapping (venue calibration or sensitivity, plus the schedule's
+// bias) asked for at that level. A recursive least squares fit of the
+// residual as a line in the level tracks it, forgetting old overrides with
+// FORGETTING per override so the model follows a change of staff or taste.
+//
+// Bounded on every side, so a single "party mode" blast cannot wreck the
+// mapping: the regression starts from a prior of no correction worth
+// PRIOR_WEIGHT overrides, each residual counts at most MAX_RESIDUAL steps,
+// the covariance never grows past the prior's (no windup while all
+// overrides come at one level), and the correction stays within
+// MAX_CORRECTION steps.
+class PreferenceLearner {
+public:
+    PreferenceLearner();
+
+    // Learns from one override; baseTarget is the unrounded volume the
+    // mapping asked for at the sample's level, before any correction
+    void addOverride(const OverrideSample& sample, float baseTarget);
+
+    // Steps to add to the mapping's target at an ambient level
+    float getCorrection(float level) const;
+
+    const PreferenceModel& getModel() const;
+    bool setModel(const PreferenceModel& model);
+    void reset();
+
+    // Recent overrides, newest first
+    size_t getRecentCount() const;
+    const OverrideSample& getRecent(size_t index) const;
+
+    static constexpr float PIVOT_LEVEL = 0.25f;      // Typical ambient level; offset applies here
+    static constexpr float PRIOR_WEIGHT = 2.0f;      // Overrides' worth of "no correction"
+    static constexpr float LEVEL_SPREAD = 0.1f;      // Typical distance of a level from the pivot
+    static constexpr float FORGETTING = 0.9f;        // Weight left to earlier overrides per new one
+    static constexpr float MAX_RESIDUAL = 6.0f;      // Steps; larger disagreements count as this
+    static constexpr float MAX_OFFSET = 4.0f;        // Steps
+    static constexpr float MAX_SLOPE = 16.0f;        // Steps per unit level
+    static constexpr float MAX_CORRECTION = 4.0f;    // Steps
+    static constexpr size_t MAX_RECENT = 8;
+
+private:
+    PreferenceModel _model;
+    OverrideSample _recent[MAX_RECENT];
+    size_t _recentCount;
+    size_t _recentNext;
+};
+
+#endif // PREFERENCE_LEARNER_H
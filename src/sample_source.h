@@ -0,0 +1,77 @@
+#ifndef SAMPLE_SOURCE_H
+#define SAMPLE_SOURCE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Capture runs this many times faster than the analysis rate and SoundSensor
+// decimates back down (CIC + compensating FIR). 1 (off), 2 or 4; the ADC's
+// conversion rate limits it further with several channels, see below.
+#ifndef SOUND_DECIMATION_FACTOR
+#define SOUND_DECIMATION_FACTOR 1
+#endif
+
+// Microphones scanned in one interleaved ADC pass. Capture buffers and the
+// per-channel analysis pipelines are sized by it, so RAM grows linearly.
+#ifndef SOUND_CHANNEL_COUNT
+#define SOUND_CHANNEL_COUNT 1
+#endif
+
+// Producer of fixed-size blocks of raw 12-bit ADC samples captured at a fixed
+// rate. The firmware uses the I2S/ADC DMA engine; host builds can implement
+// this interface to feed synthetic or recorded blocks through SoundSensor.
+class SampleSource {
+public:
+    virtual ~SampleSource() {}
+
+    virtual bool begin() = 0;
+    virtual void end() = 0;
+
+    // Copies the next complete block of CAPTURE_BLOCK_SIZE samples of every
+    // channel into buffer, one channel after the other (CHANNELS *
+    // CAPTURE_BLOCK_SIZE samples). Waits at most timeoutMs for one to become
+    // available; returns false if none did. A timeout of 0 never blocks.
+    virtual bool readBlock(uint16_t* buffer, uint32_t timeoutMs) = 0;
+
+    // Number of blocks lost because the consumer fell behind
+    virtual uint32_t getOverrunCount() const { return 0; }
+
+    // Lets the given number of block periods pass without delivering them,
+    // stopping the capture where the source can; the next block read is the
+    // first one after. Returns false if the source ended. The default reads
+    // the blocks into buffer and drops them.
+    virtual bool standby(uint16_t* buffer, uint32_t blocks) {
+        for (uint32_t i = 0; i < blocks; i++) {
+            if (!readBlock(buffer, 4 * BLOCK_MS)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Analysis format seen by SoundSensor after decimation
+    static constexpr uint32_t SAMPLE_RATE = 32000;  // Hz
+    static constexpr size_t BLOCK_SIZE = 512;       // samples (16 ms)
+    static constexpr uint32_t BLOCK_MS = BLOCK_SIZE * 1000 / SAMPLE_RATE;
+    static constexpr uint16_t ADC_MAX = 4095;       // 12-bit full scale
+
+    // Capture format shared by every source
+    static constexpr uint32_t DECIMATION = SOUND_DECIMATION_FACTOR;
+    static constexpr uint32_t CAPTURE_RATE = SAMPLE_RATE * DECIMATION;
+    static constexpr size_t CAPTURE_BLOCK_SIZE = BLOCK_SIZE * DECIMATION;
+
+    // ADC1 has 8 channels, the ones usable while WiFi runs
+    static constexpr size_t CHANNELS = SOUND_CHANNEL_COUNT;
+    static_assert(CHANNELS >= 1 && CHANNELS <= 8, "SOUND_CHANNEL_COUNT must be 1 to 8");
+
+    // Total conversions per second the I2S ADC mode sustains reliably, shared
+    // by all channels: factor 1 takes up to 6 channels, 2 up to 3, 4 just one
+    static constexpr uint32_t MAX_CONVERSION_RATE = 200000;
+    static_assert(DECIMATION == 1 || DECIMATION == 2 || DECIMATION == 4,
+                  "SOUND_DECIMATION_FACTOR must be 1, 2 or 4");
+    static_assert(CAPTURE_RATE * CHANNELS <= MAX_CONVERSION_RATE,
+                  "Over 200 kHz of ADC conversions: SOUND_DECIMATION_FACTOR 1 allows up to 6 channels "
+                  "(SOUND_CHANNEL_COUNT), 2 up to 3, and 4 only one");
+};
+
+#endif // SAMPLE_SOURCE_H
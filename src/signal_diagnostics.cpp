@@ -0,0 +1,88 @@
+#include "signal_diagnostics.h"
+
+SignalDiagnostics::SignalDiagnostics() {
+    reset();
+}
+
+void SignalDiagnostics::reset() {
+    _health = SignalHealth();
+    _initialDcOffset = -1;
+    _flatRun = 0;
+    _clipHold = 0;
+    _periodBlocks = 0;
+    _periodMinimum = UINT16_MAX;
+}
+
+void SignalDiagnostics::addBlock(uint16_t blockMin, uint16_t blockMax, uint16_t clippedSamples,
+                                 int32_t dcOffset) {
+    uint8_t faults = 0;
+    uint16_t peakToPeak = blockMax > blockMin ? blockMax - blockMin : 0;
+
+    // Clipping: counted, and held for a second so a short burst is seen
+    if (clippedSamples > 0) {
+        _health.clippedSamples += clippedSamples;
+        _health.clippedBlocks++;
+        _clipHold = CLIP_HOLD_BLOCKS;
+    } else if (_clipHold > 0) {
+        _clipHold--;
+    }
+    if (_clipHold > 0) {
+        faults |= SIGNAL_FAULT_CLIPPING;
+    }
+
+    // Flat line: a live ADC input always moves by a few counts
+    if (peakToPeak <= FLAT_PEAK_TO_PEAK) {
+        _health.flatBlocks++;
+        if (_flatRun < FLAT_BLOCKS) {
+            _flatRun++;
+        }
+    } else {
+        _flatRun = 0;
+    }
+    if (_flatRun >= FLAT_BLOCKS) {
+        faults |= SIGNAL_FAULT_FLAT;
+    }
+
+    // Bias: tracked against the first block to show slow drift
+    if (_initialDcOffset < 0) {
+        _initialDcOffset = dcOffset;
+    }
+    _health.dcOffset = static_cast<int16_t>(dcOffset);
+    _health.dcDrift = static_cast<int16_t>(dcOffset - _initialDcOffset);
+    if (dcOffset < DC_MIN || dcOffset > DC_MAX) {
+        faults |= SIGNAL_FAULT_DC_RANGE;
+    }
+
+    // Noise floor: the quietest block of each period
+    if (peakToPeak < _periodMinimum) {
+        _periodMinimum = peakToPeak;
+    }
+    if (++_periodBlocks >= NOISE_PERIOD_BLOCKS) {
+        _health.noiseFloor = _periodMinimum;
+        _periodMinimum = UINT16_MAX;
+        _periodBlocks = 0;
+    }
+    if (_health.noiseFloor > NOISE_FLOOR_MAX) {
+        faults |= SIGNAL_FAULT_NOISE_FLOOR;
+    }
+
+    _health.faults = faults;
+}
+
+const SignalHealth& SignalDiagnostics::getHealth() const {
+    return _health;
+}
+
+const char* SignalDiagnostics::getFaultName(SignalFault fault) {
+    switch (fault) {
+    case SIGNAL_FAULT_CLIPPING:
+        return "clipping";
+    case SIGNAL_FAULT_FLAT:
+        return "flat";
+    case SIGNAL_FAULT_DC_RANGE:
+        return "dc-range";
+    case SIGNAL_FAULT_NOISE_FLOOR:
+        return "noise-floor";
+    }
+    return "unknown";
+}
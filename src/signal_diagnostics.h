@@ -0,0 +1,60 @@
+#ifndef SIGNAL_DIAGNOSTICS_H
+#define SIGNAL_DIAGNOSTICS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Microphone and ADC faults, as bits of SignalHealth::faults
+enum SignalFault : uint8_t {
+    SIGNAL_FAULT_CLIPPING = 1 << 0,     // Samples at the ADC rails in the last second
+    SIGNAL_FAULT_FLAT = 1 << 1,         // No signal movement for a second: stuck or dead input
+    SIGNAL_FAULT_DC_RANGE = 1 << 2,     // Bias far from mid-scale: mic supply or wiring lost
+    SIGNAL_FAULT_NOISE_FLOOR = 1 << 3   // Quietest block in 10 s implausibly loud: oscillation or EMI
+};
+
+// Snapshot of the diagnostics, published with every reading. Counters run
+// from boot and wrap.
+struct SignalHealth {
+    uint32_t clippedSamples;  // Samples at 0 or ADC_MAX
+    uint32_t clippedBlocks;   // Blocks with at least one of them
+    uint32_t flatBlocks;      // Blocks with no more than FLAT_PEAK_TO_PEAK movement
+    int16_t dcOffset;         // Current bias estimate, ADC counts
+    int16_t dcDrift;          // Bias change since the first block
+    uint16_t noiseFloor;      // Smallest block peak-to-peak of the last period
+    uint8_t faults;           // SignalFault bits
+};
+
+// Per-block health checks of the raw capture. Works from statistics the
+// peak-to-peak detector already gathers in its pass over the samples (block
+// min, max and clip count) plus the DC tracker's offset, so it adds no
+// per-sample work.
+class SignalDiagnostics {
+public:
+    SignalDiagnostics();
+
+    void reset();
+    void addBlock(uint16_t blockMin, uint16_t blockMax, uint16_t clippedSamples, int32_t dcOffset);
+
+    const SignalHealth& getHealth() const;
+
+    // Names of fault bits for logs and the status API
+    static const char* getFaultName(SignalFault fault);
+
+    static constexpr uint16_t FLAT_PEAK_TO_PEAK = 2;     // ADC noise alone exceeds this
+    static constexpr uint16_t FLAT_BLOCKS = 62;          // ~1 s of 16 ms blocks
+    static constexpr uint16_t CLIP_HOLD_BLOCKS = 62;     // Clipping fault lasts ~1 s
+    static constexpr int32_t DC_MIN = 256;               // Plausible bias range of an
+    static constexpr int32_t DC_MAX = 3840;              // AC-coupled mic module
+    static constexpr uint16_t NOISE_PERIOD_BLOCKS = 625; // ~10 s
+    static constexpr uint16_t NOISE_FLOOR_MAX = 2048;    // Half-scale movement in every block
+
+private:
+    SignalHealth _health;
+    int32_t _initialDcOffset;
+    uint16_t _flatRun;
+    uint16_t _clipHold;
+    uint16_t _periodBlocks;
+    uint16_t _periodMinimum;
+};
+
+#endif // SIGNAL_DIAGNOSTICS_H
@@ -1,38 +1,491 @@
 #include "sound_sensor.h"
+#include "fast_math.h"
 
-SoundSensor::SoundSensor(int pin, int sampleWindow, float alpha)
-    : _pin(pin)
+// Peak-to-peak over RMS of a sine; scales the Leq level so a steady tone
+// reads the same in both level modes
+static constexpr float SINE_PEAK_TO_PEAK_PER_RMS = 2.8284271f;
+
+SoundSensor::SoundSensor(SampleSource& source, int sampleWindow, float alpha)
+    : _source(source)
     , _sampleWindow(sampleWindow)
-    , _alpha(alpha)
-    , _filteredSignal(0) {
-    pinMode(_pin, INPUT);
+    , _level(0)
+    , _calibrationOffset(0)
+    , _blockCount(0)
+    , _windowCount(0)
+    , _droppedReadings(0)
+    , _settingsVersion(0)
+    , _requestedWeighting(static_cast<uint8_t>(Weighting::A))
+    , _requestedBandMode(static_cast<uint8_t>(BandMode::OFF))
+    , _requestedTransientWindow(HampelFilter::DEFAULT_WINDOW)
+    , _requestedTransientThreshold(HampelFilter::DEFAULT_THRESHOLD)
+    , _requestedStableSeconds(0)
+    , _requestedLevelMode(static_cast<uint8_t>(LevelMode::PEAK_TO_PEAK))
+    , _requestedAggregation(static_cast<uint8_t>(ChannelAggregation::MEAN))
+    , _requestedAlpha(alpha)
+    , _requestedNoiseFloorSeed(-1)
+    , _appliedSettingsVersion(1)
+    , _bandMode(BandMode::OFF)
+    , _levelMode(LevelMode::PEAK_TO_PEAK)
+    , _aggregation(ChannelAggregation::MEAN)
+    , _speechMeanSquare()
+    , _noiseFloorMode(LevelMode::PEAK_TO_PEAK)
+    , _percentileWindow(0)
+    , _standbyPending(false)
+    , _settlePending(false)
+    , _latest() {
+    for (size_t i = 0; i < LeqMeter::WINDOW_COUNT; i++) {
+        _latest.leqDbfs[i] = LeqMeter::MIN_DBFS;
+    }
+    for (size_t i = 0; i < SoundReading::PERCENTILE_COUNT; i++) {
+        _percentiles[i] = DEFAULT_PERCENTILES[i];
+        _latest.percentileDbfs[i] = LevelPercentiles::MIN_DB;
+    }
+    setPercentileWindow(DEFAULT_PERCENTILE_WINDOW);
+
+    size_t windowBlocks = WindowFraming::blocksForWindow(_sampleWindow);
+    for (size_t c = 0; c < SampleSource::CHANNELS; c++) {
+        _requestedChannelWeights[c] = 1.0f;
+        _channelWeights[c] = 1.0f;
+        _pipelines[c].get<WindowFraming>().setBlocksPerWindow(windowBlocks);
+        _pipelines[c].get<EmaEnvelope>().setAlpha(alpha);
+    }
+    _noiseFloor.setUpdateInterval(static_cast<float>(windowBlocks * SampleSource::BLOCK_SIZE) /
+                                  SampleSource::SAMPLE_RATE);
+}
+
+bool SoundSensor::begin() {
+    if (!_source.begin()) {
+        Serial.println("Sound sensor: failed to start sample source");
+        return false;
+    }
+    return true;
+}
+
+bool SoundSensor::process(uint32_t timeoutMs) {
+    if (_standbyPending) {
+        // Low duty: sit out the rest of the period, then spend one block on
+        // the ADC settling and the decimators refilling before the window
+        uint32_t periodBlocks = AdaptiveSampler::LOW_DUTY_PERIOD_MS * SampleSource::SAMPLE_RATE /
+                                (1000 * SampleSource::BLOCK_SIZE);
+        uint32_t activeBlocks = _pipelines[0].get<WindowFraming>().getBlocksPerWindow() + 1;
+        uint32_t standbyBlocks = periodBlocks > activeBlocks ? periodBlocks - activeBlocks : 0;
+        if (!_source.standby(_block, standbyBlocks)) {
+            return false;
+        }
+        _sampler.countStandby(standbyBlocks);
+        _standbyPending = false;
+        _settlePending = true;
+    }
+
+    if (!_source.readBlock(_block, timeoutMs)) {
+        return false;
+    }
+    for (size_t c = 0; c < SampleSource::CHANNELS; c++) {
+        _decimators[c].process(&_block[c * SampleSource::CAPTURE_BLOCK_SIZE], SampleSource::BLOCK_SIZE);
+    }
+    if (_settlePending) {
+        _settlePending = false;
+        _sampler.countSettling(1);
+        return true;
+    }
+    processBlock(_block);
+    return true;
+}
+
+const uint16_t* SoundSensor::getReferenceBlock() const {
+    return _block;
+}
+
+bool SoundSensor::poll(SoundReading& reading) {
+    if (!_readings.pop(reading)) {
+        return false;
+    }
+    _latest = reading;
+    return true;
 }
 
 float SoundSensor::getSoundLevel() {
-    unsigned long startMillis = millis();
-    unsigned int signalMax = 0;
-    unsigned int signalMin = 4095;
-    unsigned int sample;
-
-    while (millis() - startMillis < _sampleWindow) {
-        sample = analogRead(_pin);
-        if (sample < 4095) {
-            if (sample > signalMax) {
-                signalMax = sample;
-            } else if (sample < signalMin) {
-                signalMin = sample;
+    SoundReading reading;
+    while (poll(reading)) {
+    }
+    return _latest.level;
+}
+
+const SoundReading& SoundSensor::getLatestReading() const {
+    return _latest;
+}
+
+void SoundSensor::applySettings() {
+    uint32_t version = _settingsVersion.load();
+    if (version == _appliedSettingsVersion || (version & 1) != 0) {
+        return;  // Nothing new, or the consumer is halfway through an update
+    }
+    Weighting weighting = static_cast<Weighting>(_requestedWeighting.load());
+    BandMode bandMode = static_cast<BandMode>(_requestedBandMode.load());
+    size_t transientWindow = _requestedTransientWindow.load();
+    float transientThreshold = _requestedTransientThreshold.load();
+    uint16_t stableSeconds = _requestedStableSeconds.load();
+    LevelMode levelMode = static_cast<LevelMode>(_requestedLevelMode.load());
+    ChannelAggregation aggregation = static_cast<ChannelAggregation>(_requestedAggregation.load());
+    float channelWeights[SampleSource::CHANNELS];
+    for (size_t c = 0; c < SampleSource::CHANNELS; c++) {
+        channelWeights[c] = _requestedChannelWeights[c].load();
+    }
+    float alpha = _requestedAlpha.load();
+    if (_settingsVersion.load() != version) {
+        return;  // Changed while loading; take it at the next block
+    }
+
+    _appliedSettingsVersion = version;
+    _bandMode = bandMode;
+    _levelMode = levelMode;
+    _aggregation = aggregation;
+    for (size_t c = 0; c < SampleSource::CHANNELS; c++) {
+        _channelWeights[c] = channelWeights[c];
+        _pipelines[c].get<WeightingStage<SampleSource::SAMPLE_RATE>>().setWeighting(weighting);
+        _pipelines[c].get<TransientRejection>().configure(transientWindow, transientThreshold);
+        _pipelines[c].get<EmaEnvelope>().setAlpha(alpha);
+    }
+    if (stableSeconds != _sampler.getStableSeconds()) {
+        _sampler.setStableSeconds(stableSeconds);
+    }
+}
+
+void SoundSensor::beginSettingsUpdate() {
+    _settingsVersion.fetch_add(1);
+}
+
+void SoundSensor::endSettingsUpdate() {
+    _settingsVersion.fetch_add(1);
+}
+
+void SoundSensor::processBlock(uint16_t* samples) {
+    applySettings();
+
+    // Only the reference channel reports bands; the others need them for
+    // the speech level alone
+    BandMode speechBands = _levelMode == LevelMode::SPEECH ? BandMode::OCTAVE : BandMode::OFF;
+    BandMode bandMode = _bandMode == BandMode::OFF ? speechBands : _bandMode;
+    for (size_t c = 0; c < SampleSource::CHANNELS; c++) {
+        _pipelines[c].get<BandAnalysisStage>().setMode(c == 0 ? bandMode : speechBands);
+    }
+    // Read and cleared in one step, so a seed stored in between is not lost
+    if (_requestedNoiseFloorSeed.load(std::memory_order_relaxed) >= 0) {
+        float floorLevel = _requestedNoiseFloorSeed.exchange(-1);
+        if (floorLevel >= 0) {
+            _noiseFloor.seed(floorLevel * floorLevel * floorLevel * floorLevel);
+            _noiseFloorMode = _levelMode;
+        }
+    }
+
+    // Every channel frames the same blocks, so windows complete together
+    _blockCount++;
+    _sampler.countProcessed(1);
+    bool windowComplete = false;
+    for (size_t c = 0; c < SampleSource::CHANNELS; c++) {
+        windowComplete = _pipelines[c].process(&samples[c * SampleSource::CAPTURE_BLOCK_SIZE]);
+    }
+    if (windowComplete) {
+        finishWindow();
+    }
+}
+
+void SoundSensor::finishWindow() {
+    const SoundPipeline& reference = _pipelines[0];
+    const BandAnalysisStage& bands = reference.get<BandAnalysisStage>();
+    const LeqStatistics& statistics = reference.get<LeqStatistics>();
+
+    SoundReading reading;
+    reading.bandCount = static_cast<uint8_t>(bands.getBandCount());
+    for (size_t i = 0; i < reading.bandCount; i++) {
+        reading.bandDbfs[i] = bands.getBandDbfs()[i];
+    }
+
+    float chatterConfidences[SampleSource::CHANNELS];
+    for (size_t c = 0; c < SampleSource::CHANNELS; c++) {
+        reading.channelLevels[c] = computeChannelLevel(c);
+        reading.channelFaults[c] = _pipelines[c].get<SignalDiagnosticsStage>().getHealth().faults;
+        chatterConfidences[c] = _pipelines[c].get<ChatterDetectionStage>().detector().getConfidence();
+    }
+    _level = aggregate(reading.channelLevels, reading.channelLevels);
+
+    // A floor learned on another level scale means nothing on this one
+    if (_levelMode != _noiseFloorMode) {
+        _noiseFloor.reset();
+        _noiseFloorMode = _levelMode;
+    }
+    float levelSquared = _level * _level;
+    _noiseFloor.addPower(levelSquared * levelSquared);
+
+    reading.sequence = _windowCount++;
+    reading.timestamp = millis();
+    _sampler.addReading(_level, reading.timestamp);
+    _standbyPending = _sampler.isLowDuty();
+    reading.sampling = _sampler.getStats();
+    reading.level = _level;
+    reading.noiseFloor = sqrtf(sqrtf(_noiseFloor.getFloor()));
+    for (size_t i = 0; i < LeqMeter::WINDOW_COUNT; i++) {
+        reading.leqDbfs[i] = statistics.meter().getLeqDbfs(i);
+    }
+    for (size_t i = 0; i < SoundReading::PERCENTILE_COUNT; i++) {
+        reading.percentileDbfs[i] = statistics.percentiles().getLevel(_percentiles[i]);
+    }
+    reading.health = reference.get<SignalDiagnosticsStage>().getHealth();
+    reading.transientsRejected = reference.get<TransientRejection>().getRejectedCount();
+    reading.chatterConfidence = aggregate(chatterConfidences, reading.channelLevels);
+    reading.chatter = reference.get<ChatterDetectionStage>().detector().getFeatures();
+    if (!_readings.push(reading)) {
+        _droppedReadings++; // Consumer stalled; it will catch up on newer windows
+    }
+}
+
+float SoundSensor::computeChannelLevel(size_t channel) {
+    const SoundPipeline& pipeline = _pipelines[channel];
+    const BandAnalysisStage& bands = pipeline.get<BandAnalysisStage>();
+    float alpha = pipeline.get<EmaEnvelope>().getAlpha();
+    if (bands.hasResult()) {
+        _speechMeanSquare[channel] = alpha * bands.getSpeechMeanSquare() +
+                                     (1 - alpha) * _speechMeanSquare[channel];
+    }
+
+    if (_levelMode == LevelMode::LEQ) {
+        return meanSquareToLevel(pipeline.get<LeqStatistics>().meter().getMeanSquare(0));
+    } else if (_levelMode == LevelMode::SPEECH) {
+        return meanSquareToLevel(_speechMeanSquare[channel]);
+    }
+    // Same mapping as LegacyLevelPipeline, applied to the shared envelope
+    float normalizedSignal = pipeline.get<EmaEnvelope>().getValue() / 4095.0; // Normalize to 0-1 range
+    return fastSqrt(normalizedSignal); // Apply square root to increase sensitivity to lower sounds
+}
+
+float SoundSensor::aggregate(const float* values, const float* levels) const {
+    if (SampleSource::CHANNELS == 1) {
+        return values[0];
+    }
+    if (_aggregation == ChannelAggregation::MAX) {
+        // The loudest zone speaks for the room
+        size_t loudest = 0;
+        for (size_t c = 1; c < SampleSource::CHANNELS; c++) {
+            if (levels[c] > levels[loudest]) {
+                loudest = c;
             }
         }
+        return values[loudest];
     }
 
-    unsigned int peakToPeak = signalMax - signalMin;
-    _filteredSignal = _alpha * peakToPeak + (1 - _alpha) * _filteredSignal;
-    float normalizedSignal = _filteredSignal / 4095.0; // Normalize to 0-1 range
-    return pow(normalizedSignal, 0.5); // Apply square root to increase sensitivity to lower sounds
+    // Levels are combined as powers (level^4), like the feedback model, so a
+    // loud zone counts for what it adds to the room rather than its scale
+    // value; other values are plain weighted means
+    bool powers = values == levels;
+    float sum = 0;
+    float weightSum = 0;
+    for (size_t c = 0; c < SampleSource::CHANNELS; c++) {
+        float weight = _aggregation == ChannelAggregation::WEIGHTED ? _channelWeights[c] : 1.0f;
+        float value = values[c];
+        if (powers) {
+            value *= value;
+            value *= value;
+        }
+        sum += weight * value;
+        weightSum += weight;
+    }
+    if (!(weightSum > 0)) {
+        return values[0];
+    }
+    float mean = sum / weightSum;
+    return powers ? sqrtf(sqrtf(mean)) : mean;
+}
+
+float SoundSensor::meanSquareToLevel(float meanSquare) {
+    // Same shape as the legacy level: square root of a normalized amplitude
+    float rms = fastSqrt(meanSquare);
+    float normalized = rms * SINE_PEAK_TO_PEAK_PER_RMS / SampleSource::ADC_MAX;
+    return normalized >= 1.0f ? 1.0f : fastSqrt(normalized);
+}
+
+void SoundSensor::seedNoiseFloor(float floorLevel) {
+    if (floorLevel >= 0 && floorLevel <= 1) {
+        _requestedNoiseFloorSeed = floorLevel;
+    }
+}
+
+float SoundSensor::getNoiseFloor() const {
+    return _latest.noiseFloor;
 }
 
 void SoundSensor::setSensitivity(float alpha) {
-    if (alpha > 0 && alpha <= 1) {
-        _alpha = alpha;
+    beginSettingsUpdate();
+    _requestedAlpha = alpha;
+    endSettingsUpdate();
+}
+
+void SoundSensor::setLevelMode(LevelMode mode) {
+    beginSettingsUpdate();
+    _requestedLevelMode = static_cast<uint8_t>(mode);
+    endSettingsUpdate();
+}
+
+LevelMode SoundSensor::getLevelMode() const {
+    return static_cast<LevelMode>(_requestedLevelMode.load());
+}
+
+bool SoundSensor::setLeqWindow(size_t index, uint16_t seconds) {
+    // Every channel's Leq level follows the first window
+    for (SoundPipeline& pipeline : _pipelines) {
+        if (!pipeline.get<LeqStatistics>().meter().setWindow(index, seconds)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint16_t SoundSensor::getLeqWindow(size_t index) const {
+    return _pipelines[0].get<LeqStatistics>().meter().getWindow(index);
+}
+
+void SoundSensor::setWeighting(Weighting weighting) {
+    beginSettingsUpdate();
+    _requestedWeighting = static_cast<uint8_t>(weighting);
+    endSettingsUpdate();
+}
+
+Weighting SoundSensor::getWeighting() const {
+    return static_cast<Weighting>(_requestedWeighting.load());
+}
+
+bool SoundSensor::setPercentile(size_t index, uint8_t percentExceeded) {
+    if (index >= SoundReading::PERCENTILE_COUNT || percentExceeded == 0 || percentExceeded >= 100) {
+        return false;
+    }
+    _percentiles[index] = percentExceeded;
+    return true;
+}
+
+uint8_t SoundSensor::getPercentile(size_t index) const {
+    return index < SoundReading::PERCENTILE_COUNT ? _percentiles[index] : 0;
+}
+
+bool SoundSensor::setPercentileWindow(uint16_t seconds) {
+    if (seconds == 0 || seconds > MAX_PERCENTILE_WINDOW) {
+        return false;
+    }
+    size_t values = static_cast<size_t>(seconds) * SampleSource::SAMPLE_RATE /
+                    (LeqStatistics::SLOT_BLOCKS * SampleSource::BLOCK_SIZE);
+    if (!_pipelines[0].get<LeqStatistics>().percentiles().setWindow(values)) {
+        return false;
+    }
+    _percentileWindow = seconds;
+    return true;
+}
+
+uint16_t SoundSensor::getPercentileWindow() const {
+    return _percentileWindow;
+}
+
+void SoundSensor::setChannelAggregation(ChannelAggregation aggregation) {
+    beginSettingsUpdate();
+    _requestedAggregation = static_cast<uint8_t>(aggregation);
+    endSettingsUpdate();
+}
+
+ChannelAggregation SoundSensor::getChannelAggregation() const {
+    return static_cast<ChannelAggregation>(_requestedAggregation.load());
+}
+
+bool SoundSensor::setChannelWeight(size_t channel, float weight) {
+    if (channel >= SampleSource::CHANNELS || !(weight >= 0) || weight > MAX_CHANNEL_WEIGHT) {
+        return false;
     }
+    beginSettingsUpdate();
+    _requestedChannelWeights[channel] = weight;
+    endSettingsUpdate();
+    return true;
+}
+
+float SoundSensor::getChannelWeight(size_t channel) const {
+    return channel < SampleSource::CHANNELS ? _requestedChannelWeights[channel].load() : 0;
+}
+
+void SoundSensor::setBandMode(BandMode mode) {
+    beginSettingsUpdate();
+    _requestedBandMode = static_cast<uint8_t>(mode);
+    endSettingsUpdate();
+}
+
+BandMode SoundSensor::getBandMode() const {
+    return static_cast<BandMode>(_requestedBandMode.load());
+}
+
+static_assert(HampelFilter::MAX_WINDOW <= UINT8_MAX, "the requested transient window is stored as uint8_t");
+
+bool SoundSensor::setTransientFilter(size_t window, float threshold) {
+    if (!HampelFilter::isValidWindow(window) || !HampelFilter::isValidThreshold(threshold)) {
+        return false;
+    }
+    beginSettingsUpdate();
+    _requestedTransientWindow = static_cast<uint8_t>(window);
+    _requestedTransientThreshold = threshold;
+    endSettingsUpdate();
+    return true;
+}
+
+size_t SoundSensor::getTransientWindow() const {
+    return _requestedTransientWindow;
+}
+
+float SoundSensor::getTransientThreshold() const {
+    return _requestedTransientThreshold;
+}
+
+bool SoundSensor::setAdaptiveSampling(uint16_t stableSeconds) {
+    if (stableSeconds != 0 && (stableSeconds < AdaptiveSampler::MIN_STABLE_SECONDS ||
+                               stableSeconds > AdaptiveSampler::MAX_STABLE_SECONDS)) {
+        return false;
+    }
+    beginSettingsUpdate();
+    _requestedStableSeconds = stableSeconds;
+    endSettingsUpdate();
+    return true;
+}
+
+uint16_t SoundSensor::getAdaptiveSampling() const {
+    return _requestedStableSeconds;
+}
+
+void SoundSensor::setCalibrationOffset(float offsetDb) {
+    _calibrationOffset = offsetDb;
+}
+
+float SoundSensor::getCalibrationOffset() const {
+    return _calibrationOffset;
+}
+
+float SoundSensor::getLeqDbfs(size_t index) const {
+    if (index >= LeqMeter::WINDOW_COUNT) {
+        return LeqMeter::MIN_DBFS;
+    }
+    return _latest.leqDbfs[index];
+}
+
+float SoundSensor::getLeqDbSpl(size_t index) const {
+    return getLeqDbfs(index) + _calibrationOffset;
+}
+
+float SoundSensor::getPercentileDbfs(size_t index) const {
+    if (index >= SoundReading::PERCENTILE_COUNT) {
+        return LevelPercentiles::MIN_DB;
+    }
+    return _latest.percentileDbfs[index];
+}
+
+float SoundSensor::getPercentileDbSpl(size_t index) const {
+    return getPercentileDbfs(index) + _calibrationOffset;
+}
+
+uint32_t SoundSensor::getBlockCount() const {
+    return _blockCount;
+}
+
+uint32_t SoundSensor::getDroppedReadings() const {
+    return _droppedReadings;
 }
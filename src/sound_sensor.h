@@ -2,19 +2,230 @@
 #define SOUND_SENSOR_H
 
 #include <Arduino.h>
+#include <atomic>
 #include <cmath>
+#include "sample_source.h"
+#include "spsc_queue.h"
+#include "decimator.h"
+#include "pipeline.h"
+#include "pipeline_stages.h"
+#include "noise_floor.h"
+#include "adaptive_sampler.h"
 
+// How getSoundLevel() derives its 0-1 value
+enum class LevelMode {
+    PEAK_TO_PEAK,  // Legacy: sqrt(EMA(peak-to-peak) / 4095)
+    LEQ,           // RMS of the shortest Leq window on the same scale
+    SPEECH         // Smoothed RMS of the 500 Hz - 4 kHz octaves on the same scale
+};
+
+// How the per-channel levels of several microphones become the level
+enum class ChannelAggregation {
+    MEAN,      // Power average over all channels
+    MAX,       // Loudest channel
+    WEIGHTED   // Power average with per-channel zone weights
+};
+
+// Result published once per sample window by the acquisition side
+struct SoundReading {
+    uint32_t sequence;    // Window counter, gaps mean dropped readings
+    uint32_t timestamp;   // millis() when the window completed
+    float level;          // Normalized 0-1 sound level, aggregated over channels
+    float channelLevels[SampleSource::CHANNELS]; // Same scale, per microphone
+    uint8_t channelFaults[SampleSource::CHANNELS]; // SignalFault bits per microphone
+    float noiseFloor;     // Stationary background on the same scale as level
+    float leqDbfs[LeqMeter::WINDOW_COUNT]; // Weighted Leq per configured window
+    uint8_t bandCount;    // 0 while the band analyzer is off
+    float bandDbfs[BandAnalyzer::MAX_BANDS]; // Unweighted band levels, low to high
+
+    static constexpr size_t PERCENTILE_COUNT = 3;
+    float percentileDbfs[PERCENTILE_COUNT]; // Weighted L_N per configured percentile
+
+    // Metering below (Leq, percentiles, bands) is of the reference channel 0,
+    // the microphone the calibration offset belongs to
+    SignalHealth health;  // Reference microphone / ADC diagnostics at window end
+    uint32_t transientsRejected; // Windows replaced by the Hampel filter since boot
+    float chatterConfidence;     // 0 (machinery) to 1 (people talking), aggregated
+    ChatterFeatures chatter;     // Features behind it on the reference channel
+    SamplingStats sampling;      // Duty cycle and its cost since boot
+};
+
+// Stages run on every block of every channel; LevelMode picks which of their
+// results become a channel's level. LegacyLevelPipeline is the peak-to-peak
+// subset on its own.
+using SoundPipeline = Pipeline<SampleSource,
+                               WindowFraming,
+                               DcRemoval<SampleSource::BLOCK_SIZE>,
+                               PeakToPeakDetector,
+                               SignalDiagnosticsStage,
+                               TransientRejection,
+                               EmaEnvelope,
+                               BandAnalysisStage,
+                               ChatterDetectionStage,
+                               WeightingStage<SampleSource::SAMPLE_RATE>,
+                               LeqStatistics>;
+
+// Acquisition and DSP run on the producer side (process(), normally called
+// from a dedicated sampling task); control logic is the single consumer and
+// drains results with poll() or getSoundLevel().
 class SoundSensor {
 public:
-    SoundSensor(int pin, int sampleWindow = 50, float alpha = 0.2);
+    SoundSensor(SampleSource& source, int sampleWindow = 50, float alpha = 0.2);
+    bool begin();
+
+    // Producer: waits up to timeoutMs for one block and processes it
+    bool process(uint32_t timeoutMs);
+
+    // Producer: the reference channel's block from the last successful
+    // process(), decimated, in ADC counts (BLOCK_SIZE samples)
+    const uint16_t* getReferenceBlock() const;
+
+    // Consumer: pops the oldest unread reading
+    bool poll(SoundReading& reading);
+
+    // Consumer: drains pending readings and returns the latest level (0-1)
     float getSoundLevel();
+    const SoundReading& getLatestReading() const;
+    // Envelope smoothing (EMA alpha) of the level; applied at the next block
     void setSensitivity(float alpha);
 
+    // Metering configuration. Leq windows must be set before the sampling
+    // task starts; the level mode can change at any time and applies at the
+    // next block.
+    void setLevelMode(LevelMode mode);
+    LevelMode getLevelMode() const;
+    bool setLeqWindow(size_t index, uint16_t seconds);
+    uint16_t getLeqWindow(size_t index) const;
+
+    // Frequency weighting of the RMS/Leq path; applied at the next block
+    void setWeighting(Weighting weighting);
+    Weighting getWeighting() const;
+
+    // Percentile levels (L_N = level exceeded N% of the time) of 128 ms
+    // weighted Leq values over a sliding window. Configure before the
+    // sampling task starts.
+    bool setPercentile(size_t index, uint8_t percentExceeded);
+    uint8_t getPercentile(size_t index) const;
+    bool setPercentileWindow(uint16_t seconds);
+    uint16_t getPercentileWindow() const;
+
+    // Octave / third-octave analysis; applied at the next block. SPEECH level
+    // mode runs the analyzer in octave mode even when this is OFF.
+    void setBandMode(BandMode mode);
+    BandMode getBandMode() const;
+
+    // Impulse rejection on the peak-to-peak measure: window in sample windows
+    // (odd, 3-31, 0 = off) and threshold in MAD-derived sigmas; applied at
+    // the next block
+    bool setTransientFilter(size_t window, float threshold);
+    size_t getTransientWindow() const;
+    float getTransientThreshold() const;
+
+    // Stationary background under the level (minimum statistics over
+    // NoiseFloorTracker::HORIZON_SECONDS, held near the day's quietest
+    // stretch). seedNoiseFloor() restores a saved floor, on the scale of the
+    // current level mode, at the next block.
+    void seedNoiseFloor(float floorLevel);
+    float getNoiseFloor() const;
+
+    // Combining several microphones into the level; WEIGHTED uses the zone
+    // weights (0 leaves a channel out, default 1). Applied at the next window.
+    void setChannelAggregation(ChannelAggregation aggregation);
+    ChannelAggregation getChannelAggregation() const;
+    bool setChannelWeight(size_t channel, float weight);
+    float getChannelWeight(size_t channel) const;
+
+    // Adaptive sampling: after the level has been stable for this many
+    // seconds, one window per second is sampled with the ADC off in between
+    // until the level moves (AdaptiveSampler). Windows then stand for a
+    // second each, so block-based statistics (Leq windows, percentiles,
+    // noise-floor horizon, chatter features) stretch in time. 0 samples
+    // continuously. Applied at the next block.
+    bool setAdaptiveSampling(uint16_t stableSeconds);
+    uint16_t getAdaptiveSampling() const;
+
+    // Offset added to dBFS to obtain dB SPL for the reference microphone
+    void setCalibrationOffset(float offsetDb);
+    float getCalibrationOffset() const;
+
+    // Latest Leq of a window, as consumed by poll()/getSoundLevel()
+    float getLeqDbfs(size_t index) const;
+    float getLeqDbSpl(size_t index) const;
+
+    // Latest percentile level, as consumed by poll()/getSoundLevel()
+    float getPercentileDbfs(size_t index) const;
+    float getPercentileDbSpl(size_t index) const;
+
+    uint32_t getBlockCount() const;
+    uint32_t getDroppedReadings() const;
+
+    static constexpr size_t READING_QUEUE_SIZE = 32; // ~1.5 s of windows
+    static constexpr uint8_t DEFAULT_PERCENTILES[SoundReading::PERCENTILE_COUNT] = {10, 50, 90};
+    static constexpr uint16_t DEFAULT_PERCENTILE_WINDOW = 60;  // Seconds
+    static constexpr uint16_t MAX_PERCENTILE_WINDOW = static_cast<uint16_t>(
+        LevelPercentiles::MAX_VALUES * LeqStatistics::SLOT_BLOCKS * SampleSource::BLOCK_SIZE /
+        SampleSource::SAMPLE_RATE);
+    static constexpr float MAX_CHANNEL_WEIGHT = 10.0f;
+
 private:
-    int _pin;
+    SampleSource& _source;
     int _sampleWindow;
-    float _alpha;
-    float _filteredSignal;
+    float _level;
+    float _calibrationOffset;
+    uint32_t _blockCount;
+    uint32_t _windowCount;
+    uint32_t _droppedReadings;
+
+    // Consumer-side settings, applied by the producer before the next block.
+    // The consumer is their only writer: it makes _settingsVersion odd,
+    // stores the fields and makes it even again. The producer takes them
+    // once it reads the same new, even version before and after loading
+    // them, so it never runs with half of an update (a transient window
+    // with the previous threshold).
+    std::atomic<uint32_t> _settingsVersion;
+    std::atomic<uint8_t> _requestedWeighting;
+    std::atomic<uint8_t> _requestedBandMode;
+    std::atomic<uint8_t> _requestedTransientWindow;
+    std::atomic<float> _requestedTransientThreshold;
+    std::atomic<uint16_t> _requestedStableSeconds;
+    std::atomic<uint8_t> _requestedLevelMode;
+    std::atomic<uint8_t> _requestedAggregation;
+    std::atomic<float> _requestedChannelWeights[SampleSource::CHANNELS];
+    std::atomic<float> _requestedAlpha;
+    std::atomic<float> _requestedNoiseFloorSeed;  // Negative when there is none; taken with exchange()
+
+    // Producer's copy of the settings
+    uint32_t _appliedSettingsVersion;  // Odd: nothing applied yet
+    BandMode _bandMode;
+    LevelMode _levelMode;
+    ChannelAggregation _aggregation;
+    float _channelWeights[SampleSource::CHANNELS];
+
+    float _speechMeanSquare[SampleSource::CHANNELS];  // EMA of the speech band, ADC counts squared
+    NoiseFloorTracker _noiseFloor; // Fed with level^4, like FeedbackCompensator
+    LevelMode _noiseFloorMode;     // Level mode the floor was learned in
+    uint8_t _percentiles[SoundReading::PERCENTILE_COUNT];
+    uint16_t _percentileWindow;
+
+    AdaptiveSampler _sampler;
+    bool _standbyPending;  // Low duty: the rest of the period is still to pass
+    bool _settlePending;   // The next block only refills the decimators
+
+    CicDecimator<SampleSource::DECIMATION> _decimators[SampleSource::CHANNELS];
+    uint16_t _block[SampleSource::CAPTURE_BLOCK_SIZE * SampleSource::CHANNELS];
+    SoundPipeline _pipelines[SampleSource::CHANNELS]; // [0] is the reference channel
+
+    SpscQueue<SoundReading, READING_QUEUE_SIZE> _readings;
+    SoundReading _latest;
+
+    void processBlock(uint16_t* samples);
+    void applySettings();
+    void beginSettingsUpdate();
+    void endSettingsUpdate();
+    void finishWindow();
+    float computeChannelLevel(size_t channel);
+    float aggregate(const float* values, const float* levels) const;
+    static float meanSquareToLevel(float meanSquare);
 };
 
 #endif // SOUND_SENSOR_H
@@ -0,0 +1,72 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <stddef.h>
+
+// Bounded lock-free queue for exactly one producer thread and one consumer
+// thread. push() and pop() never block and never allocate, so the producer
+// can run in a time-critical task while the consumer drains at its own pace.
+//
+// Head and tail are free-running counters; the slot index is the counter
+// masked by Capacity - 1, so Capacity must be a power of two. Each index is
+// written by one side only and published with release/acquire ordering, which
+// makes the element copy visible before the index that announces it.
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                  "SpscQueue capacity must be a power of two");
+
+public:
+    SpscQueue() : _head(0), _tail(0) {}
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // Producer side. Returns false (and drops item) when the queue is full.
+    bool push(const T& item) {
+        size_t head = _head.load(std::memory_order_relaxed);
+        if (head - _tail.load(std::memory_order_acquire) >= Capacity) {
+            return false;
+        }
+        _items[head & MASK] = item;
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. Returns false when the queue is empty.
+    bool pop(T& item) {
+        size_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail == _head.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = _items[tail & MASK];
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Approximate when called concurrently; exact from either side at rest
+    size_t size() const {
+        return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    static constexpr size_t capacity() {
+        return Capacity;
+    }
+
+private:
+    static constexpr size_t MASK = Capacity - 1;
+    static constexpr size_t CACHE_LINE = 64;
+
+    // Keep the two indices on separate cache lines so the producer and
+    // consumer do not invalidate each other's line on every operation
+    alignas(CACHE_LINE) std::atomic<size_t> _head;
+    alignas(CACHE_LINE) std::atomic<size_t> _tail;
+    alignas(CACHE_LINE) T _items[Capacity];
+};
+
+#endif // SPSC_QUEUE_H
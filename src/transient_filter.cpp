@@ -0,0 +1,124 @@
+#include "transient_filter.h"
+#include <math.h>
+#include <string.h>
+
+HampelFilter::HampelFilter()
+    : _ring()
+    , _sorted()
+    , _head(0)
+    , _count(0)
+    , _window(DEFAULT_WINDOW)
+    , _threshold(DEFAULT_THRESHOLD)
+    , _rejected(0) {
+}
+
+void HampelFilter::reset() {
+    _head = 0;
+    _count = 0;
+}
+
+bool HampelFilter::isValidWindow(size_t values) {
+    return values == 0 || (values >= 3 && values <= MAX_WINDOW && values % 2 == 1);
+}
+
+bool HampelFilter::isValidThreshold(float sigmas) {
+    return sigmas >= MIN_THRESHOLD && sigmas <= MAX_THRESHOLD;
+}
+
+bool HampelFilter::setWindow(size_t values) {
+    if (!isValidWindow(values)) {
+        return false;
+    }
+    _window = values;
+    reset();
+    return true;
+}
+
+size_t HampelFilter::getWindow() const {
+    return _window;
+}
+
+bool HampelFilter::setThreshold(float sigmas) {
+    if (!isValidThreshold(sigmas)) {
+        return false;
+    }
+    _threshold = sigmas;
+    return true;
+}
+
+float HampelFilter::getThreshold() const {
+    return _threshold;
+}
+
+uint32_t HampelFilter::getRejectedCount() const {
+    return _rejected;
+}
+
+size_t HampelFilter::lowerBound(float value) const {
+    size_t low = 0;
+    size_t high = _count;
+    while (low < high) {
+        size_t mid = (low + high) / 2;
+        if (_sorted[mid] < value) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+float HampelFilter::process(float value) {
+    if (_window == 0) {
+        return value;
+    }
+
+    // Expire the oldest value once the window is full
+    if (_count == _window) {
+        size_t index = lowerBound(_ring[_head]);
+        memmove(&_sorted[index], &_sorted[index + 1], (_count - index - 1) * sizeof(float));
+        _count--;
+    }
+    _ring[_head] = value;
+    _head = (_head + 1) % _window;
+
+    size_t index = lowerBound(value);
+    memmove(&_sorted[index + 1], &_sorted[index], (_count - index) * sizeof(float));
+    _sorted[index] = value;
+    _count++;
+
+    if (_count < _window) {
+        return value; // Not enough history to judge yet
+    }
+
+    float median = _sorted[_count / 2];
+    float deviation = value > median ? value - median : median - value;
+    float limit = _threshold * MAD_TO_SIGMA * medianAbsoluteDeviation(median);
+    float floor = MIN_RELATIVE_DEVIATION * (median > 0 ? median : -median);
+    if (deviation > (limit > floor ? limit : floor)) {
+        _rejected++;
+        return median;
+    }
+    return value;
+}
+
+float HampelFilter::medianAbsoluteDeviation(float median) const {
+    // Deviations grow outwards from the median on both sides; merge the two
+    // runs until the middle one of all _count deviations is reached
+    size_t middle = _count / 2;
+    size_t left = middle;       // Next candidate below is _sorted[left - 1]
+    size_t right = middle + 1;  // Next candidate above is _sorted[right]
+    float deviation = 0;        // The median's own deviation
+    for (size_t taken = 1; taken <= middle; taken++) {
+        float below = left > 0 ? median - _sorted[left - 1] : INFINITY;
+        float above = right < _count ? _sorted[right] - median : INFINITY;
+        if (below <= above) {
+            deviation = below;
+            left--;
+        } else {
+            deviation = above;
+            right++;
+        }
+    }
+    return deviation;
+}
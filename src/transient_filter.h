@@ -0,0 +1,61 @@
+#ifndef TRANSIENT_FILTER_H
+#define TRANSIENT_FILTER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Streaming Hampel filter: a value further than threshold * sigma from the
+// median of the last window values is replaced by that median, where sigma
+// is the median absolute deviation scaled to a normal standard deviation
+// (with a floor relative to the median, see MIN_RELATIVE_DEVIATION).
+// A door slam or dropped tray spans a few values and is removed; a real
+// change in level becomes the median after half a window and passes.
+//
+// Values are kept twice: in arrival order, to know which one expires, and
+// sorted, for the median. Each update binary-searches the sorted copy to
+// remove the expired value and insert the new one, and the MAD is read off
+// the sorted copy by merging the deviations on either side of the median,
+// so no per-update sort is needed. All storage is fixed-size.
+class HampelFilter {
+public:
+    HampelFilter();
+
+    void reset();
+
+    // Odd window of 3 to MAX_WINDOW values; 0 disables the filter
+    bool setWindow(size_t values);
+    size_t getWindow() const;
+    bool setThreshold(float sigmas);
+    float getThreshold() const;
+    static bool isValidWindow(size_t values);
+    static bool isValidThreshold(float sigmas);
+
+    // Returns value, or the window median if value is an outlier
+    float process(float value);
+
+    uint32_t getRejectedCount() const;
+
+    static constexpr size_t MAX_WINDOW = 31;
+    static constexpr size_t DEFAULT_WINDOW = 9;
+    static constexpr float DEFAULT_THRESHOLD = 3.0f;
+    static constexpr float MIN_THRESHOLD = 1.0f;
+    static constexpr float MAX_THRESHOLD = 10.0f;
+    static constexpr float MAD_TO_SIGMA = 1.4826f;
+    // Steady signals have a tiny MAD; deviations below this fraction of the
+    // median are never outliers, so ordinary jitter is left alone
+    static constexpr float MIN_RELATIVE_DEVIATION = 0.5f;
+
+private:
+    float _ring[MAX_WINDOW];    // Arrival order
+    float _sorted[MAX_WINDOW];  // Same values, ascending
+    size_t _head;
+    size_t _count;
+    size_t _window;
+    float _threshold;
+    uint32_t _rejected;
+
+    size_t lowerBound(float value) const;
+    float medianAbsoluteDeviation(float median) const;
+};
+
+#endif // TRANSIENT_FILTER_H
@@ -0,0 +1,124 @@
+#include "venue_calibration.h"
+#include <math.h>
+#include <string.h>
+
+VenueCalibration::VenueCalibration()
+    : _phase(CalibrationPhase::IDLE)
+    , _durationMs(0)
+    , _started(false)
+    , _startMs(0)
+    , _elapsedMs(0)
+    , _bins()
+    , _count(0)
+    , _quietLevel(-1)
+    , _busyLevel(-1) {
+}
+
+bool VenueCalibration::start(CalibrationPhase phase, uint16_t seconds) {
+    if (phase == CalibrationPhase::IDLE || seconds < MIN_SECONDS || seconds > MAX_SECONDS) {
+        return false;
+    }
+    _phase = phase;
+    _durationMs = static_cast<uint32_t>(seconds) * 1000;
+    _started = false;
+    _elapsedMs = 0;
+    memset(_bins, 0, sizeof(_bins));
+    _count = 0;
+    return true;
+}
+
+void VenueCalibration::cancel() {
+    _phase = CalibrationPhase::IDLE;
+}
+
+void VenueCalibration::clear() {
+    cancel();
+    _quietLevel = -1;
+    _busyLevel = -1;
+}
+
+void VenueCalibration::setPoints(float quietLevel, float busyLevel) {
+    _quietLevel = quietLevel >= 0 && quietLevel <= 1 ? quietLevel : -1;
+    _busyLevel = busyLevel >= 0 && busyLevel <= 1 ? busyLevel : -1;
+}
+
+bool VenueCalibration::addReading(float ambientLevel, uint32_t timestampMs) {
+    if (_phase == CalibrationPhase::IDLE) {
+        return false;
+    }
+    if (!_started) {
+        _started = true;
+        _startMs = timestampMs;
+    }
+    _elapsedMs = timestampMs - _startMs;
+
+    if (ambientLevel >= 0 && _count < UINT16_MAX) {
+        size_t bin = static_cast<size_t>(ambientLevel * BIN_COUNT);
+        _bins[bin < BIN_COUNT ? bin : BIN_COUNT - 1]++;
+        _count++;
+    }
+    if (_elapsedMs < _durationMs) {
+        return false;
+    }
+
+    float level = median();
+    if (_phase == CalibrationPhase::QUIET) {
+        _quietLevel = level;
+    } else {
+        _busyLevel = level;
+    }
+    _phase = CalibrationPhase::IDLE;
+    return true;
+}
+
+float VenueCalibration::median() const {
+    // Interpolated within the bin that holds the middle reading
+    uint32_t half = _count / 2;
+    uint32_t below = 0;
+    for (size_t i = 0; i < BIN_COUNT; i++) {
+        if (below + _bins[i] > half) {
+            float within = (half - below + 0.5f) / _bins[i];
+            return (i + within) / BIN_COUNT;
+        }
+        below += _bins[i];
+    }
+    return 0;
+}
+
+CalibrationPhase VenueCalibration::getPhase() const {
+    return _phase;
+}
+
+float VenueCalibration::getProgress() const {
+    if (_phase == CalibrationPhase::IDLE || _durationMs == 0) {
+        return 0;
+    }
+    float progress = static_cast<float>(_elapsedMs) / _durationMs;
+    return progress < 1 ? progress : 1;
+}
+
+uint32_t VenueCalibration::getRemainingSeconds() const {
+    if (_phase == CalibrationPhase::IDLE) {
+        return 0;
+    }
+    return (_durationMs - _elapsedMs + 999) / 1000;
+}
+
+float VenueCalibration::getQuietLevel() const {
+    return _quietLevel;
+}
+
+float VenueCalibration::getBusyLevel() const {
+    return _busyLevel;
+}
+
+bool VenueCalibration::fit(int quietVolume, int busyVolume, VolumeMapping& mapping) const {
+    if (_quietLevel < 0 || _busyLevel < _quietLevel + MIN_SPAN || busyVolume <= quietVolume) {
+        return false;
+    }
+    mapping.quietLevel = _quietLevel;
+    mapping.busyLevel = _busyLevel;
+    mapping.quietVolume = quietVolume;
+    mapping.busyVolume = busyVolume;
+    return true;
+}
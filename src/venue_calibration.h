@@ -0,0 +1,96 @@
+#ifndef VENUE_CALIBRATION_H
+#define VENUE_CALIBRATION_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+enum class CalibrationPhase : uint8_t {
+    IDLE,   // No capture running
+    QUIET,  // Measuring the empty or quiet room
+    BUSY    // Measuring the room at its usual peak
+};
+
+// POST /calibrate, handed from the web server to loop()
+enum class CalibrationAction : uint8_t {
+    NONE,
+    MEASURE_QUIET,
+    MEASURE_BUSY,
+    CANCEL,  // Stops a running capture, keeps measured points
+    CLEAR    // Forgets the calibration, back to the sensitivity mapping
+};
+
+struct CalibrationRequest {
+    CalibrationAction action;
+    uint16_t seconds;
+    int quietVolume;  // Negative keeps the current one
+    int busyVolume;
+};
+
+// Where the volume mapping comes from: the ambient level of the quiet and
+// the busy room and the volumes each should get, linear in between and
+// clamped beyond
+struct VolumeMapping {
+    float quietLevel;
+    float busyLevel;
+    int quietVolume;
+    int busyVolume;
+};
+
+// Guided venue calibration. Each phase captures the ambient level (the same
+// level VolumeController decides on) for a set duration into a small
+// histogram and keeps its median, so a passing conversation or a dropped
+// tray does not move the result. The two phases are usually run hours apart
+// and in either order; once both are measured they define the mapping.
+// addReading() is O(1); the median is read once, when a capture ends.
+class VenueCalibration {
+public:
+    VenueCalibration();
+
+    // Starts (or restarts) a capture, timed from the next reading; false for
+    // an invalid phase or duration
+    bool start(CalibrationPhase phase, uint16_t seconds);
+    void cancel();
+
+    // Forgets both measured points
+    void clear();
+
+    // Restores points measured before a reboot; negative for not measured
+    void setPoints(float quietLevel, float busyLevel);
+
+    // Every reading while a capture runs. Returns true on the reading that
+    // completes it; the result is then in getQuietLevel()/getBusyLevel().
+    bool addReading(float ambientLevel, uint32_t timestampMs);
+
+    CalibrationPhase getPhase() const;
+    float getProgress() const;            // 0-1 of the running capture
+    uint32_t getRemainingSeconds() const;
+    float getQuietLevel() const;          // Negative until measured
+    float getBusyLevel() const;
+
+    // Linear mapping through the two measured points; false until both are
+    // measured, or when the busy room is not clearly louder than the quiet one
+    bool fit(int quietVolume, int busyVolume, VolumeMapping& mapping) const;
+
+    static constexpr uint16_t MIN_SECONDS = 10;
+    static constexpr uint16_t MAX_SECONDS = 1800;    // Keeps counts within 16 bits
+    static constexpr uint16_t DEFAULT_SECONDS = 120;
+    static constexpr size_t BIN_COUNT = 200;         // 0.005 level steps over 0-1
+    static constexpr float MIN_SPAN = 0.05f;         // Busy over quiet, in level
+    static constexpr int DEFAULT_QUIET_VOLUME = 4;
+    static constexpr int DEFAULT_BUSY_VOLUME = 12;
+
+private:
+    CalibrationPhase _phase;
+    uint32_t _durationMs;
+    bool _started;          // First reading of the capture seen
+    uint32_t _startMs;      // Its timestamp
+    uint32_t _elapsedMs;
+    uint16_t _bins[BIN_COUNT];
+    uint16_t _count;
+    float _quietLevel;
+    float _busyLevel;
+
+    float median() const;
+};
+
+#endif // VENUE_CALIBRATION_H
@@ -0,0 +1,272 @@
+#include "volume_controller.h"
+
+VolumeController::VolumeController()
+    : _sensitivity(50)
+    , _mapping()
+    , _mapped(false)
+    , _chatterGate(DEFAULT_CHATTER_GATE)
+    , _envelope(VolumeSchedule::FULL_RANGE)
+    , _chatterSum(0)
+    , _chatterCount(0)
+    , _adaptivePacing(true)
+    , _changePending(false)
+    , _holdingChanges(false)
+    , _holdUntilMs(0)
+    , _levelPower(0)
+    , _levelCount(0)
+    , _lastReadingMs(0)
+    , _decided(false)
+    , _catchingUp(false)
+    , _lastDecisionMs(0)
+    , _lastAmbientLevel(0)
+    , _overrideHoldMs(DEFAULT_OVERRIDE_HOLD_MS)
+    , _holdingOverride(false)
+    , _overrideAtMs(0) {
+}
+
+void VolumeController::setSensitivity(int sensitivity) {
+    if (sensitivity >= 0 && sensitivity <= 100) {
+        _sensitivity = sensitivity;
+    }
+}
+
+int VolumeController::getSensitivity() const {
+    return _sensitivity;
+}
+
+bool VolumeController::setMapping(const VolumeMapping& mapping) {
+    if (!(mapping.quietLevel >= 0) || !(mapping.busyLevel > mapping.quietLevel) ||
+        mapping.quietVolume < MIN_VOLUME || mapping.busyVolume > MAX_VOLUME ||
+        mapping.busyVolume <= mapping.quietVolume) {
+        return false;
+    }
+    _mapping = mapping;
+    _mapped = true;
+    return true;
+}
+
+void VolumeController::clearMapping() {
+    _mapped = false;
+}
+
+bool VolumeController::hasMapping() const {
+    return _mapped;
+}
+
+const VolumeMapping& VolumeController::getMapping() const {
+    return _mapping;
+}
+
+void VolumeController::setChatterGate(float minConfidence) {
+    if (minConfidence >= 0 && minConfidence <= 1) {
+        _chatterGate = minConfidence;
+    }
+}
+
+float VolumeController::getChatterGate() const {
+    return _chatterGate;
+}
+
+void VolumeController::setEnvelope(const VolumeEnvelope& envelope) {
+    _envelope = envelope;
+}
+
+const VolumeEnvelope& VolumeController::getEnvelope() const {
+    return _envelope;
+}
+
+bool VolumeController::isDecisionDue(uint32_t nowMs) const {
+    if (!_decided || _changePending) {
+        return true;
+    }
+    bool active = _catchingUp || !_adaptivePacing;
+    return nowMs - _lastDecisionMs >= (active ? ACTIVE_INTERVAL_MS : IDLE_INTERVAL_MS);
+}
+
+void VolumeController::setAdaptivePacing(bool enabled) {
+    _adaptivePacing = enabled;
+    _changePending = false;
+}
+
+bool VolumeController::setOverrideHold(uint32_t ms) {
+    if (ms > MAX_OVERRIDE_HOLD_MS) {
+        return false;
+    }
+    _overrideHoldMs = ms;
+    return true;
+}
+
+uint32_t VolumeController::getOverrideHold() const {
+    return _overrideHoldMs;
+}
+
+uint32_t VolumeController::getHoldRemaining(uint32_t nowMs) const {
+    uint32_t elapsed = nowMs - _overrideAtMs;
+    return _holdingOverride && elapsed < _overrideHoldMs ? _overrideHoldMs - elapsed : 0;
+}
+
+bool VolumeController::setServoSettings(const ServoSettings& settings) {
+    return _servo.setSettings(settings);
+}
+
+const ServoSettings& VolumeController::getServoSettings() const {
+    return _servo.getSettings();
+}
+
+VolumeDecision VolumeController::decide(float level, float floorLevel, int currentVolume, uint32_t nowMs) {
+    VolumeDecision decision;
+    decision.surge = _changePending;
+    _changePending = false;
+    // An idle stretch is no reason for a bigger step
+    uint32_t elapsedMs = _decided ? min(nowMs - _lastDecisionMs, ACTIVE_INTERVAL_MS) : ACTIVE_INTERVAL_MS;
+    _decided = true;
+    _lastDecisionMs = nowMs;
+
+    // Without readings since the last decision there is nothing to judge by
+    decision.chatterConfidence = _chatterCount > 0 ? _chatterSum / _chatterCount : 1.0f;
+    decision.gated = false;
+    _chatterSum = 0;
+    _chatterCount = 0;
+
+    // Remove our own music from the level so the volume does not chase itself,
+    // and the site's HVAC / fridge hum so one sensitivity fits every venue
+    decision.floorLevel = floorLevel;
+    if (_levelCount > 0) {
+        level = sqrtf(sqrtf(_levelPower));
+    }
+    decision.ambientLevel = _feedback.compensate(level, currentVolume, floorLevel);
+    _lastAmbientLevel = decision.ambientLevel;
+
+    // The servo works on the unrounded target so the deadband sees how close
+    // it really is
+    float target = getTargetVolume(decision.ambientLevel);
+    decision.targetVolume = static_cast<int>(lroundf(target));
+
+    // Whoever changed the volume by hand gets their way for a while; only
+    // the operator's limits still apply
+    decision.held = getHoldRemaining(nowMs) > 0;
+    if (decision.held) {
+        _servo.reset();
+        decision.newVolume = constrain(currentVolume, static_cast<int>(_envelope.minVolume),
+                                       static_cast<int>(_envelope.maxVolume));
+        _catchingUp = false;
+        return decision;
+    }
+    _holdingOverride = false;
+
+    // Noise that is not people talking may lower the music but never raise it
+    bool gate = decision.chatterConfidence < _chatterGate;
+    float change = _servo.update(target - currentVolume, elapsedMs / 1000.0f,
+                                 static_cast<float>(currentVolume - MIN_VOLUME),
+                                 gate ? 0.0f : static_cast<float>(MAX_VOLUME - currentVolume));
+    // The operator's limits hold whatever the servo and the gate say
+    decision.newVolume = constrain(currentVolume + static_cast<int>(lroundf(change)),
+                                   static_cast<int>(_envelope.minVolume), static_cast<int>(_envelope.maxVolume));
+    decision.gated = gate && _servo.isLimited() && target > currentVolume;
+    _catchingUp = _servo.isEngaged() && !decision.gated;
+    return decision;
+}
+
+float VolumeController::getTargetVolume(float ambientLevel) const {
+    float target = getMappedVolume(ambientLevel) + _preference.getCorrection(ambientLevel);
+    return constrain(target, static_cast<float>(_envelope.minVolume), static_cast<float>(_envelope.maxVolume));
+}
+
+float VolumeController::getBaseTargetVolume(float ambientLevel) const {
+    return constrain(getMappedVolume(ambientLevel), static_cast<float>(MIN_VOLUME), static_cast<float>(MAX_VOLUME));
+}
+
+float VolumeController::getMappedVolume(float ambientLevel) const {
+    float target;
+    if (_mapped) {
+        float slope = (_mapping.busyVolume - _mapping.quietVolume) / (_mapping.busyLevel - _mapping.quietLevel);
+        target = _mapping.quietVolume + (ambientLevel - _mapping.quietLevel) * slope;
+    } else {
+        float sensitivityFactor = _sensitivity / 50.0f; // Convert 0-100 to 0-2 range
+        target = ambientLevel * sensitivityFactor * (MAX_VOLUME - MIN_VOLUME) + MIN_VOLUME;
+    }
+    return target + _envelope.bias / 10.0f;
+}
+
+void VolumeController::addReading(float level, float chatterConfidence, uint32_t timestampMs) {
+    _feedback.addReading(level, timestampMs);
+    _chatterSum += chatterConfidence;
+    _chatterCount++;
+
+    // Level shifts caused by our own step are not the crowd; start over on
+    // the settled level
+    if (_holdingChanges) {
+        if (static_cast<int32_t>(timestampMs - _holdUntilMs) < 0) {
+            return;
+        }
+        _holdingChanges = false;
+        _change.reset();
+    }
+
+    // Plain mean of the first readings until they span the smoothing time,
+    // exponential after that
+    float power = level * level * level * level;
+    float weight = 1.0f / (_levelCount + 1);
+    if (_levelCount > 0) {
+        float decay = (timestampMs - _lastReadingMs) / 1000.0f / LEVEL_SMOOTHING_SECONDS;
+        weight = weight > decay ? weight : decay;
+        weight = weight < 1 ? weight : 1.0f;
+    }
+    _levelPower += weight * (power - _levelPower);
+    _lastReadingMs = timestampMs;
+    if (_levelCount < UINT32_MAX) {
+        _levelCount++;
+    }
+
+    if (_adaptivePacing && _change.add(level) != 0) {
+        _changePending = true;
+    }
+}
+
+void VolumeController::onVolumeCommanded(int fromVolume, int toVolume, uint32_t timestampMs) {
+    _feedback.onVolumeChange(fromVolume, toVolume, timestampMs);
+    // The mean was taken at the old volume
+    _levelPower += _feedback.getFeedbackPower(toVolume) - _feedback.getFeedbackPower(fromVolume);
+    if (_levelPower < 0) {
+        _levelPower = 0;
+    }
+    _holdingChanges = true;
+    _holdUntilMs = timestampMs + FeedbackCompensator::SETTLE_MS;
+}
+
+bool VolumeController::onExternalVolumeChange(int fromVolume, int toVolume, uint32_t timestampMs, uint32_t time) {
+    _feedback.cancelMeasurement(); // Unknown timing, not a usable step
+    _servo.reset();
+    _holdingOverride = _overrideHoldMs > 0;
+    _overrideAtMs = timestampMs;
+    if (!_decided || toVolume < MIN_VOLUME || toVolume > MAX_VOLUME) {
+        return false;  // No level to relate it to
+    }
+    OverrideSample sample;
+    sample.level = _lastAmbientLevel;
+    sample.fromVolume = static_cast<uint8_t>(constrain(fromVolume, MIN_VOLUME, MAX_VOLUME));
+    sample.volume = static_cast<uint8_t>(toVolume);
+    sample.time = time;
+    _preference.addOverride(sample, getBaseTargetVolume(_lastAmbientLevel));
+    return true;
+}
+
+uint32_t VolumeController::getChangeCount() const {
+    return _change.getChangeCount();
+}
+
+FeedbackCompensator& VolumeController::feedback() {
+    return _feedback;
+}
+
+const FeedbackCompensator& VolumeController::feedback() const {
+    return _feedback;
+}
+
+PreferenceLearner& VolumeController::preference() {
+    return _preference;
+}
+
+const PreferenceLearner& VolumeController::preference() const {
+    return _preference;
+}
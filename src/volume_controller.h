@@ -0,0 +1,155 @@
+#ifndef VOLUME_CONTROLLER_H
+#define VOLUME_CONTROLLER_H
+
+#include <Arduino.h>
+#include "feedback_compensator.h"
+#include "change_detector.h"
+#include "venue_calibration.h"
+#include "volume_servo.h"
+#include "volume_schedule.h"
+#include "preference_learner.h"
+
+// Outcome of one control step
+struct VolumeDecision {
+    float ambientLevel;  // Level above our own music and the stationary background
+    float floorLevel;    // Background (noise floor) level it was measured against
+    int targetVolume;    // Volume the level asks for
+    int newVolume;       // Volume to command; equals the current one for no change
+    float chatterConfidence; // Mean over the readings since the last decision
+    bool gated;          // An increase was held back because the noise is not chatter
+    bool surge;          // Woken by a change point
+    bool held;           // Backing off after a manual change
+};
+
+// Maps sound levels to a target volume and moves the player towards it with
+// a VolumeServo (PI law, deadband with hysteresis, slew limit). Holds the
+// music feedback model and the preference learned from manual changes so
+// the firmware and the host replay tools run the same code.
+//
+// Also paces the decisions: a CUSUM change detector on the level stream
+// wakes the controller at once when the crowd changes, it then decides every
+// ACTIVE_INTERVAL_MS while the servo is correcting, and otherwise idles at
+// IDLE_INTERVAL_MS.
+//
+// The level it decides on is the power mean of the readings over about
+// LEVEL_SMOOTHING_SECONDS: conversations swell and ebb over tens of seconds
+// without the crowd changing, and following them would move the volume all
+// evening. The change detector fires on those swings too, so it only wakes
+// the controller and never resets the mean. Our own steps shift the mean by
+// the music they add or take away.
+class VolumeController {
+public:
+    VolumeController();
+
+    // Sensitivity 0-100; 50 maps the 0-1 level straight onto the volume range
+    void setSensitivity(int sensitivity);
+    int getSensitivity() const;
+
+    // Venue calibration; replaces the sensitivity mapping while set
+    bool setMapping(const VolumeMapping& mapping);
+    void clearMapping();
+    bool hasMapping() const;
+    const VolumeMapping& getMapping() const;
+
+    // Minimum mean chatter confidence for raising the volume; machinery
+    // (vacuum, blender) only ever lowers it. 0 disables the gate.
+    void setChatterGate(float minConfidence);
+    float getChatterGate() const;
+
+    // Whether decide() should run now: a change point was seen, or the
+    // interval for the current state has passed. Without adaptive pacing
+    // every ACTIVE_INTERVAL_MS.
+    bool isDecisionDue(uint32_t nowMs) const;
+    void setAdaptivePacing(bool enabled);
+
+    // Limits and bias for now from the VolumeSchedule; the target is biased
+    // and kept within the limits, and so is the commanded volume
+    void setEnvelope(const VolumeEnvelope& envelope);
+    const VolumeEnvelope& getEnvelope() const;
+
+    // After a manual change the volume is left alone this long (0: not at
+    // all), apart from the envelope's limits
+    bool setOverrideHold(uint32_t ms);
+    uint32_t getOverrideHold() const;
+    uint32_t getHoldRemaining(uint32_t nowMs) const;
+
+    // PI gains, deadband, hysteresis and slew of the volume servo
+    bool setServoSettings(const ServoSettings& settings);
+    const ServoSettings& getServoSettings() const;
+
+    // Consumes the chatter confidence gathered since the previous call.
+    // level is the latest reading; it is decided on only until addReading()
+    // has seen one, the smoothed level after that. floorLevel is the
+    // stationary background on the level's scale (0 for none); only what
+    // rises above it drives the volume.
+    VolumeDecision decide(float level, float floorLevel, int currentVolume, uint32_t nowMs);
+
+    // Unrounded volume an ambient level asks for, from the venue calibration
+    // or else the sensitivity, corrected by the learned preference, within
+    // the envelope
+    float getTargetVolume(float ambientLevel) const;
+    // The same from the mapping and the schedule's bias alone, within the
+    // volume range
+    float getBaseTargetVolume(float ambientLevel) const;
+
+    // Every reading, in order; feeds the feedback model, the chatter gate and
+    // the smoothed level
+    void addReading(float level, float chatterConfidence, uint32_t timestampMs);
+
+    // The player accepted a volume this controller decided on
+    void onVolumeCommanded(int fromVolume, int toVolume, uint32_t timestampMs);
+
+    // The volume was changed by something else (app, schedule, staff):
+    // starts the hold and learns from it at the level of the last decision.
+    // time is Unix seconds for the record, 0 if unknown. Returns whether the
+    // preference learned from it.
+    bool onExternalVolumeChange(int fromVolume, int toVolume, uint32_t timestampMs, uint32_t time);
+
+    uint32_t getChangeCount() const;
+
+    FeedbackCompensator& feedback();
+    const FeedbackCompensator& feedback() const;
+    PreferenceLearner& preference();
+    const PreferenceLearner& preference() const;
+
+    static constexpr int MIN_VOLUME = 0;
+    static constexpr int MAX_VOLUME = FeedbackCompensator::MAX_VOLUME;
+    static constexpr float DEFAULT_CHATTER_GATE = 0.5f;
+    static constexpr uint32_t ACTIVE_INTERVAL_MS = 5000;  // Catching up with the crowd
+    static constexpr uint32_t IDLE_INTERVAL_MS = 30000;   // At target, nothing changing
+    static constexpr float LEVEL_SMOOTHING_SECONDS = 60.0f;
+    static constexpr uint32_t DEFAULT_OVERRIDE_HOLD_MS = 30 * 60000;
+    static constexpr uint32_t MAX_OVERRIDE_HOLD_MS = 4 * 3600000;
+
+private:
+    int _sensitivity;
+    VolumeMapping _mapping;
+    bool _mapped;
+    float _chatterGate;
+    VolumeEnvelope _envelope;
+    float _chatterSum;
+    uint32_t _chatterCount;
+
+    ChangeDetector _change;
+    bool _adaptivePacing;
+    bool _changePending;
+    bool _holdingChanges;      // Our own volume step is still settling
+    uint32_t _holdUntilMs;
+    float _levelPower;         // Smoothed level^4
+    uint32_t _levelCount;      // Readings in it, saturating
+    uint32_t _lastReadingMs;
+    bool _decided;
+    bool _catchingUp;
+    uint32_t _lastDecisionMs;
+    float _lastAmbientLevel;
+    uint32_t _overrideHoldMs;
+    bool _holdingOverride;
+    uint32_t _overrideAtMs;
+    VolumeServo _servo;
+    FeedbackCompensator _feedback;
+    PreferenceLearner _preference;
+
+    float getMappedVolume(float ambientLevel) const;
+};
+
+#endif // VOLUME_CONTROLLER_H
@@ -0,0 +1,320 @@
+#include "volume_schedule.h"
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+constexpr VolumeEnvelope VolumeSchedule::FULL_RANGE;
+
+namespace {
+
+const char* const DAY_NAMES[VolumeSchedule::DAYS] = {"sun", "mon", "tue", "wed", "thu", "fri", "sat"};
+const uint8_t WEEK_ORDER[VolumeSchedule::DAYS] = {1, 2, 3, 4, 5, 6, 0};  // Monday first
+
+const char* skipSpaces(const char* p) {
+    while (*p == ' ' || *p == '\t' || *p == '\r') {
+        p++;
+    }
+    return p;
+}
+
+// Length of the token at p, up to a space or the end of the rule
+size_t tokenLength(const char* p) {
+    size_t length = 0;
+    while (p[length] && !isspace(static_cast<unsigned char>(p[length])) && p[length] != ';') {
+        length++;
+    }
+    return length;
+}
+
+int parseDay(const char* p, size_t length) {
+    if (length != 3) {
+        return -1;
+    }
+    for (size_t day = 0; day < VolumeSchedule::DAYS; day++) {
+        if (strncasecmp(p, DAY_NAMES[day], 3) == 0) {
+            return static_cast<int>(day);
+        }
+    }
+    return -1;
+}
+
+// "*", or a list of days and day ranges: "mon-fri,sun"
+bool parseDays(const char* p, size_t length, uint8_t& days) {
+    if (length == 1 && *p == '*') {
+        days = VolumeSchedule::ALL_DAYS;
+        return true;
+    }
+    days = 0;
+    const char* end = p + length;
+    while (p < end) {
+        const char* comma = static_cast<const char*>(memchr(p, ',', end - p));
+        const char* itemEnd = comma ? comma : end;
+        const char* dash = static_cast<const char*>(memchr(p, '-', itemEnd - p));
+        int first = parseDay(p, (dash ? dash : itemEnd) - p);
+        int last = dash ? parseDay(dash + 1, itemEnd - dash - 1) : first;
+        if (first < 0 || last < 0) {
+            return false;
+        }
+        // Ranges follow the week, so fri-mon is fri, sat, sun, mon
+        for (int day = first;; day = (day + 1) % VolumeSchedule::DAYS) {
+            days |= 1 << day;
+            if (day == last) {
+                break;
+            }
+        }
+        p = comma ? comma + 1 : end;
+    }
+    return days != 0;
+}
+
+// "HH:MM" on a slot boundary, 00:00-24:00
+bool parseTime(const char* p, size_t length, uint8_t& slot) {
+    int hours, minutes;
+    char extra;
+    char text[8];
+    if (length >= sizeof(text)) {
+        return false;
+    }
+    memcpy(text, p, length);
+    text[length] = '\0';
+    if (sscanf(text, "%d:%d%c", &hours, &minutes, &extra) != 2 || hours < 0 || minutes < 0 ||
+        minutes >= 60 || minutes % VolumeSchedule::SLOT_MINUTES != 0 || hours * 60 + minutes > 24 * 60) {
+        return false;
+    }
+    slot = static_cast<uint8_t>((hours * 60 + minutes) / VolumeSchedule::SLOT_MINUTES);
+    return true;
+}
+
+bool parseNumber(const char* p, size_t length, float& value) {
+    char text[16];
+    if (length == 0 || length >= sizeof(text)) {
+        return false;
+    }
+    memcpy(text, p, length);
+    text[length] = '\0';
+    char* end;
+    value = strtof(text, &end);
+    return *end == '\0' && isfinite(value);
+}
+
+bool parseBias(const char* p, size_t length, int8_t& start, int8_t& end) {
+    const char* dots = strstr(p, "..");
+    float first, last;
+    if (dots && dots < p + length) {
+        if (!parseNumber(p, dots - p, first) || !parseNumber(dots + 2, p + length - dots - 2, last)) {
+            return false;
+        }
+    } else if (parseNumber(p, length, first)) {
+        last = first;
+    } else {
+        return false;
+    }
+    if (fabsf(first) * 10 > VolumeSchedule::MAX_BIAS || fabsf(last) * 10 > VolumeSchedule::MAX_BIAS) {
+        return false;
+    }
+    start = static_cast<int8_t>(lroundf(first * 10));
+    end = static_cast<int8_t>(lroundf(last * 10));
+    return true;
+}
+
+// One rule from p to its ';', newline or the end of the text
+bool parseRule(const char*& p, ScheduleRule& rule) {
+    rule = {0, 0, 0, VolumeSchedule::FULL_RANGE.minVolume, VolumeSchedule::FULL_RANGE.maxVolume, 0, 0};
+
+    p = skipSpaces(p);
+    size_t length = tokenLength(p);
+    if (!parseDays(p, length, rule.days)) {
+        return false;
+    }
+    p = skipSpaces(p + length);
+    length = tokenLength(p);
+    const char* dash = static_cast<const char*>(memchr(p, '-', length));
+    if (!dash || !parseTime(p, dash - p, rule.startSlot) ||
+        !parseTime(dash + 1, p + length - dash - 1, rule.endSlot) ||
+        rule.startSlot >= VolumeSchedule::SLOTS_PER_DAY) {
+        return false;
+    }
+    if (rule.endSlot == 0) {
+        rule.endSlot = VolumeSchedule::SLOTS_PER_DAY;  // Until midnight
+    }
+    p = skipSpaces(p + length);
+
+    bool limited = false;
+    while (*p && *p != ';' && *p != '\n') {
+        length = tokenLength(p);
+        const char* keyword = p;
+        size_t keywordLength = length;
+        p = skipSpaces(p + length);
+        length = tokenLength(p);
+        bool parsed;
+        if (keywordLength == 4 && strncasecmp(keyword, "bias", 4) == 0) {
+            parsed = parseBias(p, length, rule.biasStart, rule.biasEnd);
+        } else {
+            bool isMin = keywordLength == 3 && strncasecmp(keyword, "min", 3) == 0;
+            bool isMax = keywordLength == 3 && strncasecmp(keyword, "max", 3) == 0;
+            float value;
+            parsed = (isMin || isMax) && parseNumber(p, length, value) && value >= 0 &&
+                     value <= FeedbackCompensator::MAX_VOLUME && value == floorf(value);
+            if (parsed) {
+                (isMin ? rule.minVolume : rule.maxVolume) = static_cast<uint8_t>(value);
+            }
+        }
+        if (!parsed) {
+            return false;
+        }
+        limited = true;
+        p = skipSpaces(p + length);
+    }
+    return limited && VolumeSchedule::isValid(rule);
+}
+
+}  // namespace
+
+VolumeSchedule::VolumeSchedule()
+    : _rules()
+    , _ruleCount(0) {
+    rebuild();
+}
+
+bool VolumeSchedule::setRules(const ScheduleRule* rules, size_t count) {
+    if (count > MAX_RULES) {
+        return false;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (!isValid(rules[i])) {
+            return false;
+        }
+    }
+    memcpy(_rules, rules, count * sizeof(ScheduleRule));
+    _ruleCount = count;
+    rebuild();
+    return true;
+}
+
+size_t VolumeSchedule::getRuleCount() const {
+    return _ruleCount;
+}
+
+const ScheduleRule& VolumeSchedule::getRule(size_t index) const {
+    return _rules[index];
+}
+
+const VolumeEnvelope& VolumeSchedule::getEnvelope(uint8_t weekday, uint16_t minuteOfDay) const {
+    size_t slot = minuteOfDay / SLOT_MINUTES;
+    return _table[(weekday % DAYS) * SLOTS_PER_DAY + (slot < SLOTS_PER_DAY ? slot : SLOTS_PER_DAY - 1)];
+}
+
+bool VolumeSchedule::isValid(const ScheduleRule& rule) {
+    return rule.days != 0 && rule.days <= ALL_DAYS && rule.startSlot < SLOTS_PER_DAY &&
+           rule.endSlot >= 1 && rule.endSlot <= SLOTS_PER_DAY &&
+           rule.minVolume <= rule.maxVolume && rule.maxVolume <= FULL_RANGE.maxVolume &&
+           rule.biasStart >= -MAX_BIAS && rule.biasStart <= MAX_BIAS &&
+           rule.biasEnd >= -MAX_BIAS && rule.biasEnd <= MAX_BIAS;
+}
+
+bool VolumeSchedule::parseRules(const char* text, ScheduleRule* rules, size_t maxCount, size_t& count,
+                                size_t& errorRule) {
+    count = 0;
+    errorRule = 0;
+    const char* p = text;
+    for (;;) {
+        p = skipSpaces(p);
+        if (*p == ';' || *p == '\n') {
+            p++;  // Empty rule
+            continue;
+        }
+        if (!*p) {
+            return true;
+        }
+        ScheduleRule rule;
+        if (count == maxCount || !parseRule(p, rule)) {
+            errorRule = count + 1;
+            return false;
+        }
+        rules[count++] = rule;
+    }
+}
+
+size_t VolumeSchedule::formatRule(const ScheduleRule& rule, char* buffer, size_t size) {
+    char days[32] = "*";
+    if (rule.days != ALL_DAYS) {
+        // Runs of days in week order: "mon-wed,sat"
+        size_t length = 0;
+        days[0] = '\0';
+        for (size_t i = 0; i < DAYS; i++) {
+            if (!(rule.days & (1 << WEEK_ORDER[i]))) {
+                continue;
+            }
+            size_t last = i;
+            while (last + 1 < DAYS && (rule.days & (1 << WEEK_ORDER[last + 1]))) {
+                last++;
+            }
+            length += snprintf(days + length, sizeof(days) - length, "%s%s", length ? "," : "",
+                               DAY_NAMES[WEEK_ORDER[i]]);
+            if (last > i) {
+                length += snprintf(days + length, sizeof(days) - length, "%s%s", last > i + 1 ? "-" : ",",
+                                   DAY_NAMES[WEEK_ORDER[last]]);
+            }
+            i = last;
+        }
+    }
+    unsigned start = rule.startSlot * SLOT_MINUTES;
+    unsigned end = rule.endSlot * SLOT_MINUTES;
+    int length = snprintf(buffer, size, "%s %02u:%02u-%02u:%02u", days, start / 60, start % 60, end / 60,
+                          end % 60);
+    if (length >= 0 && static_cast<size_t>(length) < size && rule.minVolume > FULL_RANGE.minVolume) {
+        length += snprintf(buffer + length, size - length, " min %u", rule.minVolume);
+    }
+    if (length >= 0 && static_cast<size_t>(length) < size && rule.maxVolume < FULL_RANGE.maxVolume) {
+        length += snprintf(buffer + length, size - length, " max %u", rule.maxVolume);
+    }
+    if (length >= 0 && static_cast<size_t>(length) < size && (rule.biasStart != 0 || rule.biasEnd != 0)) {
+        length += rule.biasStart == rule.biasEnd
+            ? snprintf(buffer + length, size - length, " bias %g", rule.biasStart / 10.0)
+            : snprintf(buffer + length, size - length, " bias %g..%g", rule.biasStart / 10.0,
+                       rule.biasEnd / 10.0);
+    }
+    return length > 0 ? static_cast<size_t>(length) : 0;
+}
+
+void VolumeSchedule::rebuild() {
+    for (VolumeEnvelope& envelope : _table) {
+        envelope = FULL_RANGE;
+    }
+    for (size_t i = 0; i < _ruleCount; i++) {
+        apply(_rules[i]);
+    }
+    for (VolumeEnvelope& envelope : _table) {
+        if (envelope.minVolume > envelope.maxVolume) {
+            envelope.minVolume = envelope.maxVolume;
+        }
+    }
+}
+
+void VolumeSchedule::apply(const ScheduleRule& rule) {
+    size_t length = rule.endSlot > rule.startSlot ? rule.endSlot - rule.startSlot
+                                                  : rule.endSlot + SLOTS_PER_DAY - rule.startSlot;
+    for (size_t day = 0; day < DAYS; day++) {
+        if (!(rule.days & (1 << day))) {
+            continue;
+        }
+        for (size_t i = 0; i < length; i++) {
+            size_t slot = (day * SLOTS_PER_DAY + rule.startSlot + i) % (DAYS * SLOTS_PER_DAY);
+            VolumeEnvelope& envelope = _table[slot];
+            int bias = rule.biasStart;
+            if (length > 1) {
+                bias += static_cast<int>(lroundf(static_cast<float>(rule.biasEnd - rule.biasStart) * i / (length - 1)));
+            }
+            bias += envelope.bias;
+            envelope.bias = static_cast<int8_t>(bias < -MAX_BIAS ? -MAX_BIAS : bias > MAX_BIAS ? MAX_BIAS : bias);
+            if (rule.minVolume > envelope.minVolume) {
+                envelope.minVolume = rule.minVolume;
+            }
+            if (rule.maxVolume < envelope.maxVolume) {
+                envelope.maxVolume = rule.maxVolume;
+            }
+        }
+    }
+}
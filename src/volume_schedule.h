@@ -0,0 +1,90 @@
+#ifndef VOLUME_SCHEDULE_H
+#define VOLUME_SCHEDULE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "feedback_compensator.h"
+
+// One operator rule, stored as is in NVS (7 bytes)
+struct ScheduleRule {
+    uint8_t days;       // Bit 0 Sunday .. bit 6 Saturday
+    uint8_t startSlot;  // 15-minute slots since midnight, 0-95
+    uint8_t endSlot;    // Exclusive, 1-96; at or before the start it runs past
+                        // midnight into the next day
+    uint8_t minVolume;
+    uint8_t maxVolume;
+    int8_t biasStart;   // Tenths of a volume step added to the target at the
+    int8_t biasEnd;     // start and the end of the window, linear in between
+};
+static_assert(sizeof(ScheduleRule) == 7, "ScheduleRule is stored in NVS as is");
+
+// Limits and bias for one slot of the week
+struct VolumeEnvelope {
+    uint8_t minVolume;
+    uint8_t maxVolume;
+    int8_t bias;  // Tenths of a volume step
+};
+
+// Time-of-day and weekday volume envelopes, e.g. "never above 10 during
+// lunch, at least 4 after 20:00".
+//
+// The rules are compiled into a table with one envelope per 15-minute slot
+// of the week whenever they change, so looking up the current envelope is
+// one index. Where rules overlap the tightest limits win (and the maximum
+// over the minimum, should they cross) and the biases add up.
+//
+// Rules have a text form for the portal, one per line or separated by ';':
+//   mon-fri 11:30-14:00 max 10
+//   * 20:00-24:00 min 4
+//   fri,sat 22:00-02:00 bias 0..-2
+// Days are mon..sun, ranges and lists of them, or * for every day; times are
+// multiples of 15 minutes; the bias is in volume steps, a ramp with "..".
+class VolumeSchedule {
+public:
+    VolumeSchedule();
+
+    // Replaces the rules and rebuilds the table; false (old rules kept) if
+    // one of them is invalid
+    bool setRules(const ScheduleRule* rules, size_t count);
+    size_t getRuleCount() const;
+    const ScheduleRule& getRule(size_t index) const;
+
+    // Weekday 0 (Sunday) to 6, as in struct tm
+    const VolumeEnvelope& getEnvelope(uint8_t weekday, uint16_t minuteOfDay) const;
+
+    static bool isValid(const ScheduleRule& rule);
+
+    // Text form; parsing fails on the first bad rule, with its number in
+    // errorRule (1-based)
+    static bool parseRules(const char* text, ScheduleRule* rules, size_t maxCount, size_t& count,
+                           size_t& errorRule);
+    static size_t formatRule(const ScheduleRule& rule, char* buffer, size_t size);
+
+    static constexpr size_t MAX_RULES = 16;
+    static constexpr uint16_t SLOT_MINUTES = 15;
+    static constexpr size_t SLOTS_PER_DAY = 24 * 60 / SLOT_MINUTES;
+    static constexpr size_t DAYS = 7;
+    static constexpr uint8_t ALL_DAYS = 0x7F;
+    static constexpr int8_t MAX_BIAS = 80;  // Tenths: 8 steps either way
+    static constexpr size_t MAX_TIMEZONE_LENGTH = 47;  // POSIX TZ string
+    static constexpr VolumeEnvelope FULL_RANGE = {0, FeedbackCompensator::MAX_VOLUME, 0};
+
+private:
+    ScheduleRule _rules[MAX_RULES];
+    size_t _ruleCount;
+    VolumeEnvelope _table[DAYS * SLOTS_PER_DAY];
+
+    void rebuild();
+    void apply(const ScheduleRule& rule);
+};
+
+// POST /schedule, handed from the web server to loop()
+struct ScheduleRequest {
+    bool setRules;
+    bool setTimezone;
+    uint8_t ruleCount;
+    ScheduleRule rules[VolumeSchedule::MAX_RULES];
+    char timezone[VolumeSchedule::MAX_TIMEZONE_LENGTH + 1];
+};
+
+#endif // VOLUME_SCHEDULE_H
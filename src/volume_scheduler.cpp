@@ -0,0 +1,148 @@
+#include "volume_scheduler.h"
+#include <stdlib.h>
+
+VolumeScheduler::VolumeScheduler()
+    : _minDwellMs(DEFAULT_MIN_DWELL_MS)
+    , _pending(false)
+    , _pendingVolume(0)
+    , _pendingFrom(0)
+    , _pendingUrgent(false)
+    , _sent(false)
+    , _lastSentMs(0)
+    , _retrying(false)
+    , _lastAttemptMs(0)
+    , _attempts()
+    , _attemptCount(0)
+    , _nextAttempt(0)
+    , _unconfirmed(false)
+    , _unconfirmedVolume(0)
+    , _counters() {
+}
+
+bool VolumeScheduler::setMinDwell(uint32_t ms) {
+    if (ms > MAX_MIN_DWELL_MS) {
+        return false;
+    }
+    _minDwellMs = ms;
+    return true;
+}
+
+uint32_t VolumeScheduler::getMinDwell() const {
+    return _minDwellMs;
+}
+
+void VolumeScheduler::request(int volume, int currentVolume, bool urgent) {
+    if (volume == currentVolume) {
+        dropPending();
+        return;
+    }
+    if (_pending && _pendingVolume != volume) {
+        _counters.coalesced++;
+    }
+    _pending = true;
+    _pendingVolume = volume;
+    _pendingFrom = currentVolume;
+    _pendingUrgent = urgent || abs(volume - currentVolume) >= URGENT_STEPS;
+}
+
+bool VolumeScheduler::isCommandDue(uint32_t nowMs, int& volume) const {
+    if (!_pending || _unconfirmed) {
+        return false;
+    }
+    if (_retrying && nowMs - _lastAttemptMs < RETRY_MS) {
+        return false;
+    }
+    if (_sent && !_pendingUrgent && nowMs - _lastSentMs < _minDwellMs) {
+        return false;
+    }
+    volume = _pendingVolume;
+    return true;
+}
+
+void VolumeScheduler::onCommandSent(int volume, bool accepted, uint32_t nowMs) {
+    // A failed call may still have reached the player, so it is remembered
+    // too; an accepted one supersedes everything sent before it
+    if (accepted) {
+        _attemptCount = 0;
+        _nextAttempt = 0;
+    }
+    _attempts[_nextAttempt] = {_pendingFrom, volume, nowMs};
+    _nextAttempt = (_nextAttempt + 1) % RECENT_ATTEMPTS;
+    if (_attemptCount < RECENT_ATTEMPTS) {
+        _attemptCount++;
+    }
+    if (!accepted) {
+        _counters.failed++;
+        _retrying = true;
+        _lastAttemptMs = nowMs;
+        return;
+    }
+    _counters.issued++;
+    if (_pendingUrgent && _sent && nowMs - _lastSentMs < _minDwellMs) {
+        _counters.urgent++;
+    }
+    _retrying = false;
+    _sent = true;
+    _lastSentMs = nowMs;
+    if (_pending && _pendingVolume == volume) {
+        _pending = false;
+    }
+}
+
+PlayerVolume VolumeScheduler::classifyPlayerVolume(int reported, int expected, uint32_t nowMs) {
+    bool confirming = _unconfirmed;
+    _unconfirmed = false;
+    if (reported == expected) {
+        return PlayerVolume::EXPECTED;
+    }
+    if (isOwnVolume(reported, nowMs)) {
+        _counters.echoes++;
+        if (_pending && reported == _pendingVolume) {
+            dropPending();  // A failed call that went through; nothing left to send
+        }
+        return PlayerVolume::OWN_COMMAND;
+    }
+    if (confirming && reported == _unconfirmedVolume) {
+        return PlayerVolume::MANUAL;
+    }
+    _unconfirmed = true;
+    _unconfirmedVolume = reported;
+    return PlayerVolume::UNCONFIRMED;
+}
+
+bool VolumeScheduler::isConfirming() const {
+    return _unconfirmed;
+}
+
+void VolumeScheduler::onExternalVolumeChange() {
+    dropPending();
+}
+
+bool VolumeScheduler::hasPending() const {
+    return _pending;
+}
+
+const SchedulerCounters& VolumeScheduler::getCounters() const {
+    return _counters;
+}
+
+// A pending target counts only once it has been attempted: before that the
+// player can only be at it if someone else set it
+bool VolumeScheduler::isOwnVolume(int volume, uint32_t nowMs) const {
+    for (size_t i = 0; i < _attemptCount; i++) {
+        const CommandAttempt& attempt = _attempts[i];
+        uint32_t age = nowMs - attempt.ms;
+        if ((volume == attempt.volume && age < ECHO_MS) || (volume == attempt.fromVolume && age < RETRY_MS)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void VolumeScheduler::dropPending() {
+    if (_pending) {
+        _counters.suppressed++;
+        _pending = false;
+    }
+    _retrying = false;
+}
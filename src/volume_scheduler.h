@@ -0,0 +1,106 @@
+#ifndef VOLUME_SCHEDULER_H
+#define VOLUME_SCHEDULER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct SchedulerCounters {
+    uint32_t issued;      // Commands the player accepted
+    uint32_t coalesced;   // Pending targets replaced by a newer one before sending
+    uint32_t suppressed;  // Pending targets dropped: back at the player's volume, or overridden
+    uint32_t urgent;      // Issued before the dwell was over
+    uint32_t failed;      // API calls that did not go through
+    uint32_t echoes;      // Player reads off the expected volume, explained by our own commands
+};
+
+// What a volume read from the player means, given the commands we sent
+enum class PlayerVolume : uint8_t {
+    EXPECTED,     // The volume we last set or read
+    OWN_COMMAND,  // One of our recent commands: a read racing it, or a failed call that went through
+    UNCONFIRMED,  // Not ours; read again before believing it
+    MANUAL,       // Not ours, and still there on the confirming read
+};
+
+// One setPlayerVolume() call, accepted or not
+struct CommandAttempt {
+    int fromVolume;
+    int volume;
+    uint32_t ms;
+};
+
+// Sits between VolumeController and APIClient and decides when a volume
+// command is actually sent, as each one is a full HTTPS round trip.
+//
+// The controller's latest wanted volume is kept as the one pending target,
+// so a move that is superseded before it goes out costs nothing, and one
+// that returns to the player's volume is dropped. Commands are at least the
+// minimum dwell apart; an urgent target (a change point, or a jump of
+// URGENT_STEPS or more) goes out at once. A failed call is retried after
+// RETRY_MS.
+//
+// Volume reads are checked against the last accepted command and the failed
+// ones since, so a reply lost to a timeout or a read racing a command is not
+// taken for someone changing the volume. A change that matches none of them
+// is confirmed by a second read CONFIRM_MS later, and no command goes out
+// in between.
+class VolumeScheduler {
+public:
+    VolumeScheduler();
+
+    bool setMinDwell(uint32_t ms);
+    uint32_t getMinDwell() const;
+
+    // Every decision: the volume the controller wants, the player's volume
+    // it decided from, and whether it reacts to a change point
+    void request(int volume, int currentVolume, bool urgent);
+
+    // Whether a command should be sent now, and which volume
+    bool isCommandDue(uint32_t nowMs, int& volume) const;
+    void onCommandSent(int volume, bool accepted, uint32_t nowMs);
+
+    // Every read of the player's volume, against the one we expect it at.
+    // EXPECTED and OWN_COMMAND are not a change by someone else
+    PlayerVolume classifyPlayerVolume(int reported, int expected, uint32_t nowMs);
+    // An unexplained change waits for its confirming read, due CONFIRM_MS
+    // after the first instead of at the next regular poll
+    bool isConfirming() const;
+
+    // Someone else set the volume; their choice wins over a pending target
+    void onExternalVolumeChange();
+
+    bool hasPending() const;
+    const SchedulerCounters& getCounters() const;
+
+    static constexpr uint32_t DEFAULT_MIN_DWELL_MS = 10000;
+    static constexpr uint32_t MAX_MIN_DWELL_MS = 300000;
+    static constexpr int URGENT_STEPS = 3;
+    static constexpr uint32_t RETRY_MS = 5000;
+    static constexpr size_t RECENT_ATTEMPTS = 4;
+    // A command's target is recognized on any read this soon after it, so
+    // the first 30 s poll after a failed call still sees it; its previous
+    // volume only within RETRY_MS, as a read that raced the command
+    static constexpr uint32_t ECHO_MS = 40000;
+    static constexpr uint32_t CONFIRM_MS = 5000;
+
+private:
+    uint32_t _minDwellMs;
+    bool _pending;
+    int _pendingVolume;
+    int _pendingFrom;
+    bool _pendingUrgent;
+    bool _sent;               // A command went through since boot
+    uint32_t _lastSentMs;
+    bool _retrying;
+    uint32_t _lastAttemptMs;
+    CommandAttempt _attempts[RECENT_ATTEMPTS];  // Since the last accepted one; ring, oldest overwritten
+    size_t _attemptCount;
+    size_t _nextAttempt;
+    bool _unconfirmed;
+    int _unconfirmedVolume;
+    SchedulerCounters _counters;
+
+    void dropPending();
+    bool isOwnVolume(int volume, uint32_t nowMs) const;
+};
+
+#endif // VOLUME_SCHEDULER_H
@@ -0,0 +1,79 @@
+#include "volume_servo.h"
+#include <math.h>
+
+constexpr ServoSettings VolumeServo::DEFAULT_SETTINGS;
+
+VolumeServo::VolumeServo()
+    : _settings(DEFAULT_SETTINGS)
+    , _engaged(false)
+    , _limited(false)
+    , _integral(0)
+    , _lastError(0)
+    , _hasLastError(false) {
+}
+
+bool VolumeServo::setSettings(const ServoSettings& settings) {
+    if (!(settings.kp > 0 && settings.kp <= MAX_GAIN) ||
+        !(settings.ki >= 0 && settings.ki <= MAX_GAIN) ||
+        !(settings.kd >= 0 && settings.kd <= MAX_GAIN) ||
+        !(settings.deadband >= 0) || !(settings.hysteresis >= 0) ||
+        !(settings.maxSlew > 0 && settings.maxSlew <= MAX_SLEW) ||
+        !(settings.maxIntegral >= 0)) {
+        return false;
+    }
+    _settings = settings;
+    reset();
+    return true;
+}
+
+const ServoSettings& VolumeServo::getSettings() const {
+    return _settings;
+}
+
+float VolumeServo::update(float error, float seconds, float maxDown, float maxUp) {
+    _limited = false;
+    float magnitude = fabsf(error);
+    if (_engaged ? magnitude <= _settings.deadband
+                 : magnitude <= _settings.deadband + _settings.hysteresis) {
+        reset();
+        return 0;
+    }
+    _engaged = true;
+
+    float previousIntegral = _integral;
+    if (_settings.ki > 0) {
+        float bound = _settings.maxIntegral / _settings.ki;
+        _integral = fmaxf(-bound, fminf(bound, _integral + error * seconds));
+    }
+    float derivative = _hasLastError && seconds > 0 ? (error - _lastError) / seconds : 0;
+    _lastError = error;
+    _hasLastError = true;
+
+    float wanted = _settings.kp * error + _settings.ki * _integral + _settings.kd * derivative;
+    float slew = _settings.maxSlew * seconds;
+    float low = fmaxf(-slew, -maxDown);
+    float high = fminf(slew, maxUp);
+    float change = fmaxf(low, fminf(high, wanted));
+    if (change != wanted) {
+        _limited = true;
+        // Conditional integration: accumulating further would only wind up
+        if ((wanted > change) == (error > 0)) {
+            _integral = previousIntegral;
+        }
+    }
+    return change;
+}
+
+bool VolumeServo::isEngaged() const {
+    return _engaged;
+}
+
+bool VolumeServo::isLimited() const {
+    return _limited;
+}
+
+void VolumeServo::reset() {
+    _engaged = false;
+    _integral = 0;
+    _hasLastError = false;
+}
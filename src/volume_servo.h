@@ -0,0 +1,64 @@
+#ifndef VOLUME_SERVO_H
+#define VOLUME_SERVO_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct ServoSettings {
+    float kp;          // Share of the error corrected per decision
+    float ki;          // Per second of accumulated error
+    float kd;          // Seconds; on the error's rate of change, 0 for a plain PI
+    float deadband;    // Volume steps of error that count as on target
+    float hysteresis;  // Extra error needed to move again once on target
+    float maxSlew;     // Volume steps per second
+    float maxIntegral; // Bound of the integral term, in volume steps
+};
+
+// PI(D) law that moves the player volume towards the target volume.
+//
+// The player holds whatever volume it was given, so the law's output is a
+// change of volume: kp * error covers a share of the distance every
+// decision, and the integral term pushes through the residual error that
+// rounding to whole steps would otherwise leave. Once within the deadband
+// the servo rests, and only moves again when the error exceeds the
+// deadband plus the hysteresis; a target hovering between two volumes
+// therefore never makes the player dither. Changes are limited to maxSlew
+// steps per second of elapsed time.
+//
+// Anti-windup: the integral is bounded, stops accumulating while the
+// output is limited by the slew, the volume range or the caller (the
+// chatter gate), and is cleared whenever the servo comes to rest.
+class VolumeServo {
+public:
+    VolumeServo();
+
+    bool setSettings(const ServoSettings& settings);
+    const ServoSettings& getSettings() const;
+
+    // Change of volume for this error (target - current volume), at most
+    // maxDown below and maxUp above the current volume. seconds is the
+    // time since the previous update.
+    float update(float error, float seconds, float maxDown, float maxUp);
+
+    // Outside the deadband, still correcting
+    bool isEngaged() const;
+    // The last update wanted more than it was allowed
+    bool isLimited() const;
+
+    // Start over, e.g. after the volume was changed by someone else
+    void reset();
+
+    static constexpr ServoSettings DEFAULT_SETTINGS = {0.5f, 0.02f, 0.0f, 0.6f, 0.6f, 0.6f, 1.0f};
+    static constexpr float MAX_GAIN = 10.0f;
+    static constexpr float MAX_SLEW = 16.0f;  // Whole range in one second
+
+private:
+    ServoSettings _settings;
+    bool _engaged;
+    bool _limited;
+    float _integral;       // Error seconds
+    float _lastError;
+    bool _hasLastError;
+};
+
+#endif // VOLUME_SERVO_H
@@ -451,3 +451,262 @@ int WiFiManager::getNetworkQuality(int32_t rssi) {
     return 0;                        // Very Poor
 }
 
+
+
+void WiFiManager::storeCalibrationOffset(float offsetDb) {
+    preferences.begin(PREF_NAMESPACE, false);
+    preferences.putFloat(PREF_CALIBRATION_OFFSET, offsetDb);
+    preferences.end();
+}
+
+float WiFiManager::getCalibrationOffset() {
+    preferences.begin(PREF_NAMESPACE, true);
+    float offsetDb = preferences.getFloat(PREF_CALIBRATION_OFFSET, 0.0f);
+    preferences.end();
+    return offsetDb;
+}
+
+void WiFiManager::storeLevelMode(uint8_t mode) {
+    preferences.begin(PREF_NAMESPACE, false);
+    preferences.putUChar(PREF_LEVEL_MODE, mode);
+    preferences.end();
+}
+
+uint8_t WiFiManager::getLevelMode() {
+    preferences.begin(PREF_NAMESPACE, true);
+    uint8_t mode = preferences.getUChar(PREF_LEVEL_MODE, 0);
+    preferences.end();
+    return mode;
+}
+
+void WiFiManager::storeWeighting(uint8_t weighting) {
+    preferences.begin(PREF_NAMESPACE, false);
+    preferences.putUChar(PREF_WEIGHTING, weighting);
+    preferences.end();
+}
+
+uint8_t WiFiManager::getWeighting() {
+    preferences.begin(PREF_NAMESPACE, true);
+    uint8_t weighting = preferences.getUChar(PREF_WEIGHTING, 1); // A-weighting
+    preferences.end();
+    return weighting;
+}
+
+void WiFiManager::storeBandMode(uint8_t mode) {
+    preferences.begin(PREF_NAMESPACE, false);
+    preferences.putUChar(PREF_BAND_MODE, mode);
+    preferences.end();
+}
+
+uint8_t WiFiManager::getBandMode() {
+    preferences.begin(PREF_NAMESPACE, true);
+    uint8_t mode = preferences.getUChar(PREF_BAND_MODE, 0); // Off
+    preferences.end();
+    return mode;
+}
+
+void WiFiManager::storeFeedbackModel(const float* increments, size_t count) {
+    preferences.begin(PREF_NAMESPACE, false);
+    preferences.putBytes(PREF_FEEDBACK_MODEL, increments, count * sizeof(float));
+    preferences.end();
+}
+
+bool WiFiManager::loadFeedbackModel(float* increments, size_t count) {
+    preferences.begin(PREF_NAMESPACE, true);
+    size_t expected = count * sizeof(float);
+    bool found = preferences.getBytesLength(PREF_FEEDBACK_MODEL) == expected &&
+                 preferences.getBytes(PREF_FEEDBACK_MODEL, increments, expected) == expected;
+    preferences.end();
+    return found;
+}
+
+void WiFiManager::storeTransientFilter(uint8_t window, float threshold) {
+    preferences.begin(PREF_NAMESPACE, false);
+    preferences.putUChar(PREF_TRANSIENT_WINDOW, window);
+    preferences.putFloat(PREF_TRANSIENT_THRESHOLD, threshold);
+    preferences.end();
+}
+
+uint8_t WiFiManager::getTransientWindow() {
+    preferences.begin(PREF_NAMESPACE, true);
+    uint8_t window = preferences.getUChar(PREF_TRANSIENT_WINDOW, 9); // 450 ms
+    preferences.end();
+    return window;
+}
+
+float WiFiManager::getTransientThreshold() {
+    preferences.begin(PREF_NAMESPACE, true);
+    float threshold = preferences.getFloat(PREF_TRANSIENT_THRESHOLD, 3.0f);
+    preferences.end();
+    return threshold;
+}
+
+void WiFiManager::storeNoiseFloor(uint8_t levelMode, float floorLevel) {
+    preferences.begin(PREF_NAMESPACE, false);
+    preferences.putUChar(PREF_NOISE_FLOOR_MODE, levelMode);
+    preferences.putFloat(PREF_NOISE_FLOOR, floorLevel);
+    preferences.end();
+}
+
+bool WiFiManager::loadNoiseFloor(uint8_t levelMode, float& floorLevel) {
+    preferences.begin(PREF_NAMESPACE, true);
+    bool found = preferences.isKey(PREF_NOISE_FLOOR) &&
+                 preferences.getUChar(PREF_NOISE_FLOOR_MODE, 0xFF) == levelMode;
+    if (found) {
+        floorLevel = preferences.getFloat(PREF_NOISE_FLOOR, 0.0f);
+    }
+    preferences.end();
+    return found;
+}
+
+void WiFiManager::storeChannelAggregation(uint8_t aggregation) {
+    preferences.begin(PREF_NAMESPACE, false);
+    preferences.putUChar(PREF_CHANNEL_AGGREGATION, aggregation);
+    preferences.end();
+}
+
+uint8_t WiFiManager::getChannelAggregation() {
+    preferences.begin(PREF_NAMESPACE, true);
+    uint8_t aggregation = preferences.getUChar(PREF_CHANNEL_AGGREGATION, 0); // Mean
+    preferences.end();
+    return aggregation;
+}
+
+void WiFiManager::storeChannelWeights(const float* weights, size_t count) {
+    preferences.begin(PREF_NAMESPACE, false);
+    preferences.putBytes(PREF_CHANNEL_WEIGHTS, weights, count * sizeof(float));
+    preferences.end();
+}
+
+bool WiFiManager::loadChannelWeights(float* weights, size_t count) {
+    preferences.begin(PREF_NAMESPACE, true);
+    size_t expected = count * sizeof(float);
+    bool found = preferences.getBytesLength(PREF_CHANNEL_WEIGHTS) == expected &&
+                 preferences.getBytes(PREF_CHANNEL_WEIGHTS, weights, expected) == expected;
+    preferences.end();
+    return found;
+}
+
+void WiFiManager::storeVenueCalibration(uint8_t levelMode, float quietLevel, float busyLevel,
+                                        uint8_t quietVolume, uint8_t busyVolume) {
+    preferences.begin(PREF_NAMESPACE, false);
+    preferences.putUChar(PREF_VENUE_MODE, levelMode);
+    preferences.putFloat(PREF_VENUE_QUIET, quietLevel);
+    preferences.putFloat(PREF_VENUE_BUSY, busyLevel);
+    preferences.putUChar(PREF_VENUE_QUIET_VOLUME, quietVolume);
+    preferences.putUChar(PREF_VENUE_BUSY_VOLUME, busyVolume);
+    preferences.end();
+}
+
+bool WiFiManager::loadVenueCalibration(uint8_t levelMode, float& quietLevel, float& busyLevel,
+                                       uint8_t& quietVolume, uint8_t& busyVolume) {
+    preferences.begin(PREF_NAMESPACE, true);
+    bool found = preferences.isKey(PREF_VENUE_QUIET) &&
+                 preferences.getUChar(PREF_VENUE_MODE, 0xFF) == levelMode;
+    if (found) {
+        quietLevel = preferences.getFloat(PREF_VENUE_QUIET, -1.0f);
+        busyLevel = preferences.getFloat(PREF_VENUE_BUSY, -1.0f);
+        quietVolume = preferences.getUChar(PREF_VENUE_QUIET_VOLUME, 4);
+        busyVolume = preferences.getUChar(PREF_VENUE_BUSY_VOLUME, 12);
+    }
+    preferences.end();
+    return found;
+}
+
+void WiFiManager::clearVenueCalibration() {
+    preferences.begin(PREF_NAMESPACE, false);
+    preferences.remove(PREF_VENUE_MODE);
+    preferences.remove(PREF_VENUE_QUIET);
+    preferences.remove(PREF_VENUE_BUSY);
+    preferences.remove(PREF_VENUE_QUIET_VOLUME);
+    preferences.remove(PREF_VENUE_BUSY_VOLUME);
+    preferences.end();
+}
+
+void WiFiManager::storeVolumeSchedule(const ScheduleRule* rules, size_t count) {
+    preferences.begin(PREF_NAMESPACE, false);
+    if (count > 0) {
+        preferences.putBytes(PREF_VOLUME_SCHEDULE, rules, count * sizeof(ScheduleRule));
+    } else {
+        preferences.remove(PREF_VOLUME_SCHEDULE);
+    }
+    preferences.end();
+}
+
+size_t WiFiManager::loadVolumeSchedule(ScheduleRule* rules, size_t maxCount) {
+    preferences.begin(PREF_NAMESPACE, true);
+    size_t length = preferences.isKey(PREF_VOLUME_SCHEDULE) ? preferences.getBytesLength(PREF_VOLUME_SCHEDULE) : 0;
+    size_t count = 0;
+    if (length % sizeof(ScheduleRule) == 0 && length <= maxCount * sizeof(ScheduleRule) &&
+        preferences.getBytes(PREF_VOLUME_SCHEDULE, rules, length) == length) {
+        count = length / sizeof(ScheduleRule);
+    }
+    preferences.end();
+    return count;
+}
+
+void WiFiManager::storePreferenceModel(const PreferenceModel& model) {
+    preferences.begin(PREF_NAMESPACE, false);
+    preferences.putBytes(PREF_PREFERENCE_MODEL, &model, sizeof(model));
+    preferences.end();
+}
+
+bool WiFiManager::loadPreferenceModel(PreferenceModel& model) {
+    preferences.begin(PREF_NAMESPACE, true);
+    bool found = preferences.getBytesLength(PREF_PREFERENCE_MODEL) == sizeof(model) &&
+                 preferences.getBytes(PREF_PREFERENCE_MODEL, &model, sizeof(model)) == sizeof(model);
+    preferences.end();
+    return found;
+}
+
+void WiFiManager::storeOverrideHold(uint16_t minutes) {
+    preferences.begin(PREF_NAMESPACE, false);
+    preferences.putUShort(PREF_OVERRIDE_HOLD, minutes);
+    preferences.end();
+}
+
+uint16_t WiFiManager::getOverrideHold() {
+    preferences.begin(PREF_NAMESPACE, true);
+    uint16_t minutes = preferences.getUShort(PREF_OVERRIDE_HOLD, 30);
+    preferences.end();
+    return minutes;
+}
+
+void WiFiManager::storeTimezone(const char* timezone) {
+    preferences.begin(PREF_NAMESPACE, false);
+    preferences.putString(PREF_TIMEZONE, timezone);
+    preferences.end();
+}
+
+String WiFiManager::getTimezone() {
+    preferences.begin(PREF_NAMESPACE, true);
+    String timezone = preferences.getString(PREF_TIMEZONE, "UTC0");
+    preferences.end();
+    return timezone;
+}
+
+void WiFiManager::storeAdaptiveSampling(uint16_t stableSeconds) {
+    preferences.begin(PREF_NAMESPACE, false);
+    preferences.putUShort(PREF_ADAPTIVE_SAMPLING, stableSeconds);
+    preferences.end();
+}
+
+uint16_t WiFiManager::getAdaptiveSampling() {
+    preferences.begin(PREF_NAMESPACE, true);
+    uint16_t stableSeconds = preferences.getUShort(PREF_ADAPTIVE_SAMPLING, 0); // Continuous
+    preferences.end();
+    return stableSeconds;
+}
+
+void WiFiManager::storeRecordingMode(uint8_t mode) {
+    preferences.begin(PREF_NAMESPACE, false);
+    preferences.putUChar(PREF_RECORDING_MODE, mode);
+    preferences.end();
+}
+
+uint8_t WiFiManager::getRecordingMode() {
+    preferences.begin(PREF_NAMESPACE, true);
+    uint8_t mode = preferences.getUChar(PREF_RECORDING_MODE, 1); // Triggered
+    preferences.end();
+    return mode;
+}
\ No newline at end of file
@@ -8,6 +8,8 @@
 #include <nvs_flash.h>
 #include <esp_wifi.h>
 #include <nvs.h>
+#include "volume_schedule.h"
+#include "preference_learner.h"
 
 class WiFiManager {
 public:
@@ -48,6 +50,63 @@ public:
     void storeSensitivity(int sensitivity);
     int getSensitivity();
 
+    // Sound metering settings
+    void storeCalibrationOffset(float offsetDb);
+    float getCalibrationOffset();
+    void storeLevelMode(uint8_t mode);
+    uint8_t getLevelMode();
+    void storeWeighting(uint8_t weighting);
+    uint8_t getWeighting();
+    void storeBandMode(uint8_t mode);
+    uint8_t getBandMode();
+    void storeTransientFilter(uint8_t window, float threshold);
+    uint8_t getTransientWindow();
+    float getTransientThreshold();
+
+    // Preference learned from manual volume changes, and how many minutes
+    // the controller backs off after one
+    void storePreferenceModel(const PreferenceModel& model);
+    bool loadPreferenceModel(PreferenceModel& model);
+    void storeOverrideHold(uint16_t minutes);
+    uint16_t getOverrideHold();
+
+    // Learned music feedback model (FeedbackCompensator increments)
+    void storeFeedbackModel(const float* increments, size_t count);
+    bool loadFeedbackModel(float* increments, size_t count);
+
+    // Learned noise floor, valid only for the level mode it was learned in
+    void storeNoiseFloor(uint8_t levelMode, float floorLevel);
+    bool loadNoiseFloor(uint8_t levelMode, float& floorLevel);
+
+    // Multi-microphone aggregation (ChannelAggregation) and zone weights;
+    // weights saved for a different channel count are not loaded
+    void storeChannelAggregation(uint8_t aggregation);
+    uint8_t getChannelAggregation();
+    void storeChannelWeights(const float* weights, size_t count);
+    bool loadChannelWeights(float* weights, size_t count);
+
+    // Stable seconds before adaptive sampling drops to a low duty cycle, 0 = off
+    void storeAdaptiveSampling(uint16_t stableSeconds);
+    uint16_t getAdaptiveSampling();
+
+    // Audio recorder mode (RecordingMode)
+    void storeRecordingMode(uint8_t mode);
+    uint8_t getRecordingMode();
+
+    // Venue calibration points (negative level: not measured) and their
+    // volumes, valid only for the level mode they were measured in
+    void storeVenueCalibration(uint8_t levelMode, float quietLevel, float busyLevel,
+                               uint8_t quietVolume, uint8_t busyVolume);
+    bool loadVenueCalibration(uint8_t levelMode, float& quietLevel, float& busyLevel,
+                              uint8_t& quietVolume, uint8_t& busyVolume);
+    void clearVenueCalibration();
+
+    // Volume schedule rules and the POSIX TZ string local time is read in
+    void storeVolumeSchedule(const ScheduleRule* rules, size_t count);
+    size_t loadVolumeSchedule(ScheduleRule* rules, size_t maxCount);
+    void storeTimezone(const char* timezone);
+    String getTimezone();
+
     // AP Configuration Constants
     static constexpr const char* AP_SSID = "ESP32_SETUP";
     static constexpr const char* AP_PASSWORD = "12345678";
@@ -89,6 +148,28 @@ private:
     static constexpr const char* PREF_CLIENT_SECRET = "client_secret";
     static constexpr const char* PREF_SOUND_ZONE_ID = "sound_zone";
     static constexpr const char* PREF_SENSITIVITY = "sensitivity";
+    static constexpr const char* PREF_CALIBRATION_OFFSET = "cal_offset";
+    static constexpr const char* PREF_LEVEL_MODE = "level_mode";
+    static constexpr const char* PREF_WEIGHTING = "weighting";
+    static constexpr const char* PREF_BAND_MODE = "band_mode";
+    static constexpr const char* PREF_TRANSIENT_WINDOW = "tr_window";
+    static constexpr const char* PREF_TRANSIENT_THRESHOLD = "tr_threshold";
+    static constexpr const char* PREF_FEEDBACK_MODEL = "fb_model";
+    static constexpr const char* PREF_NOISE_FLOOR = "noise_floor";
+    static constexpr const char* PREF_NOISE_FLOOR_MODE = "nf_mode";
+    static constexpr const char* PREF_CHANNEL_AGGREGATION = "ch_aggregation";
+    static constexpr const char* PREF_CHANNEL_WEIGHTS = "ch_weights";
+    static constexpr const char* PREF_ADAPTIVE_SAMPLING = "adaptive_time";
+    static constexpr const char* PREF_RECORDING_MODE = "rec_mode";
+    static constexpr const char* PREF_VENUE_MODE = "venue_mode";
+    static constexpr const char* PREF_VENUE_QUIET = "venue_quiet";
+    static constexpr const char* PREF_VENUE_BUSY = "venue_busy";
+    static constexpr const char* PREF_VENUE_QUIET_VOLUME = "venue_q_vol";
+    static constexpr const char* PREF_VENUE_BUSY_VOLUME = "venue_b_vol";
+    static constexpr const char* PREF_VOLUME_SCHEDULE = "vol_schedule";
+    static constexpr const char* PREF_TIMEZONE = "timezone";
+    static constexpr const char* PREF_PREFERENCE_MODEL = "pref_model";
+    static constexpr const char* PREF_OVERRIDE_HOLD = "override_hold";
 
     // Private helper methods
     bool loadCredentials();
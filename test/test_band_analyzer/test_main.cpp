@@ -0,0 +1,241 @@
+// FixedFft and BandAnalyzer against double precision: the real FFT bin by
+// bin against a direct DFT, and the band levels against the same Hann
+// window, bands and scaling computed in doubles.
+//
+//   pio test -e native -f test_band_analyzer
+
+#include <unity.h>
+#include <math.h>
+#include <stdio.h>
+#include <complex>
+#include <vector>
+#include "band_analyzer.h"
+#include "fixed_fft.h"
+
+namespace {
+
+constexpr size_t N = BandAnalyzer::FFT_SIZE;
+constexpr double RATE = SampleSource::SAMPLE_RATE;
+constexpr size_t BLOCK = SampleSource::BLOCK_SIZE;
+constexpr int32_t DC = 2048;
+
+// Error bounds, measured margins below them in the messages
+constexpr double FFT_ERROR_DB = -100.0;  // Error power relative to signal power
+constexpr double BAND_ERROR_DB = 0.01;   // Per band, for bands above BAND_FLOOR_DB
+constexpr double BAND_FLOOR_DB = -70.0;  // dBFS
+
+uint32_t lcg(uint32_t& state) {
+    state = state * 1664525u + 1013904223u;
+    return state;
+}
+
+std::vector<std::complex<double>> referenceDft(const std::vector<double>& x) {
+    std::vector<std::complex<double>> spectrum(N / 2 + 1);
+    for (size_t k = 0; k <= N / 2; k++) {
+        std::complex<double> sum = 0;
+        for (size_t n = 0; n < N; n++) {
+            // Index reduced mod N so the angle stays small and exact
+            sum += x[n] * std::polar(1.0, -2.0 * M_PI * static_cast<double>((k * n) % N) / N);
+        }
+        spectrum[k] = sum;
+    }
+    return spectrum;
+}
+
+// Ratio of the FFT's error power to the signal power, in dB
+double fftErrorDb(const std::vector<int32_t>& input) {
+    std::vector<int32_t> data(input);
+    FixedFft<N>::forward(data.data());
+    std::vector<double> x(input.begin(), input.end());
+    std::vector<std::complex<double>> exact = referenceDft(x);
+
+    double signal = 0;
+    double error = 0;
+    for (size_t k = 0; k <= N / 2; k++) {
+        std::complex<double> got = k == 0 ? std::complex<double>(data[0], 0)
+                                 : k == N / 2 ? std::complex<double>(data[1], 0)
+                                 : std::complex<double>(data[2 * k], data[2 * k + 1]);
+        signal += std::norm(exact[k]);
+        error += std::norm(got - exact[k]);
+    }
+    return 10.0 * log10(error / signal);
+}
+
+// Band levels the analyzer should report: the same periodic Hann window,
+// base-two bands (bins whose centre lies within the band edges) and
+// Parseval scaling, in doubles
+struct Reference {
+    std::vector<double> bandPower;
+    size_t frames = 0;
+};
+
+void referenceFrame(BandMode mode, const std::vector<int16_t>& frame, Reference& reference) {
+    std::vector<double> x(N);
+    double windowEnergy = 0;
+    for (size_t n = 0; n < N; n++) {
+        double w = 0.5 * (1.0 - cos(2.0 * M_PI * n / N));
+        x[n] = frame[n] * w;
+        windowEnergy += w * w;
+    }
+    std::vector<std::complex<double>> spectrum = referenceDft(x);
+    size_t bands = BandAnalyzer::getBandCount(mode);
+    int step = mode == BandMode::OCTAVE ? 6 : 2;  // Sixths of an octave
+    reference.bandPower.resize(bands);
+    for (size_t b = 0; b < bands; b++) {
+        double center = BandAnalyzer::getBandCenter(mode, b);
+        double low = center * pow(2.0, -step / 12.0);
+        double high = center * pow(2.0, step / 12.0);
+        size_t first = static_cast<size_t>(ceil(low / (RATE / N)));
+        size_t end = static_cast<size_t>(ceil(high / (RATE / N)));
+        end = end > first ? end : first + 1;
+        double power = 0;
+        for (size_t k = first; k < end && k < N / 2; k++) {
+            power += std::norm(spectrum[k]);
+        }
+        reference.bandPower[b] += 2.0 * power / (N * windowEnergy);
+    }
+    reference.frames++;
+}
+
+double referenceDbfs(const Reference& reference, size_t band) {
+    double meanSquare = reference.bandPower[band] / reference.frames;
+    return 10.0 * log10(meanSquare / (2048.0 * 2048.0 / 2.0));
+}
+
+// Runs blocks of raw ADC samples through the analyzer and the reference and
+// returns the worst band difference among bands above BAND_FLOOR_DB
+double worstBandErrorDb(BandMode mode, const std::vector<uint16_t>& samples, const char* name) {
+    BandAnalyzer analyzer;
+    analyzer.setMode(mode);
+    Reference reference;
+    std::vector<int16_t> frame(N);
+    for (size_t start = 0; start + BLOCK <= samples.size(); start += BLOCK) {
+        analyzer.addBlock(&samples[start], BLOCK, DC);
+        if (start + BLOCK >= N) {
+            for (size_t n = 0; n < N; n++) {
+                frame[n] = static_cast<int16_t>(samples[start + BLOCK - N + n] - DC);
+            }
+            referenceFrame(mode, frame, reference);
+        }
+    }
+    float bandDbfs[BandAnalyzer::MAX_BANDS];
+    float speech;
+    TEST_ASSERT_TRUE(analyzer.finishWindow(bandDbfs, speech));
+
+    double worst = 0;
+    size_t checked = 0;
+    for (size_t b = 0; b < analyzer.getBandCount(); b++) {
+        double expected = referenceDbfs(reference, b);
+        if (expected < BAND_FLOOR_DB) {
+            continue;
+        }
+        checked++;
+        double error = fabs(bandDbfs[b] - expected);
+        if (error > worst) {
+            worst = error;
+        }
+        char message[128];
+        snprintf(message, sizeof(message), "%s band %.0f Hz: %.3f dBFS, reference %.3f dBFS", name,
+                 BandAnalyzer::getBandCenter(mode, b), bandDbfs[b], expected);
+        TEST_ASSERT_FLOAT_WITHIN_MESSAGE(BAND_ERROR_DB, expected, bandDbfs[b], message);
+    }
+    TEST_ASSERT_TRUE(checked > 0);
+    return worst;
+}
+
+std::vector<uint16_t> noiseSamples(size_t count, int amplitude, uint32_t seed) {
+    std::vector<uint16_t> samples(count);
+    for (uint16_t& sample : samples) {
+        sample = static_cast<uint16_t>(DC + static_cast<int>(lcg(seed) % (2 * amplitude + 1)) - amplitude);
+    }
+    return samples;
+}
+
+std::vector<uint16_t> toneSamples(size_t count, double hz, double amplitude) {
+    std::vector<uint16_t> samples(count);
+    for (size_t n = 0; n < count; n++) {
+        samples[n] = static_cast<uint16_t>(DC + lround(amplitude * sin(2.0 * M_PI * hz * n / RATE)));
+    }
+    return samples;
+}
+
+} // namespace
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+// Full-range random input, the documented headroom limit
+void test_fft_matches_dft_on_noise() {
+    uint32_t seed = 7;
+    std::vector<int32_t> input(N);
+    for (int32_t& x : input) {
+        x = static_cast<int32_t>(lcg(seed) >> 13) - (1 << 18);
+    }
+    double errorDb = fftErrorDb(input);
+    char message[96];
+    snprintf(message, sizeof(message), "FFT error power %.1f dB below the signal (bound %.0f dB)", -errorDb,
+             -FFT_ERROR_DB);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_TRUE_MESSAGE(errorDb <= FFT_ERROR_DB, message);
+}
+
+// A windowed tone at the band analyzer's input scale, off the bin grid
+void test_fft_matches_dft_on_tone() {
+    std::vector<int32_t> input(N);
+    for (size_t n = 0; n < N; n++) {
+        double w = 0.5 * (1.0 - cos(2.0 * M_PI * n / N));
+        input[n] = static_cast<int32_t>(lround(2000.0 * 128 * w * sin(2.0 * M_PI * 1234.5 * n / RATE)));
+    }
+    double errorDb = fftErrorDb(input);
+    char message[96];
+    snprintf(message, sizeof(message), "FFT error power %.1f dB below the signal (bound %.0f dB)", -errorDb,
+             -FFT_ERROR_DB);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_TRUE_MESSAGE(errorDb <= FFT_ERROR_DB, message);
+}
+
+void test_octave_bands_on_noise() {
+    double worst = worstBandErrorDb(BandMode::OCTAVE, noiseSamples(N + 8 * BLOCK, 1500, 11), "octave");
+    char message[64];
+    snprintf(message, sizeof(message), "octave bands within %.4f dB", worst);
+    TEST_MESSAGE(message);
+}
+
+void test_third_octave_bands_on_noise() {
+    double worst = worstBandErrorDb(BandMode::THIRD_OCTAVE, noiseSamples(N + 8 * BLOCK, 1500, 13), "third");
+    char message[64];
+    snprintf(message, sizeof(message), "third-octave bands within %.4f dB", worst);
+    TEST_MESSAGE(message);
+}
+
+// Quiet input: 12-bit samples a few counts wide, where the window's Q15
+// rounding and the >> 8 input scaling matter most
+void test_third_octave_bands_on_quiet_noise() {
+    double worst = worstBandErrorDb(BandMode::THIRD_OCTAVE, noiseSamples(N + 8 * BLOCK, 6, 17), "quiet");
+    char message[64];
+    snprintf(message, sizeof(message), "quiet third-octave bands within %.4f dB", worst);
+    TEST_MESSAGE(message);
+}
+
+void test_third_octave_bands_on_tones() {
+    const double tones[] = {250.0, 1000.0, 3150.0, 7000.0};
+    for (double hz : tones) {
+        char name[32];
+        snprintf(name, sizeof(name), "%.0f Hz tone", hz);
+        worstBandErrorDb(BandMode::THIRD_OCTAVE, toneSamples(N + 4 * BLOCK, hz, 1800.0), name);
+    }
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_fft_matches_dft_on_noise);
+    RUN_TEST(test_fft_matches_dft_on_tone);
+    RUN_TEST(test_octave_bands_on_noise);
+    RUN_TEST(test_third_octave_bands_on_noise);
+    RUN_TEST(test_third_octave_bands_on_quiet_noise);
+    RUN_TEST(test_third_octave_bands_on_tones);
+    return UNITY_END();
+}
@@ -0,0 +1,247 @@
+// CicDecimator against a double-precision reference resampler (a Kaiser-
+// windowed sinc low-pass at the capture rate, kept every Factor-th output):
+// passband gain and alias rejection at every supported factor.
+//
+//   pio test -e native -f test_decimator
+
+#include <unity.h>
+#include <math.h>
+#include <stdio.h>
+#include <vector>
+#include "decimator.h"
+#include "sample_source.h"
+
+namespace {
+
+constexpr double OUTPUT_RATE = SampleSource::SAMPLE_RATE;
+constexpr size_t SETTLE = 512;    // Output samples dropped before measuring
+constexpr size_t MEASURE = 8000;  // 0.25 s: whole periods of every multiple of 4 Hz
+constexpr double DC = 2048.0;
+constexpr double AMPLITUDE = 1500.0;
+
+// The header's claims
+constexpr double PASSBAND_HZ = 8000.0;
+constexpr double PASSBAND_DB = 0.1;
+
+// Worst alias allowed back into the output, by where it lands. Folds into
+// the passband are the CIC's alone (the FIR cannot tell them from signal);
+// only near the output Nyquist does the FIR's stopband add to it
+struct AliasLimit {
+    double outputHz;
+    double maxDbFactor2;  // Factor 2 has the shallowest CIC nulls
+    double maxDb;         // Factors 4 to 16
+};
+
+const AliasLimit ALIAS_LIMITS[] = {
+    {4000.0, -41.0, -48.0},
+    {6000.0, -30.0, -35.0},
+    {8000.0, -22.0, -27.0},
+    {10000.0, -17.0, -20.0},
+    {12000.0, -16.0, -19.0},
+    {15000.0, -38.0, -40.0},
+};
+
+// Kaiser-windowed sinc: flat to 1e-4 dB below 8 kHz and at least 90 dB down
+// from 16 kHz of the output rate, at any capture rate
+std::vector<double> referenceTaps(uint32_t factor) {
+    const double rate = OUTPUT_RATE * factor;
+    const double cutoff = 12000.0 / rate;          // Cycles per input sample
+    const double transition = 2.0 * 3800.0 / rate; // Each side of the cutoff
+    const double attenuation = 100.0;
+    const double beta = 0.1102 * (attenuation - 8.7);
+    size_t taps = static_cast<size_t>(ceil((attenuation - 8.0) / (2.285 * 2.0 * M_PI * transition))) | 1;
+    auto besselI0 = [](double x) {
+        double sum = 1.0, term = 1.0;
+        for (int k = 1; k < 50; k++) {
+            term *= (x / (2.0 * k)) * (x / (2.0 * k));
+            sum += term;
+        }
+        return sum;
+    };
+    std::vector<double> h(taps);
+    double middle = (taps - 1) / 2.0;
+    double dc = 0;
+    for (size_t n = 0; n < taps; n++) {
+        double t = n - middle;
+        double sinc = t == 0 ? 2.0 * cutoff : sin(2.0 * M_PI * cutoff * t) / (M_PI * t);
+        double r = t / middle;
+        h[n] = sinc * besselI0(beta * sqrt(1.0 - r * r)) / besselI0(beta);
+        dc += h[n];
+    }
+    for (double& tap : h) {
+        tap /= dc;
+    }
+    return h;
+}
+
+// Amplitude of the hz component of the measured outputs, by projection
+double toneAmplitude(const std::vector<double>& output, double hz) {
+    double c = 0, s = 0;
+    for (size_t n = 0; n < MEASURE; n++) {
+        double phase = 2.0 * M_PI * hz * n / OUTPUT_RATE;
+        c += output[SETTLE + n] * cos(phase);
+        s += output[SETTLE + n] * sin(phase);
+    }
+    return 2.0 * sqrt(c * c + s * s) / MEASURE;
+}
+
+struct Result {
+    double decimatorDb;  // Gain at outputHz, relative to the input tone
+    double referenceDb;
+};
+
+// One tone at inputHz through both; levels read at outputHz, where it lands
+template <uint32_t Factor>
+Result run(double inputHz, double outputHz) {
+    const double rate = OUTPUT_RATE * Factor;
+    const size_t outputs = SETTLE + MEASURE;
+    std::vector<double> h = referenceTaps(Factor);
+    size_t inputCount = outputs * Factor + h.size();
+
+    std::vector<uint16_t> input(inputCount);
+    for (size_t n = 0; n < inputCount; n++) {
+        input[n] = static_cast<uint16_t>(lround(DC + AMPLITUDE * sin(2.0 * M_PI * inputHz * n / rate)));
+    }
+
+    CicDecimator<Factor> decimator;
+    std::vector<uint16_t> buffer(input.begin(), input.begin() + outputs * Factor);
+    const size_t block = SampleSource::BLOCK_SIZE;
+    for (size_t start = 0; start < outputs; start += block) {
+        size_t count = outputs - start < block ? outputs - start : block;
+        decimator.process(&buffer[start * Factor], count);
+        for (size_t i = 0; i < count; i++) {
+            buffer[start + i] = buffer[start * Factor + i];
+        }
+    }
+    std::vector<double> decimated(buffer.begin(), buffer.begin() + outputs);
+
+    std::vector<double> reference(outputs);
+    for (size_t m = 0; m < outputs; m++) {
+        double sum = 0;
+        for (size_t k = 0; k < h.size(); k++) {
+            sum += h[k] * input[m * Factor + k];
+        }
+        reference[m] = sum;
+    }
+
+    return Result{20.0 * log10(toneAmplitude(decimated, outputHz) / AMPLITUDE),
+                  20.0 * log10(toneAmplitude(reference, outputHz) / AMPLITUDE)};
+}
+
+template <uint32_t Factor>
+void checkPassband() {
+    double worst = 0;
+    for (double hz = 100.0; hz <= PASSBAND_HZ; hz += 100.0 * (hz < 1000 ? 1 : hz < 4000 ? 5 : 2)) {
+        Result result = run<Factor>(hz, hz);
+        double error = fabs(result.decimatorDb - result.referenceDb);
+        worst = error > worst ? error : worst;
+        char message[128];
+        snprintf(message, sizeof(message), "factor %u at %.0f Hz: %.3f dB, reference %.4f dB",
+                 static_cast<unsigned>(Factor), hz, result.decimatorDb, result.referenceDb);
+        TEST_ASSERT_TRUE_MESSAGE(error <= PASSBAND_DB, message);
+    }
+    char message[96];
+    snprintf(message, sizeof(message), "factor %u: passband within %.3f dB of the reference to %.0f Hz",
+             static_cast<unsigned>(Factor), worst, PASSBAND_HZ);
+    TEST_MESSAGE(message);
+}
+
+// Tones above the output Nyquist, from the first image just past it to the
+// last one below the capture Nyquist, folded into the band at each limit's
+// frequency
+template <uint32_t Factor>
+void checkAliases() {
+    for (const AliasLimit& limit : ALIAS_LIMITS) {
+        double worst = -INFINITY;
+        double worstInput = 0;
+        for (uint32_t image = 1; image <= Factor / 2; image++) {
+            const double centres[] = {image * OUTPUT_RATE - limit.outputHz, image * OUTPUT_RATE + limit.outputHz};
+            for (double inputHz : centres) {
+                if (inputHz >= OUTPUT_RATE * Factor / 2) {
+                    continue;
+                }
+                Result result = run<Factor>(inputHz, limit.outputHz);
+                char message[128];
+                snprintf(message, sizeof(message), "factor %u: %.0f Hz aliases to %.0f Hz at %.1f dB (reference %.1f dB)",
+                         static_cast<unsigned>(Factor), inputHz, limit.outputHz, result.decimatorDb,
+                         result.referenceDb);
+                TEST_ASSERT_TRUE_MESSAGE(result.referenceDb < -70.0, message);
+                TEST_ASSERT_TRUE_MESSAGE(result.decimatorDb <= (Factor == 2 ? limit.maxDbFactor2 : limit.maxDb),
+                                         message);
+                if (result.decimatorDb > worst) {
+                    worst = result.decimatorDb;
+                    worstInput = inputHz;
+                }
+            }
+        }
+        char message[96];
+        snprintf(message, sizeof(message), "factor %u: aliases into %.0f Hz at most %.1f dB (from %.0f Hz)",
+                 static_cast<unsigned>(Factor), limit.outputHz, worst, worstInput);
+        TEST_MESSAGE(message);
+    }
+}
+
+} // namespace
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+void test_passband_factor_2() {
+    checkPassband<2>();
+}
+
+void test_passband_factor_4() {
+    checkPassband<4>();
+}
+
+void test_passband_factor_8() {
+    checkPassband<8>();
+}
+
+void test_passband_factor_16() {
+    checkPassband<16>();
+}
+
+void test_aliases_factor_2() {
+    checkAliases<2>();
+}
+
+void test_aliases_factor_4() {
+    checkAliases<4>();
+}
+
+void test_aliases_factor_8() {
+    checkAliases<8>();
+}
+
+void test_aliases_factor_16() {
+    checkAliases<16>();
+}
+
+// A constant input comes out unchanged from the first sample (the stages
+// are primed on it)
+void test_dc_passes_from_start() {
+    CicDecimator<8> decimator;
+    std::vector<uint16_t> buffer(8 * 64, 1234);
+    decimator.process(buffer.data(), 64);
+    for (size_t i = 0; i < 64; i++) {
+        TEST_ASSERT_EQUAL_UINT32(1234, buffer[i]);
+    }
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_passband_factor_2);
+    RUN_TEST(test_passband_factor_4);
+    RUN_TEST(test_passband_factor_8);
+    RUN_TEST(test_passband_factor_16);
+    RUN_TEST(test_aliases_factor_2);
+    RUN_TEST(test_aliases_factor_4);
+    RUN_TEST(test_aliases_factor_8);
+    RUN_TEST(test_aliases_factor_16);
+    RUN_TEST(test_dc_passes_from_start);
+    return UNITY_END();
+}
@@ -0,0 +1,197 @@
+// Every error bound documented in fast_math.h, against double-precision libm:
+// the table kernels over the whole float (and uint64_t) range, the special
+// inputs, roundingShift() exactly, and the compile-time helpers the filter
+// and table design use.
+//
+//   pio test -e native -f test_fast_math
+
+#include <unity.h>
+#include <math.h>
+#include <stdio.h>
+#include "fast_math.h"
+
+namespace {
+
+// Geometric sweep over the positive normal floats; the odd count puts the
+// points at every mantissa position, not only table nodes
+constexpr size_t SWEEP = 1000003;
+constexpr double SWEEP_LOW = 1.2e-38;
+constexpr double SWEEP_HIGH = 3.4e38;
+
+float sweepValue(size_t i) {
+    double t = static_cast<double>(i) / (SWEEP - 1);
+    return static_cast<float>(SWEEP_LOW * pow(SWEEP_HIGH / SWEEP_LOW, t));
+}
+
+uint64_t lcg64(uint64_t& state) {
+    state = state * 6364136223846793005ull + 1442695040888963407ull;
+    return state;
+}
+
+void assertWithin(double bound, double worst, float worstInput, const char* kernel) {
+    char message[96];
+    snprintf(message, sizeof(message), "%s: error %.3g at %.9g, bound %.3g", kernel, worst, worstInput, bound);
+    TEST_ASSERT_TRUE_MESSAGE(worst <= bound, message);
+}
+
+template <typename Fast, typename Exact>
+void checkAbsolute(Fast fast, Exact exact, double bound, const char* kernel) {
+    double worst = 0;
+    float worstInput = 0;
+    for (size_t i = 0; i < SWEEP; i++) {
+        float x = sweepValue(i);
+        double error = fabs(fast(x) - exact(static_cast<double>(x)));
+        if (error > worst) {
+            worst = error;
+            worstInput = x;
+        }
+    }
+    assertWithin(bound, worst, worstInput, kernel);
+}
+
+} // namespace
+
+void setUp() {}
+void tearDown() {}
+
+void test_log2_float_within_bound() {
+    checkAbsolute([](float x) { return fastLog2(x); }, [](double x) { return log2(x); }, 8e-6, "fastLog2");
+}
+
+void test_log2_uint64_within_bound() {
+    double worst = 0;
+    float worstInput = 0;
+    auto check = [&](uint64_t x) {
+        double error = fabs(fastLog2(x) - log2(static_cast<double>(x)));
+        if (error > worst) {
+            worst = error;
+            worstInput = static_cast<float>(x);
+        }
+    };
+    // Every small integer, then random magnitudes up to 2^64 - 1
+    for (uint64_t x = 1; x < (1u << 20); x++) {
+        check(x);
+    }
+    uint64_t state = 1;
+    for (int i = 0; i < 1000000; i++) {
+        uint64_t x = lcg64(state) >> (lcg64(state) >> 58);
+        check(x != 0 ? x : 1);
+    }
+    check(UINT64_MAX);
+    assertWithin(5e-6, worst, worstInput, "fastLog2(uint64_t)");
+}
+
+void test_log10_within_bound() {
+    checkAbsolute([](float x) { return fastLog10(x); }, [](double x) { return log10(x); }, 6e-6, "fastLog10");
+}
+
+void test_power_to_db_within_bound() {
+    checkAbsolute([](float x) { return powerToDb(x); }, [](double x) { return 10.0 * log10(x); }, 6e-5,
+                  "powerToDb");
+}
+
+void test_sqrt_within_bound() {
+    double worst = 0;
+    float worstInput = 0;
+    for (size_t i = 0; i < SWEEP; i++) {
+        float x = sweepValue(i);
+        double exact = sqrt(static_cast<double>(x));
+        double error = fabs(fastSqrt(x) - exact) / exact;
+        if (error > worst) {
+            worst = error;
+            worstInput = x;
+        }
+    }
+    assertWithin(7e-7, worst, worstInput, "fastSqrt");
+}
+
+void test_powers_of_two_are_exact() {
+    for (int k = -126; k <= 127; k++) {
+        float x = ldexpf(1.0f, k);
+        TEST_ASSERT_TRUE(fastLog2(x) == static_cast<float>(k));
+        if (k % 2 == 0) {
+            TEST_ASSERT_TRUE(fastSqrt(x) == ldexpf(1.0f, k / 2));
+        }
+    }
+    for (int k = 0; k < 64; k++) {
+        TEST_ASSERT_TRUE(fastLog2(static_cast<uint64_t>(1) << k) == static_cast<float>(k));
+    }
+}
+
+void test_special_inputs() {
+    const float nonPositive[] = {0.0f, -0.0f, -1.0f, -INFINITY, NAN, 1e-40f};  // 1e-40: subnormal
+    for (float x : nonPositive) {
+        TEST_ASSERT_TRUE(fastLog2(x) == LOG2_OF_ZERO);
+        TEST_ASSERT_TRUE(fastSqrt(x) == 0.0f);
+    }
+    TEST_ASSERT_TRUE(fastLog2(static_cast<uint64_t>(0)) == LOG2_OF_ZERO);
+    TEST_ASSERT_TRUE(fastLog10(0.0f) == LOG2_OF_ZERO * LOG10_OF_2);
+    TEST_ASSERT_TRUE(isinf(fastSqrt(INFINITY)));
+}
+
+// floor(x / 2^shift + 1/2) in exact arithmetic: halves round up
+void test_rounding_shift_is_exact() {
+    for (int shift = 1; shift <= 16; shift++) {
+        for (int32_t x = -200000; x <= 200000; x++) {
+            int32_t expected = static_cast<int32_t>(floor(x / ldexp(1.0, shift) + 0.5));
+            if (roundingShift(x, shift) != expected) {
+                char message[64];
+                snprintf(message, sizeof(message), "roundingShift(%d, %d)", static_cast<int>(x), shift);
+                TEST_FAIL_MESSAGE(message);
+            }
+        }
+    }
+    // 64-bit accumulators, kept below 2^52 so the double reference is exact
+    uint64_t state = 7;
+    for (int i = 0; i < 1000000; i++) {
+        int64_t x = static_cast<int64_t>(lcg64(state)) >> 12;
+        int shift = 1 + static_cast<int>(lcg64(state) % 40);
+        int64_t expected = static_cast<int64_t>(floor(x / ldexp(1.0, shift) + 0.5));
+        TEST_ASSERT_TRUE(roundingShift(x, shift) == expected);
+    }
+    static_assert(roundingShift(5, 1) == 3 && roundingShift(-5, 1) == -2, "halves round up");
+}
+
+void test_compile_time_helpers_within_bound() {
+    double sinError = 0;
+    double cosError = 0;
+    double tanError = 0;
+    double lnError = 0;
+    for (int i = 0; i <= 100000; i++) {
+        double x = -CONSTEXPR_PI + 2.0 * CONSTEXPR_PI * i / 100000;
+        sinError = fmax(sinError, fabs(constexprSin(x) - sin(x)));
+        cosError = fmax(cosError, fabs(constexprCos(x) - cos(x)));
+        double y = -1.4 + 2.8 * i / 100000;
+        if (y != 0) {
+            tanError = fmax(tanError, fabs(constexprTan(y) - tan(y)) / fabs(tan(y)));
+        }
+        double z = 1.0 + i / 100000.0;
+        lnError = fmax(lnError, fabs(constexprLn(z) - log(z)));
+    }
+    TEST_ASSERT_TRUE_MESSAGE(sinError <= 1e-15, "constexprSin");
+    TEST_ASSERT_TRUE_MESSAGE(cosError <= 1e-15, "constexprCos");
+    TEST_ASSERT_TRUE_MESSAGE(tanError <= 5e-15, "constexprTan");
+    TEST_ASSERT_TRUE_MESSAGE(lnError <= 1e-15, "constexprLn");
+
+    // Within 1 ulp from 1e-30 to 1e30
+    for (double e = -30; e <= 30; e += 0.01) {
+        double x = pow(10.0, e);
+        double exact = sqrt(x);
+        TEST_ASSERT_TRUE_MESSAGE(fabs(constexprSqrt(x) - exact) <= exact * 2.3e-16, "constexprSqrt");
+    }
+    TEST_ASSERT_TRUE(constexprSqrt(0.0) == 0.0 && constexprSqrt(-1.0) == 0.0);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_log2_float_within_bound);
+    RUN_TEST(test_log2_uint64_within_bound);
+    RUN_TEST(test_log10_within_bound);
+    RUN_TEST(test_power_to_db_within_bound);
+    RUN_TEST(test_sqrt_within_bound);
+    RUN_TEST(test_powers_of_two_are_exact);
+    RUN_TEST(test_special_inputs);
+    RUN_TEST(test_rounding_shift_is_exact);
+    RUN_TEST(test_compile_time_helpers_within_bound);
+    return UNITY_END();
+}
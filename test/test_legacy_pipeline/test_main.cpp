@@ -0,0 +1,193 @@
+// LegacyLevelPipeline against the original SoundSensor::getSoundLevel()
+// (analogRead loop, EMA, pow(x, 0.5)), and SoundSensor's peak-to-peak mode
+// against LegacyLevelPipeline on the same blocks.
+//
+//   pio test -e native -f test_legacy_pipeline
+
+#include <unity.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "pipeline_stages.h"
+#include "sound_sensor.h"
+
+namespace {
+
+constexpr size_t BLOCK = SampleSource::BLOCK_SIZE;
+constexpr size_t WINDOW_BLOCKS = 3;  // 50 ms at 32 kHz, as SoundSensor rounds it
+constexpr float ALPHA = 0.2f;
+
+// fastSqrt's documented relative error plus the float rounding of pow's result
+constexpr float SQRT_TOLERANCE = 1e-6f;
+
+// The original level, one call per window of samples: the else-if skips the
+// minimum check on a sample that raised the maximum, and samples at 4095
+// are dropped
+class OriginalSoundLevel {
+public:
+    float getSoundLevel(const uint16_t* window, size_t count) {
+        unsigned int signalMax = 0;
+        unsigned int signalMin = 4095;
+        for (size_t i = 0; i < count; i++) {
+            unsigned int sample = window[i];
+            if (sample < 4095) {
+                if (sample > signalMax) {
+                    signalMax = sample;
+                } else if (sample < signalMin) {
+                    signalMin = sample;
+                }
+            }
+        }
+        unsigned int peakToPeak = signalMax - signalMin;
+        _filteredSignal = _alpha * peakToPeak + (1 - _alpha) * _filteredSignal;
+        float normalizedSignal = _filteredSignal / 4095.0;
+        return pow(normalizedSignal, 0.5);
+    }
+
+private:
+    float _alpha = ALPHA;
+    float _filteredSignal = 0;
+};
+
+uint32_t lcg(uint32_t& state) {
+    state = state * 1664525u + 1013904223u;
+    return state;
+}
+
+// Windows of noise around the bias with a slowly changing spread, all below
+// the rail. The first sample of each window sits above the window's minimum,
+// the one case where the original's else-if would miss it.
+std::vector<uint16_t> windows(size_t count, uint32_t seed) {
+    std::vector<uint16_t> samples(count * WINDOW_BLOCKS * BLOCK);
+    for (size_t w = 0; w < count; w++) {
+        int spread = 2 + static_cast<int>(lcg(seed) % 2000);
+        uint16_t* window = &samples[w * WINDOW_BLOCKS * BLOCK];
+        for (size_t i = 0; i < WINDOW_BLOCKS * BLOCK; i++) {
+            window[i] = static_cast<uint16_t>(2047 + static_cast<int>(lcg(seed) % (2 * spread + 1)) - spread);
+        }
+        window[0] = 2047;
+        window[WINDOW_BLOCKS * BLOCK - 1] = static_cast<uint16_t>(2047 - spread);
+    }
+    return samples;
+}
+
+LegacyLevelPipeline makeLegacyPipeline() {
+    LegacyLevelPipeline pipeline;
+    pipeline.get<WindowFraming>().setBlocksPerWindow(WINDOW_BLOCKS);
+    pipeline.get<EmaEnvelope>().setAlpha(ALPHA);
+    return pipeline;
+}
+
+// Hands out prepared blocks to SoundSensor
+class BlockSource : public SampleSource {
+public:
+    explicit BlockSource(const std::vector<uint16_t>& samples)
+        : _samples(samples) {
+    }
+
+    bool begin() override {
+        return true;
+    }
+
+    void end() override {
+    }
+
+    bool readBlock(uint16_t* buffer, uint32_t) override {
+        if (_next + CAPTURE_BLOCK_SIZE > _samples.size()) {
+            return false;
+        }
+        for (size_t c = 0; c < CHANNELS; c++) {
+            memcpy(&buffer[c * CAPTURE_BLOCK_SIZE], &_samples[_next], CAPTURE_BLOCK_SIZE * sizeof(uint16_t));
+        }
+        _next += CAPTURE_BLOCK_SIZE;
+        return true;
+    }
+
+private:
+    const std::vector<uint16_t>& _samples;
+    size_t _next = 0;
+};
+
+} // namespace
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+void test_legacy_pipeline_matches_original() {
+    std::vector<uint16_t> samples = windows(2000, 21);
+    LegacyLevelPipeline pipeline = makeLegacyPipeline();
+    OriginalSoundLevel original;
+    size_t compared = 0;
+    for (size_t w = 0; w < samples.size() / (WINDOW_BLOCKS * BLOCK); w++) {
+        const uint16_t* window = &samples[w * WINDOW_BLOCKS * BLOCK];
+        for (size_t b = 0; b < WINDOW_BLOCKS; b++) {
+            TEST_ASSERT_EQUAL(b == WINDOW_BLOCKS - 1, pipeline.process(&window[b * BLOCK]));
+        }
+        float expected = original.getSoundLevel(window, WINDOW_BLOCKS * BLOCK);
+        float level = pipeline.frame().level;
+        if (fabsf(level - expected) > SQRT_TOLERANCE * expected) {
+            char message[96];
+            snprintf(message, sizeof(message), "window %u: level %.9f, original %.9f",
+                     static_cast<unsigned>(w), level, expected);
+            TEST_FAIL_MESSAGE(message);
+        }
+        compared++;
+    }
+    TEST_ASSERT_EQUAL_UINT32(2000, compared);
+}
+
+// The deliberate difference: samples at the rails now count, so a clipping
+// window reads as full scale instead of whatever stayed in range
+void test_rails_count_toward_peak_to_peak() {
+    std::vector<uint16_t> window(WINDOW_BLOCKS * BLOCK, 2047);
+    window[100] = 4095;
+    window[200] = 0;
+    LegacyLevelPipeline pipeline = makeLegacyPipeline();
+    pipeline.get<EmaEnvelope>().setAlpha(1.0f);
+    for (size_t b = 0; b < WINDOW_BLOCKS; b++) {
+        pipeline.process(&window[b * BLOCK]);
+    }
+    TEST_ASSERT_EQUAL_UINT32(4095, pipeline.get<PeakToPeakDetector>().getPeakToPeak());
+    TEST_ASSERT_FLOAT_WITHIN(SQRT_TOLERANCE, 1.0f, pipeline.frame().level);
+}
+
+// SoundSensor's peak-to-peak level with the transient filter off is the
+// legacy pipeline's level, bit for bit
+void test_sound_sensor_peak_mode_matches_legacy_pipeline() {
+    std::vector<uint16_t> samples = windows(600, 33);
+    BlockSource source(samples);
+    SoundSensor sensor(source, 50, ALPHA);
+    TEST_ASSERT_TRUE(sensor.begin());
+    TEST_ASSERT_TRUE(sensor.setTransientFilter(0, HampelFilter::DEFAULT_THRESHOLD));
+    LegacyLevelPipeline pipeline = makeLegacyPipeline();
+
+    size_t windowsSeen = 0;
+    for (size_t start = 0; start + BLOCK <= samples.size(); start += BLOCK) {
+        TEST_ASSERT_TRUE(sensor.process(0));
+        if (!pipeline.process(&samples[start])) {
+            continue;
+        }
+        SoundReading reading;
+        TEST_ASSERT_TRUE(sensor.poll(reading));
+        if (reading.level != pipeline.frame().level) {
+            char message[96];
+            snprintf(message, sizeof(message), "window %u: sensor %.9f, legacy pipeline %.9f",
+                     static_cast<unsigned>(windowsSeen), reading.level, pipeline.frame().level);
+            TEST_FAIL_MESSAGE(message);
+        }
+        windowsSeen++;
+    }
+    TEST_ASSERT_EQUAL_UINT32(600, windowsSeen);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_legacy_pipeline_matches_original);
+    RUN_TEST(test_rails_count_toward_peak_to_peak);
+    RUN_TEST(test_sound_sensor_peak_mode_matches_legacy_pipeline);
+    return UNITY_END();
+}
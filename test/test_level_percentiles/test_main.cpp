@@ -0,0 +1,167 @@
+// LevelPercentiles against sort-based percentiles over the same sliding
+// window: random window sizes and levels, many times round the ring, heavy
+// duplicates, values on bin edges and out of range.
+//
+//   pio test -e native -f test_level_percentiles
+
+#include <unity.h>
+#include <math.h>
+#include <stdio.h>
+#include <algorithm>
+#include <deque>
+#include <vector>
+#include "level_percentiles.h"
+
+namespace {
+
+const uint8_t PERCENTS[] = {0, 1, 10, 50, 90, 99, 100};
+
+// The header's bound: the bin centre is within half a bin of the exact value
+constexpr float BOUND_DB = LevelPercentiles::BIN_DB / 2 + 1e-4f;
+
+uint32_t lcg(uint32_t& state) {
+    state = state * 1664525u + 1013904223u;
+    return state;
+}
+
+float clampLevel(float dbfs) {
+    const float top = LevelPercentiles::MIN_DB + LevelPercentiles::BIN_COUNT * LevelPercentiles::BIN_DB;
+    return dbfs < LevelPercentiles::MIN_DB ? LevelPercentiles::MIN_DB : dbfs > top ? top : dbfs;
+}
+
+// L_N by sorting: the level with floor(count * N / 100) values above it, the
+// same rank the histogram walk stops at
+float sortedLevel(const std::deque<float>& window, uint8_t percentExceeded) {
+    std::vector<float> values(window.begin(), window.end());
+    std::sort(values.begin(), values.end(), [](float a, float b) { return a > b; });
+    size_t rank = values.size() * percentExceeded / 100;
+    return clampLevel(values[rank < values.size() ? rank : values.size() - 1]);
+}
+
+// Feeds count values from next() and compares every checkEvery values
+template <typename Next>
+void checkStream(size_t windowSize, size_t count, size_t checkEvery, Next next, const char* name) {
+    LevelPercentiles percentiles;
+    TEST_ASSERT_TRUE(percentiles.setWindow(windowSize));
+    std::deque<float> window;
+    for (size_t i = 1; i <= count; i++) {
+        float dbfs = next();
+        percentiles.add(dbfs);
+        window.push_back(dbfs);
+        if (window.size() > windowSize) {
+            window.pop_front();
+        }
+        TEST_ASSERT_EQUAL_UINT32(window.size(), percentiles.getCount());
+        if (i % checkEvery != 0 && i != count) {
+            continue;
+        }
+        for (uint8_t percent : PERCENTS) {
+            float expected = sortedLevel(window, percent);
+            float level = percentiles.getLevel(percent);
+            if (fabsf(level - expected) > BOUND_DB) {
+                char message[160];
+                snprintf(message, sizeof(message),
+                         "%s: window %u after %u values, L%u %.3f dB, sorted %.3f dB", name,
+                         static_cast<unsigned>(windowSize), static_cast<unsigned>(i), percent, level,
+                         expected);
+                TEST_FAIL_MESSAGE(message);
+            }
+        }
+    }
+}
+
+} // namespace
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+void test_empty_window() {
+    LevelPercentiles percentiles;
+    TEST_ASSERT_EQUAL_UINT32(0, percentiles.getCount());
+    TEST_ASSERT_FLOAT_WITHIN(0.0f, LevelPercentiles::MIN_DB, percentiles.getLevel(50));
+    TEST_ASSERT_FALSE(percentiles.setWindow(0));
+    TEST_ASSERT_FALSE(percentiles.setWindow(LevelPercentiles::MAX_VALUES + 1));
+}
+
+// Random window sizes, each filled and wrapped several times
+void test_random_windows() {
+    uint32_t seed = 3;
+    for (int run = 0; run < 40; run++) {
+        size_t windowSize = 1 + lcg(seed) % LevelPercentiles::MAX_VALUES;
+        size_t count = windowSize * (2 + lcg(seed) % 3) + lcg(seed) % windowSize;
+        checkStream(windowSize, count, 1 + windowSize / 7, [&seed]() {
+            return -90.0f + 80.0f * (lcg(seed) >> 8) / 16777216.0f;
+        }, "random");
+    }
+}
+
+// Small windows checked after every value, across every wrap of the ring
+void test_small_windows_every_value() {
+    uint32_t seed = 5;
+    for (size_t windowSize = 1; windowSize <= 12; windowSize++) {
+        checkStream(windowSize, windowSize * 6 + 1, 1, [&seed]() {
+            return -70.0f + 40.0f * (lcg(seed) >> 8) / 16777216.0f;
+        }, "small");
+    }
+}
+
+// A handful of distinct levels, some on bin edges: long runs of equal values
+// on both sides of every rank
+void test_duplicates() {
+    const float levels[] = {-60.0f, -42.5f, -42.25f, -30.0f, -30.0f, -12.0f};
+    uint32_t seed = 9;
+    checkStream(600, 3000, 37, [&]() {
+        return levels[lcg(seed) % (sizeof(levels) / sizeof(levels[0]))];
+    }, "duplicates");
+
+    // Every value the same, then a step to another constant through the window
+    size_t n = 0;
+    checkStream(100, 400, 1, [&n]() {
+        return n++ < 150 ? -55.0f : -20.0f;
+    }, "step");
+}
+
+// Levels past either end of the histogram count in its outermost bins
+void test_out_of_range() {
+    uint32_t seed = 11;
+    checkStream(300, 1200, 13, [&seed]() {
+        return -130.0f + 160.0f * (lcg(seed) >> 8) / 16777216.0f;
+    }, "out of range");
+}
+
+// Shrinking or growing the window starts over
+void test_set_window_resets() {
+    LevelPercentiles percentiles;
+    for (int i = 0; i < 50; i++) {
+        percentiles.add(-10.0f);
+    }
+    TEST_ASSERT_TRUE(percentiles.setWindow(20));
+    TEST_ASSERT_EQUAL_UINT32(0, percentiles.getCount());
+    std::deque<float> window;
+    for (int i = 0; i < 45; i++) {
+        float dbfs = -80.0f + i;
+        percentiles.add(dbfs);
+        window.push_back(dbfs);
+        if (window.size() > 20) {
+            window.pop_front();
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT32(20, percentiles.getCount());
+    for (uint8_t percent : PERCENTS) {
+        TEST_ASSERT_FLOAT_WITHIN(BOUND_DB, sortedLevel(window, percent), percentiles.getLevel(percent));
+    }
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_empty_window);
+    RUN_TEST(test_random_windows);
+    RUN_TEST(test_small_windows_every_value);
+    RUN_TEST(test_duplicates);
+    RUN_TEST(test_out_of_range);
+    RUN_TEST(test_set_window_resets);
+    return UNITY_END();
+}
@@ -0,0 +1,171 @@
+// SpscQueue under a real producer thread and consumer thread: every item
+// arrives once, in order and intact, with both ends spending time at full
+// and at empty.
+//
+//   pio test -e native -f test_spsc_queue
+
+#include <unity.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <atomic>
+#include <thread>
+#include "spsc_queue.h"
+
+namespace {
+
+// Larger than one word, so a copy racing the index update would show up as
+// a payload that does not match its sequence number
+struct Item {
+    uint32_t sequence;
+    uint32_t check;
+    uint32_t payload[6];
+};
+
+uint32_t scramble(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7FEB352Du;
+    x ^= x >> 15;
+    return x;
+}
+
+Item makeItem(uint32_t sequence) {
+    Item item;
+    item.sequence = sequence;
+    item.check = scramble(sequence);
+    for (uint32_t i = 0; i < 6; i++) {
+        item.payload[i] = sequence + i;
+    }
+    return item;
+}
+
+bool isIntact(const Item& item) {
+    if (item.check != scramble(item.sequence)) {
+        return false;
+    }
+    for (uint32_t i = 0; i < 6; i++) {
+        if (item.payload[i] != item.sequence + i) {
+            return false;
+        }
+    }
+    return true;
+}
+
+struct StressResult {
+    uint32_t received;
+    uint32_t outOfOrder;
+    uint32_t corrupted;
+    uint64_t fullRetries;
+    uint64_t emptyRetries;
+};
+
+template <size_t Capacity>
+StressResult runStress(uint32_t count) {
+    static SpscQueue<Item, Capacity> queue;
+    StressResult result = {};
+    std::atomic<uint64_t> fullRetries(0);
+
+    std::thread producer([&] {
+        uint64_t retries = 0;
+        for (uint32_t sequence = 0; sequence < count; sequence++) {
+            Item item = makeItem(sequence);
+            while (!queue.push(item)) {
+                retries++;
+                std::this_thread::yield();
+            }
+        }
+        fullRetries = retries;
+    });
+
+    std::thread consumer([&] {
+        uint32_t expected = 0;
+        Item item;
+        while (expected < count) {
+            if (!queue.pop(item)) {
+                result.emptyRetries++;
+                std::this_thread::yield();
+                continue;
+            }
+            result.received++;
+            result.outOfOrder += item.sequence != expected ? 1 : 0;
+            result.corrupted += isIntact(item) ? 0 : 1;
+            expected = item.sequence + 1;
+        }
+    });
+
+    producer.join();
+    consumer.join();
+    result.fullRetries = fullRetries;
+    return result;
+}
+
+template <size_t Capacity>
+void checkStress(uint32_t count) {
+    StressResult result = runStress<Capacity>(count);
+    char message[160];
+    snprintf(message, sizeof(message), "capacity %zu: %u received, %u out of order, %u corrupted, "
+             "%llu full / %llu empty retries", Capacity, result.received, result.outOfOrder, result.corrupted,
+             static_cast<unsigned long long>(result.fullRetries),
+             static_cast<unsigned long long>(result.emptyRetries));
+    TEST_MESSAGE(message);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(count, result.received, message);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, result.outOfOrder, message);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, result.corrupted, message);
+    // Both ends must have been exercised, or the run proves little
+    TEST_ASSERT_TRUE_MESSAGE(result.fullRetries > 0, message);
+    TEST_ASSERT_TRUE_MESSAGE(result.emptyRetries > 0, message);
+}
+
+} // namespace
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+// Single-threaded edges: full at exactly Capacity, empty after draining,
+// order kept while the free-running indices wrap the ring many times
+void test_full_and_empty_edges() {
+    SpscQueue<Item, 8> queue;
+    Item item;
+    TEST_ASSERT_TRUE(queue.empty());
+    TEST_ASSERT_FALSE(queue.pop(item));
+
+    uint32_t pushed = 0;
+    uint32_t popped = 0;
+    for (int round = 0; round < 100; round++) {
+        size_t fill = 1 + round % queue.capacity();
+        for (size_t i = 0; i < fill; i++) {
+            TEST_ASSERT_TRUE(queue.push(makeItem(pushed++)));
+        }
+        if (fill == queue.capacity()) {
+            TEST_ASSERT_FALSE(queue.push(makeItem(pushed)));  // Full: rejected, not overwritten
+        }
+        TEST_ASSERT_EQUAL_UINT32(fill, queue.size());
+        while (queue.pop(item)) {
+            TEST_ASSERT_EQUAL_UINT32(popped++, item.sequence);
+            TEST_ASSERT_TRUE(isIntact(item));
+        }
+        TEST_ASSERT_TRUE(queue.empty());
+    }
+    TEST_ASSERT_EQUAL_UINT32(pushed, popped);
+}
+
+// A tiny ring, so the producer hits full and the consumer hits empty all
+// the time
+void test_two_threads_small_queue() {
+    checkStress<4>(2000000);
+}
+
+// The sensor's reading queue size
+void test_two_threads_reading_queue_size() {
+    checkStress<32>(4000000);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_full_and_empty_edges);
+    RUN_TEST(test_two_threads_small_queue);
+    RUN_TEST(test_two_threads_reading_queue_size);
+    return UNITY_END();
+}
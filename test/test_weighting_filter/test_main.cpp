@@ -0,0 +1,165 @@
+// WeightingFilter against the IEC 61672-1 A and C curves: sine tones at the
+// standard third-octave frequencies through the fixed-point biquads, gain
+// measured from the output RMS.
+//
+//   pio test -e native -f test_weighting_filter
+
+#include <unity.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "weighting_filter.h"
+
+namespace {
+
+constexpr uint32_t SAMPLE_RATE = 32000;
+constexpr size_t BLOCK = 512;
+constexpr double AMPLITUDE = 1000.0 * (1 << 8);  // 1000 ADC counts with the pipeline's 8-bit headroom
+
+// Nominal frequencies with the class 1 acceptance limits of IEC 61672-1:2013
+// Table 3 (dB, -INFINITY where there is no lower limit)
+struct Tolerance {
+    double hz;
+    double upper;
+    double lower;
+};
+
+const Tolerance CLASS_1[] = {
+    {10, 3.5, -INFINITY}, {12.5, 3.0, -INFINITY}, {16, 2.5, -4.5}, {20, 2.5, -2.5},
+    {25, 2.5, -2.0}, {31.5, 2.0, -2.0}, {40, 1.5, -1.5}, {50, 1.5, -1.5}, {63, 1.5, -1.5},
+    {80, 1.5, -1.5}, {100, 1.5, -1.5}, {125, 1.5, -1.5}, {160, 1.5, -1.5}, {200, 1.5, -1.5},
+    {250, 1.4, -1.4}, {315, 1.4, -1.4}, {400, 1.4, -1.4}, {500, 1.4, -1.4}, {630, 1.4, -1.4},
+    {800, 1.4, -1.4}, {1000, 1.1, -1.1}, {1250, 1.4, -1.4}, {1600, 1.6, -1.6}, {2000, 1.6, -1.6},
+    {2500, 1.6, -1.6}, {3150, 1.6, -1.6}, {4000, 1.6, -1.6}, {5000, 2.1, -2.1}, {6300, 2.1, -2.6},
+    {8000, 2.1, -3.1}, {10000, 2.6, -3.6}, {12500, 3.0, -6.0},
+};
+
+// The header's design claim: within this of the reference up to 8 kHz
+constexpr double DESIGN_BOUND_DB = 0.2;
+constexpr double DESIGN_BOUND_HZ = 8000;
+
+// IEC 61672-1 Annex E, normalized to 0 dB at 1 kHz
+double referenceGainDb(Weighting weighting, double hz) {
+    auto response = [weighting](double f) {
+        const double f1 = 20.598997, f2 = 107.65265, f3 = 737.86223, f4 = 12194.217;
+        double f_2 = f * f;
+        double c = f4 * f4 * f_2 / ((f_2 + f1 * f1) * (f_2 + f4 * f4));
+        if (weighting == Weighting::C) {
+            return 20.0 * log10(c);
+        }
+        return 20.0 * log10(c * f_2 / (sqrt(f_2 + f2 * f2) * sqrt(f_2 + f3 * f3)));
+    };
+    return response(hz) - response(1000.0);
+}
+
+// Gain of the filter for a steady tone, over whole blocks once it settled
+double measureGainDb(Weighting weighting, double hz) {
+    WeightingFilter<SAMPLE_RATE> filter(weighting);
+    const size_t settleBlocks = SAMPLE_RATE / BLOCK;      // 1 s
+    const size_t measureBlocks = 2 * SAMPLE_RATE / BLOCK; // 2 s, 20 periods at 10 Hz
+    std::vector<int32_t> block(BLOCK);
+    double inputSquares = 0;
+    double outputSquares = 0;
+    size_t n = 0;
+    for (size_t b = 0; b < settleBlocks + measureBlocks; b++) {
+        for (size_t i = 0; i < BLOCK; i++, n++) {
+            double x = AMPLITUDE * sin(2.0 * M_PI * hz * n / SAMPLE_RATE);
+            block[i] = static_cast<int32_t>(lround(x));
+            if (b >= settleBlocks) {
+                inputSquares += static_cast<double>(block[i]) * block[i];
+            }
+        }
+        filter.process(block.data(), BLOCK);
+        if (b >= settleBlocks) {
+            for (size_t i = 0; i < BLOCK; i++) {
+                outputSquares += static_cast<double>(block[i]) * block[i];
+            }
+        }
+    }
+    return 10.0 * log10(outputSquares / inputSquares);
+}
+
+void checkCurve(Weighting weighting, const char* name) {
+    double worstDesign = 0;
+    double worstHz = 0;
+    for (const Tolerance& point : CLASS_1) {
+        double measured = measureGainDb(weighting, point.hz);
+        double reference = referenceGainDb(weighting, point.hz);
+        double deviation = measured - reference;
+        char message[128];
+        snprintf(message, sizeof(message), "%s at %g Hz: %.2f dB, reference %.2f dB (limits %+.1f / %+.1f)",
+                 name, point.hz, measured, reference, point.upper, point.lower);
+        TEST_ASSERT_TRUE_MESSAGE(deviation <= point.upper && deviation >= point.lower, message);
+        if (point.hz <= DESIGN_BOUND_HZ && fabs(deviation) > worstDesign) {
+            worstDesign = fabs(deviation);
+            worstHz = point.hz;
+        }
+    }
+    char message[128];
+    snprintf(message, sizeof(message), "%s: worst deviation up to %g Hz is %.3f dB at %g Hz", name,
+             DESIGN_BOUND_HZ, worstDesign, worstHz);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_TRUE_MESSAGE(worstDesign <= DESIGN_BOUND_DB, message);
+}
+
+} // namespace
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+void test_a_weighting_class_1() {
+    checkCurve(Weighting::A, "A");
+}
+
+void test_c_weighting_class_1() {
+    checkCurve(Weighting::C, "C");
+}
+
+void test_z_weighting_is_exact() {
+    WeightingFilter<SAMPLE_RATE> filter(Weighting::Z);
+    int32_t block[BLOCK];
+    for (size_t i = 0; i < BLOCK; i++) {
+        block[i] = static_cast<int32_t>(i * 2654435761u) >> 8;
+    }
+    int32_t copy[BLOCK];
+    memcpy(copy, block, sizeof(block));
+    filter.process(block, BLOCK);
+    TEST_ASSERT_TRUE(memcmp(block, copy, sizeof(block)) == 0);
+}
+
+// Silence stays silent: the error feedback must not leave a limit cycle
+// after a loud tone stops
+void test_returns_to_silence() {
+    const Weighting weightings[] = {Weighting::A, Weighting::C};
+    for (Weighting weighting : weightings) {
+        WeightingFilter<SAMPLE_RATE> filter(weighting);
+        int32_t block[BLOCK];
+        for (size_t i = 0; i < BLOCK; i++) {
+            block[i] = static_cast<int32_t>(lround(2047.0 * 256 * sin(2.0 * M_PI * 50 * i / SAMPLE_RATE)));
+        }
+        filter.process(block, BLOCK);
+        int32_t peak = 0;
+        for (size_t b = 0; b < 4 * SAMPLE_RATE / BLOCK; b++) {
+            memset(block, 0, sizeof(block));
+            filter.process(block, BLOCK);
+            peak = 0;
+            for (size_t i = 0; i < BLOCK; i++) {
+                peak = abs(block[i]) > peak ? abs(block[i]) : peak;
+            }
+        }
+        TEST_ASSERT_TRUE_MESSAGE(peak <= 1, weighting == Weighting::A ? "A" : "C");
+    }
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_a_weighting_class_1);
+    RUN_TEST(test_c_weighting_class_1);
+    RUN_TEST(test_z_weighting_is_exact);
+    RUN_TEST(test_returns_to_silence);
+    return UNITY_END();
+}
@@ -0,0 +1,107 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+// Minimal Arduino API for host builds of the sensor and control code
+// (PlatformIO `native` environment, tools/replay). Time is virtual: it only
+// moves when the host program advances it, so runs are reproducible and
+// independent of how fast the host executes.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <cmath>
+
+using std::max;
+using std::min;
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+inline long map(long x, long inMin, long inMax, long outMin, long outMax) {
+    const long run = inMax - inMin;
+    if (run == 0) {
+        return outMin;
+    }
+    return (x - inMin) * (outMax - outMin) / run + outMin;
+}
+
+namespace host {
+
+inline uint64_t& clockMicros() {
+    static uint64_t micros = 0;
+    return micros;
+}
+
+inline void setMicros(uint64_t micros) {
+    clockMicros() = micros;
+}
+
+inline void advanceMicros(uint64_t micros) {
+    clockMicros() += micros;
+}
+
+// Value source for analogRead(); defaults to the mid-scale bias of a 12-bit ADC
+using AnalogReadHandler = int (*)(uint8_t pin);
+
+inline AnalogReadHandler& analogReadHandler() {
+    static AnalogReadHandler handler = nullptr;
+    return handler;
+}
+
+inline void setAnalogReadHandler(AnalogReadHandler handler) {
+    analogReadHandler() = handler;
+}
+
+} // namespace host
+
+inline unsigned long millis() {
+    return static_cast<unsigned long>(host::clockMicros() / 1000);
+}
+
+inline unsigned long micros() {
+    return static_cast<unsigned long>(host::clockMicros());
+}
+
+inline void delay(unsigned long ms) {
+    host::advanceMicros(static_cast<uint64_t>(ms) * 1000);
+}
+
+inline void yield() {
+}
+
+inline int analogRead(uint8_t pin) {
+    host::AnalogReadHandler handler = host::analogReadHandler();
+    return handler ? handler(pin) : 2048;
+}
+
+inline void analogReadResolution(uint8_t bits) {
+    (void)bits;
+}
+
+// Serial goes to stderr so tools can keep stdout for their own output
+class HostSerial {
+public:
+    void begin(unsigned long baud) {
+        (void)baud;
+    }
+
+    template <typename... Args>
+    int printf(const char* format, Args... args) {
+        return fprintf(stderr, format, args...);
+    }
+
+    size_t print(const char* text) {
+        return fputs(text, stderr) >= 0 ? strlen(text) : 0;
+    }
+
+    size_t println(const char* text = "") {
+        return print(text) + print("\n");
+    }
+};
+
+inline HostSerial Serial;
+
+#endif // HOST_ARDUINO_H
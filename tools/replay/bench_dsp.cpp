@@ -0,0 +1,182 @@
+#include "bench_dsp.h"
+#include <math.h>
+#include <stdio.h>
+#include <chrono>
+#include <functional>
+#include <vector>
+#include "band_analyzer.h"
+#include "decimator.h"
+#include "fixed_fft.h"
+#include "pipeline.h"
+#include "pipeline_stages.h"
+#include "sample_source.h"
+#include "sound_sensor.h"
+#include "weighting_filter.h"
+
+namespace {
+
+using Block = std::vector<int32_t>;
+using AdcBlock = std::vector<uint16_t>;
+
+// ADC-range noise with the pipeline's headroom, as the stages see it
+Block noiseBlock(size_t size) {
+    Block block(size);
+    uint32_t state = 1;
+    for (int32_t& sample : block) {
+        state = state * 1664525u + 1013904223u;
+        sample = (static_cast<int32_t>(state >> 20) - 2048) * (1 << PIPELINE_SIGNAL_SHIFT);
+    }
+    return block;
+}
+
+// Raw ADC samples for the stages that take them
+AdcBlock adcBlock(size_t size) {
+    Block noise = noiseBlock(size);
+    AdcBlock block(size);
+    for (size_t i = 0; i < size; i++) {
+        block[i] = static_cast<uint16_t>(noise[i] / (1 << PIPELINE_SIGNAL_SHIFT) + 2048);
+    }
+    return block;
+}
+
+// A stage runs on pipeline samples or on raw ADC samples, whichever it takes
+struct Stage {
+    const char* name;
+    size_t samplesPerBlock;                   // Input samples one call consumes
+    std::function<void(Block&)> run;          // One block, in place where the stage works in place
+    std::function<void(AdcBlock&)> runAdc;
+};
+
+template <typename Samples, typename Run>
+double timeCalls(const Samples& input, const Run& run, uint32_t blocks) {
+    Samples work(input.size());
+    double total = 0;
+    for (uint32_t i = 0; i < blocks; i++) {
+        work = input;
+        auto start = std::chrono::steady_clock::now();
+        run(work);
+        auto stop = std::chrono::steady_clock::now();
+        total += std::chrono::duration<double, std::nano>(stop - start).count();
+    }
+    return total / blocks;
+}
+
+// Mean time per block; each call gets a fresh copy of the input, outside the timing
+double timeStage(const Stage& stage, uint32_t blocks) {
+    if (stage.runAdc) {
+        return timeCalls(adcBlock(stage.samplesPerBlock), stage.runAdc, blocks);
+    }
+    return timeCalls(noiseBlock(stage.samplesPerBlock), stage.run, blocks);
+}
+
+// Analyzer with its history already full, so every block runs the FFT
+BandAnalyzer& primed(BandAnalyzer& analyzer, BandMode mode) {
+    AdcBlock block = adcBlock(SampleSource::BLOCK_SIZE);
+    analyzer.setMode(mode);
+    for (size_t i = 0; i < BandAnalyzer::FFT_SIZE / block.size(); i++) {
+        analyzer.addBlock(block.data(), block.size(), 2048);
+    }
+    return analyzer;
+}
+
+// One output block through a decimator of the given factor
+template <uint32_t Factor>
+Stage decimatorStage(const char* name) {
+    return Stage{name, SampleSource::BLOCK_SIZE * Factor, nullptr, [](AdcBlock& b) {
+        static CicDecimator<Factor> decimator;
+        decimator.process(b.data(), SampleSource::BLOCK_SIZE);
+    }};
+}
+
+// The original SoundSensor's level on blocks instead of analogRead(): the
+// per-sample min/max loop, then EMA and pow(x, 0.5) once per 3-block window
+class BaselineLevel {
+public:
+    void process(const uint16_t* block) {
+        for (size_t i = 0; i < SampleSource::BLOCK_SIZE; i++) {
+            unsigned int sample = block[i];
+            if (sample < 4095) {
+                if (sample > _signalMax) {
+                    _signalMax = sample;
+                } else if (sample < _signalMin) {
+                    _signalMin = sample;
+                }
+            }
+        }
+        if (++_blocks < 3) {
+            return;
+        }
+        unsigned int peakToPeak = _signalMax - _signalMin;
+        _filteredSignal = 0.2f * peakToPeak + 0.8f * _filteredSignal;
+        _level = pow(_filteredSignal / 4095.0, 0.5);
+        _signalMax = 0;
+        _signalMin = 4095;
+        _blocks = 0;
+    }
+
+private:
+    unsigned int _signalMax = 0;
+    unsigned int _signalMin = 4095;
+    float _filteredSignal = 0;
+    volatile float _level = 0;
+    int _blocks = 0;
+};
+
+BaselineLevel baselineLevel;
+LegacyLevelPipeline legacyPipeline;
+SoundPipeline soundPipeline;
+BandAnalyzer octaveBands;
+BandAnalyzer thirdOctaveBands;
+WeightingFilter<SampleSource::SAMPLE_RATE> weightingA(Weighting::A);
+WeightingFilter<SampleSource::SAMPLE_RATE> weightingC(Weighting::C);
+WeightingFilter<SampleSource::SAMPLE_RATE> weightingZ(Weighting::Z);
+
+const Stage STAGES[] = {
+    {"weighting A", SampleSource::BLOCK_SIZE, [](Block& b) { weightingA.process(b.data(), b.size()); }, nullptr},
+    {"weighting C", SampleSource::BLOCK_SIZE, [](Block& b) { weightingC.process(b.data(), b.size()); }, nullptr},
+    {"weighting Z", SampleSource::BLOCK_SIZE, [](Block& b) { weightingZ.process(b.data(), b.size()); }, nullptr},
+    // One 2048-point transform per block; inputs within the documented +-2^19
+    {"fft 2048 real", BandAnalyzer::FFT_SIZE, [](Block& b) {
+        FixedFft<BandAnalyzer::FFT_SIZE>::forward(b.data());
+    }, nullptr},
+    {"bands octave", SampleSource::BLOCK_SIZE, nullptr, [](AdcBlock& b) {
+        static BandAnalyzer& analyzer = primed(octaveBands, BandMode::OCTAVE);
+        analyzer.addBlock(b.data(), b.size(), 2048);
+    }},
+    {"bands third-octave", SampleSource::BLOCK_SIZE, nullptr, [](AdcBlock& b) {
+        static BandAnalyzer& analyzer = primed(thirdOctaveBands, BandMode::THIRD_OCTAVE);
+        analyzer.addBlock(b.data(), b.size(), 2048);
+    }},
+    // Whole level chains: the original loop, its pipeline form, and every
+    // stage SoundSensor runs per channel (A weighting, bands off)
+    {"baseline p2p level", SampleSource::BLOCK_SIZE, nullptr, [](AdcBlock& b) {
+        baselineLevel.process(b.data());
+    }},
+    {"LegacyLevelPipeline", SampleSource::BLOCK_SIZE, nullptr, [](AdcBlock& b) {
+        legacyPipeline.process(b.data());
+    }},
+    {"SoundPipeline", SampleSource::BLOCK_SIZE, nullptr, [](AdcBlock& b) {
+        soundPipeline.process(b.data());
+    }},
+    // Per sample at the capture rate; the budget is still one output block
+    decimatorStage<2>("decimate 2 (64 kHz)"),
+    decimatorStage<4>("decimate 4 (128 kHz)"),
+    decimatorStage<8>("decimate 8 (256 kHz)"),
+    decimatorStage<16>("decimate 16 (512 kHz)"),
+};
+
+} // namespace
+
+int benchDspStages(uint32_t blocks) {
+    double budget = SampleSource::BLOCK_SIZE * 1e9 / SampleSource::SAMPLE_RATE;
+    fprintf(stderr, "%-22s %10s %12s %10s\n", "stage", "ns/block", "ns/sample", "% budget");
+    for (const Stage& stage : STAGES) {
+        double ns = timeStage(stage, blocks);
+        fprintf(stderr, "%-22s %10.0f %12.2f %9.3f%%\n", stage.name, ns, ns / stage.samplesPerBlock,
+                100.0 * ns / budget);
+    }
+    fprintf(stderr, "Host timings, %u blocks per stage; budget: one %u-sample block at %u Hz (%.0f us)\n",
+            blocks, static_cast<unsigned>(SampleSource::BLOCK_SIZE),
+            static_cast<unsigned>(SampleSource::SAMPLE_RATE), budget / 1000.0);
+    return 0;
+}
@@ -0,0 +1,10 @@
+#ifndef BENCH_DSP_H
+#define BENCH_DSP_H
+
+#include <stdint.h>
+
+// Times the pipeline's per-block DSP stages on full-scale noise, N blocks
+// each, and prints their cost per sample against the real-time budget.
+int benchDspStages(uint32_t blocks);
+
+#endif // BENCH_DSP_H
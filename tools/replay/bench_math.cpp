@@ -0,0 +1,77 @@
+#include "bench_math.h"
+#include <math.h>
+#include <stdio.h>
+#include <chrono>
+#include <vector>
+#include "fast_math.h"
+
+namespace {
+
+// Accuracy against libm is asserted by test/test_fast_math; this only times
+struct Kernel {
+    const char* name;
+    float (*fast)(float);
+    float (*reference)(float);
+};
+
+float referenceLegacySqrt(float x) {
+    return static_cast<float>(pow(x, 0.5)); // What the level mapping used to call
+}
+
+float libLog2(float x) {
+    return log2f(x);
+}
+
+float libSqrt(float x) {
+    return sqrtf(x);
+}
+
+float fastLog2Float(float x) {
+    return fastLog2(x);
+}
+
+const Kernel KERNELS[] = {
+    {"fastLog2", fastLog2Float, libLog2},
+    {"fastSqrt", fastSqrt, referenceLegacySqrt},
+    {"fastSqrt/sqrtf", fastSqrt, libSqrt},
+};
+
+// Geometric over the float range, so every exponent and mantissa position
+// is taken
+float sweepValue(size_t i, size_t count) {
+    double t = static_cast<double>(i) / (count - 1);
+    return static_cast<float>(1e-37 * pow(1e74, t));
+}
+
+template <typename Function>
+double timeCalls(Function function, const std::vector<float>& inputs, uint32_t calls) {
+    volatile float sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < calls; i++) {
+        sink = sink + function(inputs[i % inputs.size()]);
+    }
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(stop - start).count() / calls;
+}
+
+} // namespace
+
+int benchMathKernels(uint32_t calls) {
+    constexpr size_t SWEEP = 1000003;
+    std::vector<float> inputs(4096);
+    for (size_t i = 0; i < inputs.size(); i++) {
+        inputs[i] = sweepValue((i * 2654435761u) % SWEEP, SWEEP);
+    }
+
+    fprintf(stderr, "%-16s %10s %10s %8s\n", "kernel", "fast ns", "libm ns", "speedup");
+    for (const Kernel& kernel : KERNELS) {
+        double fastNs = timeCalls(kernel.fast, inputs, calls);
+        double libmNs = timeCalls(kernel.reference, inputs, calls);
+        fprintf(stderr, "%-16s %10.2f %10.2f %7.1fx\n", kernel.name, fastNs, libmNs, libmNs / fastNs);
+    }
+    // A host FPU has square root and libm is tuned for it; the ESP32 has
+    // neither, so these timings do not carry over to the device
+    fprintf(stderr, "Host timings. libm column: pow(x, 0.5) for fastSqrt, which it replaced in the level\n"
+                    "mappings, and sqrtf for fastSqrt/sqrtf (one instruction here, not on the ESP32)\n");
+    return 0;
+}
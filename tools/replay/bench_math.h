@@ -0,0 +1,10 @@
+#ifndef BENCH_MATH_H
+#define BENCH_MATH_H
+
+#include <stdint.h>
+
+// Times the fast_math.h kernels against the libm calls they replace, over
+// the whole float range. Their error bounds are test/test_fast_math's job.
+int benchMathKernels(uint32_t calls);
+
+#endif // BENCH_MATH_H
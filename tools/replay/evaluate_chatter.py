@@ -0,0 +1,190 @@
+#!/usr/bin/env python3
+"""Evaluate (and optionally refit) the crowd-chatter detector on labelled recordings.
+
+Every recording is run through the replay tool, which executes the firmware's
+SoundSensor, and the per-reading chatter confidence and features are compared
+with the label of the recording.
+
+Recordings are labelled either by directory:
+
+    recordings/chatter/*.wav   people talking (bar crowd, restaurant, ...)
+    recordings/other/*.wav     everything that should not raise the music
+
+or by a CSV file with `path,label` rows (label `chatter` or `other`; relative
+paths are taken from the CSV's directory).
+
+    pio run -e native
+    tools/replay/evaluate_chatter.py --replay .pio/build/native/program recordings/
+    tools/replay/evaluate_chatter.py --replay ... --fit labels.csv
+
+--fit prints logistic weights for ChatterDetector (chatter_detector.h) fitted
+on the same features the firmware computes. Standard library only.
+"""
+
+import argparse
+import csv
+import io
+import math
+import os
+import subprocess
+import sys
+
+FEATURES = ["zcr", "zcr_variation", "flatness", "crest_db", "modulation_db"]
+CONSTANTS = ["WEIGHT_ZCR", "WEIGHT_ZCR_VARIATION", "WEIGHT_FLATNESS", "WEIGHT_CREST", "WEIGHT_MODULATION"]
+LABELS = {"chatter": 1, "other": 0}
+
+
+def find_recordings(source):
+    recordings = []
+    if os.path.isdir(source):
+        for label in LABELS:
+            directory = os.path.join(source, label)
+            if not os.path.isdir(directory):
+                continue
+            for name in sorted(os.listdir(directory)):
+                if name.lower().endswith((".wav", ".pcm", ".raw")):
+                    recordings.append((os.path.join(directory, name), LABELS[label]))
+    else:
+        base = os.path.dirname(os.path.abspath(source))
+        with open(source, newline="") as handle:
+            for row in csv.reader(handle):
+                if not row or row[0].startswith("#") or row[0] == "path":
+                    continue
+                label = row[1].strip().lower()
+                if label not in LABELS:
+                    sys.exit("Unknown label %r for %s" % (row[1], row[0]))
+                recordings.append((os.path.join(base, row[0].strip()), LABELS[label]))
+    if not recordings:
+        sys.exit("No labelled recordings found in " + source)
+    return recordings
+
+
+def replay(binary, path, extra_args):
+    command = [binary] + extra_args
+    if path.lower().endswith((".pcm", ".raw")):
+        command.append("--raw")
+    command.append(path)
+    result = subprocess.run(command, stdout=subprocess.PIPE, stderr=subprocess.PIPE,
+                            universal_newlines=True)
+    if result.returncode != 0:
+        sys.exit("%s failed:\n%s" % (" ".join(command), result.stderr))
+    return list(csv.DictReader(io.StringIO(result.stdout)))
+
+
+def roc_auc(scores, labels):
+    """Probability that a random chatter reading outscores a random other one."""
+    ranked = sorted(zip(scores, labels))
+    positives = sum(labels)
+    negatives = len(labels) - positives
+    if positives == 0 or negatives == 0:
+        return float("nan")
+    rank_sum = 0.0
+    i = 0
+    while i < len(ranked):
+        j = i
+        while j < len(ranked) and ranked[j][0] == ranked[i][0]:
+            j += 1
+        average_rank = (i + j + 1) / 2.0  # 1-based ranks, ties share the mean
+        rank_sum += average_rank * sum(label for _, label in ranked[i:j])
+        i = j
+    return (rank_sum - positives * (positives + 1) / 2.0) / (positives * negatives)
+
+
+def fit_logistic(rows, labels, iterations, l2):
+    """Batch gradient descent on standardized features; returns raw-scale weights."""
+    count = len(rows)
+    dims = len(FEATURES)
+    means = [sum(row[d] for row in rows) / count for d in range(dims)]
+    scales = [math.sqrt(sum((row[d] - means[d]) ** 2 for row in rows) / count) or 1.0 for d in range(dims)]
+    data = [[(row[d] - means[d]) / scales[d] for d in range(dims)] for row in rows]
+
+    # Classes are balanced by weight so long recordings do not dominate
+    positives = sum(labels)
+    weight_positive = count / (2.0 * max(positives, 1))
+    weight_negative = count / (2.0 * max(count - positives, 1))
+
+    weights = [0.0] * dims
+    bias = 0.0
+    rate = 0.5
+    for _ in range(iterations):
+        gradient = [0.0] * dims
+        gradient_bias = 0.0
+        for x, y in zip(data, labels):
+            z = bias + sum(w * v for w, v in zip(weights, x))
+            p = 1.0 / (1.0 + math.exp(-max(-30.0, min(30.0, z))))
+            error = (p - y) * (weight_positive if y else weight_negative)
+            gradient_bias += error
+            for d in range(dims):
+                gradient[d] += error * x[d]
+        bias -= rate * gradient_bias / count
+        for d in range(dims):
+            weights[d] -= rate * (gradient[d] / count + l2 * weights[d])
+
+    raw_weights = [weights[d] / scales[d] for d in range(dims)]
+    raw_bias = bias - sum(raw_weights[d] * means[d] for d in range(dims))
+    return raw_bias, raw_weights
+
+
+def confidence(bias, weights, row):
+    z = bias + sum(w * v for w, v in zip(weights, row))
+    return 1.0 / (1.0 + math.exp(-max(-30.0, min(30.0, z))))
+
+
+def report(name, scores, labels, threshold):
+    predicted = [score >= threshold for score in scores]
+    true_positive = sum(1 for p, y in zip(predicted, labels) if p and y)
+    false_positive = sum(1 for p, y in zip(predicted, labels) if p and not y)
+    false_negative = sum(1 for p, y in zip(predicted, labels) if not p and y)
+    true_negative = len(labels) - true_positive - false_positive - false_negative
+    accuracy = (true_positive + true_negative) / float(len(labels))
+    precision = true_positive / float(true_positive + false_positive) if true_positive + false_positive else 0.0
+    recall = true_positive / float(true_positive + false_negative) if true_positive + false_negative else 0.0
+    print("%s: %d readings, accuracy %.3f, precision %.3f, recall %.3f, ROC AUC %.3f"
+          % (name, len(labels), accuracy, precision, recall, roc_auc(scores, labels)))
+    print("  confusion (rows: actual chatter / other): [%d %d] / [%d %d]"
+          % (true_positive, false_negative, false_positive, true_negative))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("source", help="directory with chatter/ and other/, or a path,label CSV")
+    parser.add_argument("--replay", default=".pio/build/native/program", help="replay tool binary")
+    parser.add_argument("--warmup", type=float, default=5.0, help="seconds skipped at the start of each file")
+    parser.add_argument("--threshold", type=float, default=0.5, help="confidence counted as chatter")
+    parser.add_argument("--fit", action="store_true", help="fit and print new detector weights")
+    parser.add_argument("--iterations", type=int, default=500)
+    parser.add_argument("--l2", type=float, default=1e-2)
+    parser.add_argument("--replay-args", default="", help="extra options for the replay tool")
+    args = parser.parse_args()
+
+    recordings = find_recordings(args.source)
+    scores, labels, features = [], [], []
+    print("%-40s %-8s %10s %10s" % ("recording", "label", "mean conf", "above thr"))
+    for path, label in recordings:
+        rows = [row for row in replay(args.replay, path, args.replay_args.split())
+                if float(row["time_ms"]) >= args.warmup * 1000.0]
+        if not rows:
+            print("%-40s skipped (shorter than warm-up)" % os.path.basename(path))
+            continue
+        file_scores = [float(row["chatter"]) for row in rows]
+        scores += file_scores
+        labels += [label] * len(rows)
+        features += [[float(row[name]) for name in FEATURES] for row in rows]
+        print("%-40s %-8s %10.3f %10.3f" % (os.path.basename(path), "chatter" if label else "other",
+                                           sum(file_scores) / len(file_scores),
+                                           sum(s >= args.threshold for s in file_scores) / float(len(file_scores))))
+
+    report("Firmware weights", scores, labels, args.threshold)
+
+    if args.fit:
+        step = max(1, len(features) // 5000)  # Bound the pure-Python fitting time
+        bias, weights = fit_logistic(features[::step], labels[::step], args.iterations, args.l2)
+        fitted = [confidence(bias, weights, row) for row in features]
+        report("Fitted weights (in-sample)", fitted, labels, args.threshold)
+        print("\n    static constexpr float BIAS = %.3ff;" % bias)
+        for constant, weight in zip(CONSTANTS, weights):
+            print("    static constexpr float %s = %.3ff;" % (constant, weight))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,504 @@
+// Replays a recording through the firmware's SoundSensor and VolumeController
+// on the host and writes one CSV row per reading, with the volume decisions
+// the device would have taken. Also times every SoundSensor::process() call.
+//
+//   replay [options] recording.wav > levels.csv
+//   replay --bench-chatter 100000
+//   replay --bench-math 10000000
+//   replay --bench-dsp 10000
+//
+// Built by `pio run -e native` (see platformio.ini for the sources involved).
+
+#include <Arduino.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "sound_sensor.h"
+#include "volume_controller.h"
+#include "volume_scheduler.h"
+#include "venue_calibration.h"
+#include "pcm_file_source.h"
+#include "bench_math.h"
+#include "bench_dsp.h"
+
+// `pio test -e native` links the same sources with each test's own main()
+#ifndef PIO_UNIT_TESTING
+
+constexpr uint32_t MIN_DECISION_SPACING = 1000; // SOUND_CHECK_INTERVAL in main.cpp
+
+struct ReplayOptions {
+    std::string input;
+    std::string output;
+    std::string timingOutput;
+    uint32_t chatterBenchBlocks = 0;
+    uint32_t mathBenchCalls = 0;
+    uint32_t dspBenchBlocks = 0;
+    bool raw = false;
+    uint32_t rawRate = SampleSource::CAPTURE_RATE;
+    uint16_t rawChannels = 1;
+    float gain = 1.0f;
+    LevelMode levelMode = LevelMode::PEAK_TO_PEAK;
+    Weighting weighting = Weighting::A;
+    BandMode bandMode = BandMode::OFF;
+    int sensitivity = 50;
+    float chatterGate = VolumeController::DEFAULT_CHATTER_GATE;
+    bool noiseFloor = true;
+    ChannelAggregation aggregation = ChannelAggregation::MEAN;
+    std::vector<float> channelWeights;
+    size_t transientWindow = HampelFilter::DEFAULT_WINDOW;
+    float transientThreshold = HampelFilter::DEFAULT_THRESHOLD;
+    int startVolume = 8;
+    uint32_t decisionInterval = 0; // 0: paced by the controller, as on the device
+    ServoSettings servo = VolumeServo::DEFAULT_SETTINGS;
+    uint32_t minDwellMs = VolumeScheduler::DEFAULT_MIN_DWELL_MS;
+    // Venue calibration captures, seconds into the recording; negative: none
+    float calibrateQuietAt = -1;
+    float calibrateBusyAt = -1;
+    uint16_t calibrateSeconds = VenueCalibration::DEFAULT_SECONDS;
+    uint16_t adaptiveSeconds = 0;
+};
+
+static void printUsage(const char* program) {
+    fprintf(stderr,
+            "Usage: %s [options] <recording.wav | recording.pcm>\n"
+            "  -o FILE               CSV output (default: stdout)\n"
+            "  --raw                 Headerless signed 16-bit little-endian PCM\n"
+            "  --rate HZ             Sample rate of raw input (default %u)\n"
+            "  --channels N          Channels of raw input (default 1)\n"
+            "  --gain G              Scale before ADC conversion (default 1: file full scale = ADC range)\n"
+            "  --mode peak|leq|speech  Level mode (default peak)\n"
+            "  --weighting A|C|Z     Leq weighting (default A)\n"
+            "  --bands off|octave|third  Band analysis (default off)\n"
+            "  --sensitivity N       0-100 (default 50)\n"
+            "  --aggregation mean|max|weighted  Combining of microphones in a\n"
+            "                        SOUND_CHANNEL_COUNT build (default mean)\n"
+            "  --weights W0,W1,...   Zone weight per microphone (default 1 each)\n"
+            "  --noise-floor on|off  Drive the volume by the level above the noise floor (default on)\n"
+            "  --chatter-gate C      Min chatter confidence to raise the volume, 0 = off (default 0.5)\n"
+            "  --transient-window N  Hampel window in 50 ms windows, odd 3-31 or 0 = off (default 9)\n"
+            "  --transient-threshold K  Hampel threshold in sigmas, 1-10 (default 3)\n"
+            "  --volume N            Player volume at start (default 8)\n"
+            "  --servo KP,KI,KD      Volume servo gains (default 0.5,0.02,0)\n"
+            "  --deadband D,H[,S]    Servo deadband and hysteresis in volume steps, slew in\n"
+            "                        steps per second (default 0.6,0.6,0.6)\n"
+            "  --dwell MS            Minimum time between volume commands (default 10000)\n"
+            "  --interval MS         Fixed time between decisions instead of\n"
+            "                        change-point pacing (default 0 = paced)\n"
+            "  --calibrate Q,B[,S]   Measure the quiet room from Q s and the busy room from\n"
+            "                        B s into the recording, S s each (default 120), then\n"
+            "                        use the fitted mapping instead of the sensitivity\n"
+            "  --adaptive S          Sample one window per second after S s of stable level\n"
+            "                        (10-3600, default 0 = continuous)\n"
+            "  --timing FILE         Per-block processing time CSV\n"
+            "  --bench-chatter N     Time ChatterDetector on N worst-case blocks instead of replaying\n"
+            "  --bench-math N        Time N calls per fast_math.h kernel against libm\n"
+            "  --bench-dsp N         Time the DSP stages on N blocks each\n",
+            program, static_cast<unsigned>(SampleSource::CAPTURE_RATE));
+}
+
+static bool parseOptions(int argc, char** argv, ReplayOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        std::string value = hasValue ? argv[i + 1] : "";
+
+        if (arg == "--raw") {
+            options.raw = true;
+            continue;
+        }
+        if (arg.size() > 1 && arg[0] == '-') {
+            if (!hasValue) {
+                fprintf(stderr, "Missing value for %s\n", arg.c_str());
+                return false;
+            }
+            i++;
+        }
+
+        if (arg == "-o") {
+            options.output = value;
+        } else if (arg == "--bench-chatter") {
+            options.chatterBenchBlocks = static_cast<uint32_t>(atol(value.c_str()));
+        } else if (arg == "--bench-math") {
+            options.mathBenchCalls = static_cast<uint32_t>(atol(value.c_str()));
+        } else if (arg == "--bench-dsp") {
+            options.dspBenchBlocks = static_cast<uint32_t>(atol(value.c_str()));
+        } else if (arg == "--timing") {
+            options.timingOutput = value;
+        } else if (arg == "--rate") {
+            options.rawRate = static_cast<uint32_t>(atol(value.c_str()));
+        } else if (arg == "--channels") {
+            options.rawChannels = static_cast<uint16_t>(atoi(value.c_str()));
+        } else if (arg == "--gain") {
+            options.gain = static_cast<float>(atof(value.c_str()));
+        } else if (arg == "--mode") {
+            if (value == "peak") options.levelMode = LevelMode::PEAK_TO_PEAK;
+            else if (value == "leq") options.levelMode = LevelMode::LEQ;
+            else if (value == "speech") options.levelMode = LevelMode::SPEECH;
+            else return false;
+        } else if (arg == "--weighting") {
+            if (value == "A") options.weighting = Weighting::A;
+            else if (value == "C") options.weighting = Weighting::C;
+            else if (value == "Z") options.weighting = Weighting::Z;
+            else return false;
+        } else if (arg == "--bands") {
+            if (value == "off") options.bandMode = BandMode::OFF;
+            else if (value == "octave") options.bandMode = BandMode::OCTAVE;
+            else if (value == "third") options.bandMode = BandMode::THIRD_OCTAVE;
+            else return false;
+        } else if (arg == "--aggregation") {
+            if (value == "mean") options.aggregation = ChannelAggregation::MEAN;
+            else if (value == "max") options.aggregation = ChannelAggregation::MAX;
+            else if (value == "weighted") options.aggregation = ChannelAggregation::WEIGHTED;
+            else return false;
+        } else if (arg == "--weights") {
+            options.channelWeights.clear();
+            for (size_t start = 0; start <= value.size();) {
+                size_t comma = value.find(',', start);
+                options.channelWeights.push_back(static_cast<float>(
+                    atof(value.substr(start, comma - start).c_str())));
+                start = comma == std::string::npos ? value.size() + 1 : comma + 1;
+            }
+        } else if (arg == "--noise-floor") {
+            if (value == "on") options.noiseFloor = true;
+            else if (value == "off") options.noiseFloor = false;
+            else return false;
+        } else if (arg == "--chatter-gate") {
+            options.chatterGate = static_cast<float>(atof(value.c_str()));
+        } else if (arg == "--transient-window") {
+            options.transientWindow = static_cast<size_t>(atoi(value.c_str()));
+        } else if (arg == "--transient-threshold") {
+            options.transientThreshold = static_cast<float>(atof(value.c_str()));
+        } else if (arg == "--sensitivity") {
+            options.sensitivity = atoi(value.c_str());
+        } else if (arg == "--volume") {
+            options.startVolume = constrain(atoi(value.c_str()), VolumeController::MIN_VOLUME,
+                                            VolumeController::MAX_VOLUME);
+        } else if (arg == "--calibrate") {
+            unsigned seconds = VenueCalibration::DEFAULT_SECONDS;
+            if (sscanf(value.c_str(), "%f,%f,%u", &options.calibrateQuietAt, &options.calibrateBusyAt,
+                       &seconds) < 2) {
+                return false;
+            }
+            options.calibrateSeconds = static_cast<uint16_t>(seconds);
+        } else if (arg == "--adaptive") {
+            options.adaptiveSeconds = static_cast<uint16_t>(atoi(value.c_str()));
+        } else if (arg == "--servo") {
+            if (sscanf(value.c_str(), "%f,%f,%f", &options.servo.kp, &options.servo.ki,
+                       &options.servo.kd) < 2) {
+                return false;
+            }
+        } else if (arg == "--deadband") {
+            if (sscanf(value.c_str(), "%f,%f,%f", &options.servo.deadband, &options.servo.hysteresis,
+                       &options.servo.maxSlew) < 2) {
+                return false;
+            }
+        } else if (arg == "--dwell") {
+            options.minDwellMs = static_cast<uint32_t>(atol(value.c_str()));
+        } else if (arg == "--interval") {
+            options.decisionInterval = static_cast<uint32_t>(atol(value.c_str()));
+        } else if (arg[0] == '-') {
+            fprintf(stderr, "Unknown option %s\n", arg.c_str());
+            return false;
+        } else {
+            options.input = arg;
+        }
+    }
+    return !options.input.empty() || options.chatterBenchBlocks > 0 || options.mathBenchCalls > 0 ||
+           options.dspBenchBlocks > 0;
+}
+
+// The detector's cost does not depend on the content of an audible block
+// (silent ones return early), so full-scale noise is the worst case
+static int benchChatterDetector(uint32_t blocks) {
+    std::vector<int32_t> signal(SampleSource::BLOCK_SIZE);
+    uint32_t state = 1;
+    for (int32_t& sample : signal) {
+        state = state * 1664525u + 1013904223u;
+        sample = (static_cast<int32_t>(state >> 20) - 2048) * (1 << PIPELINE_SIGNAL_SHIFT);
+    }
+
+    ChatterDetector detector;
+    std::vector<double> blockMicros;
+    blockMicros.reserve(blocks);
+    for (uint32_t i = 0; i < blocks; i++) {
+        auto start = std::chrono::steady_clock::now();
+        detector.addBlock(signal.data(), signal.size(), PIPELINE_SIGNAL_SHIFT);
+        auto stop = std::chrono::steady_clock::now();
+        blockMicros.push_back(std::chrono::duration<double, std::micro>(stop - start).count());
+    }
+
+    std::sort(blockMicros.begin(), blockMicros.end());
+    double total = 0;
+    for (double micros : blockMicros) {
+        total += micros;
+    }
+    double mean = total / blocks;
+    double budget = SampleSource::BLOCK_SIZE * 1e6 / SampleSource::SAMPLE_RATE;
+    fprintf(stderr, "ChatterDetector, %u blocks of %u samples (confidence %.3f)\n", blocks,
+            static_cast<unsigned>(SampleSource::BLOCK_SIZE), detector.getConfidence());
+    fprintf(stderr, "Block time (us): mean %.2f, p50 %.2f, p99 %.2f, max %.2f (%.1f ns/sample, %.3f%% of %.0f us)\n",
+            mean, blockMicros[blocks / 2], blockMicros[blocks * 99 / 100], blockMicros.back(),
+            1000.0 * mean / SampleSource::BLOCK_SIZE, 100.0 * mean / budget, budget);
+    return 0;
+}
+
+static void writeHeader(FILE* csv, const SoundSensor& sensor) {
+    fprintf(csv, "time_ms,sequence,level,noise_floor");
+    if (SampleSource::CHANNELS > 1) {
+        for (size_t c = 0; c < SampleSource::CHANNELS; c++) {
+            fprintf(csv, ",level_ch%u", static_cast<unsigned>(c));
+        }
+    }
+    for (size_t i = 0; i < LeqMeter::WINDOW_COUNT; i++) {
+        fprintf(csv, ",leq_%us_dbfs", sensor.getLeqWindow(i));
+    }
+    for (size_t i = 0; i < SoundReading::PERCENTILE_COUNT; i++) {
+        fprintf(csv, ",l%u_dbfs", sensor.getPercentile(i));
+    }
+    fprintf(csv, ",clipped_samples,faults");
+    fprintf(csv, ",chatter,zcr,zcr_variation,flatness,crest_db,modulation_db,low_duty");
+    fprintf(csv, ",ambient_level,target_volume,volume,volume_changed\n");
+}
+
+// Decision columns are filled on the reading a decision was taken on; volume
+// is the player volume after it
+static void writeRow(FILE* csv, const SoundReading& reading, const VolumeDecision* decision,
+                     int volume, bool changed) {
+    fprintf(csv, "%u,%u,%.4f,%.4f", reading.timestamp, reading.sequence, reading.level, reading.noiseFloor);
+    if (SampleSource::CHANNELS > 1) {
+        for (size_t c = 0; c < SampleSource::CHANNELS; c++) {
+            fprintf(csv, ",%.4f", reading.channelLevels[c]);
+        }
+    }
+    for (size_t i = 0; i < LeqMeter::WINDOW_COUNT; i++) {
+        fprintf(csv, ",%.2f", reading.leqDbfs[i]);
+    }
+    for (size_t i = 0; i < SoundReading::PERCENTILE_COUNT; i++) {
+        fprintf(csv, ",%.2f", reading.percentileDbfs[i]);
+    }
+    fprintf(csv, ",%u,%u", reading.health.clippedSamples, reading.health.faults);
+    const ChatterFeatures& chatter = reading.chatter;
+    fprintf(csv, ",%.3f,%.4f,%.3f,%.3f,%.2f,%.2f", reading.chatterConfidence, chatter.zeroCrossingRate,
+            chatter.zcrVariation, chatter.flatness, chatter.crestFactorDb, chatter.modulationDb);
+    fprintf(csv, ",%d", reading.sampling.lowDuty ? 1 : 0);
+    if (decision) {
+        fprintf(csv, ",%.4f,%d,%d,%d\n", decision->ambientLevel, decision->targetVolume, volume,
+                changed ? 1 : 0);
+    } else {
+        fprintf(csv, ",,,%d,\n", volume);
+    }
+}
+
+int main(int argc, char** argv) {
+    ReplayOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 2;
+    }
+    if (options.chatterBenchBlocks > 0) {
+        return benchChatterDetector(options.chatterBenchBlocks);
+    }
+    if (options.mathBenchCalls > 0) {
+        return benchMathKernels(options.mathBenchCalls);
+    }
+    if (options.dspBenchBlocks > 0) {
+        return benchDspStages(options.dspBenchBlocks);
+    }
+
+    PcmFileSource source(options.input, options.raw, options.rawRate, options.rawChannels);
+    source.setGain(options.gain);
+    SoundSensor sensor(source);
+    sensor.setLevelMode(options.levelMode);
+    sensor.setWeighting(options.weighting);
+    sensor.setBandMode(options.bandMode);
+    sensor.setChannelAggregation(options.aggregation);
+    if (!options.channelWeights.empty()) {
+        bool valid = options.channelWeights.size() == SampleSource::CHANNELS;
+        for (size_t c = 0; valid && c < SampleSource::CHANNELS; c++) {
+            valid = sensor.setChannelWeight(c, options.channelWeights[c]);
+        }
+        if (!valid) {
+            fprintf(stderr, "Expected %u channel weights, 0-%.0f each\n",
+                    static_cast<unsigned>(SampleSource::CHANNELS), SoundSensor::MAX_CHANNEL_WEIGHT);
+            return 2;
+        }
+    }
+    if (!sensor.setTransientFilter(options.transientWindow, options.transientThreshold)) {
+        fprintf(stderr, "Invalid transient filter settings\n");
+        return 2;
+    }
+    if (!sensor.setAdaptiveSampling(options.adaptiveSeconds)) {
+        fprintf(stderr, "Invalid adaptive sampling stable time\n");
+        return 2;
+    }
+    if (!sensor.begin()) {
+        fprintf(stderr, "%s\n", source.getError().c_str());
+        return 1;
+    }
+
+    VolumeController controller;
+    controller.setSensitivity(options.sensitivity);
+    controller.setChatterGate(options.chatterGate);
+    if (!controller.setServoSettings(options.servo)) {
+        fprintf(stderr, "Invalid servo settings\n");
+        return 2;
+    }
+    VolumeScheduler scheduler;
+    if (!scheduler.setMinDwell(options.minDwellMs)) {
+        fprintf(stderr, "Invalid minimum dwell\n");
+        return 2;
+    }
+    VenueCalibration calibration;
+    bool calibrateQuiet = options.calibrateQuietAt >= 0;
+    bool calibrateBusy = options.calibrateBusyAt >= 0;
+
+    FILE* csv = options.output.empty() ? stdout : fopen(options.output.c_str(), "w");
+    FILE* timing = options.timingOutput.empty() ? nullptr : fopen(options.timingOutput.c_str(), "w");
+    if (!csv || (!options.timingOutput.empty() && !timing)) {
+        fprintf(stderr, "Cannot open output file\n");
+        return 1;
+    }
+    if (timing) {
+        fprintf(timing, "block,time_us\n");
+    }
+    writeHeader(csv, sensor);
+
+    int volume = options.startVolume;
+    controller.setAdaptivePacing(options.decisionInterval == 0);
+    unsigned long lastDecision = 0;
+    uint32_t decisions = 0;
+    uint32_t surges = 0;
+    uint32_t volumeChanges = 0;
+    uint32_t gatedDecisions = 0;
+    std::vector<double> blockMicros;
+    std::vector<SoundReading> readings;
+
+    for (;;) {
+        double readMicros = source.getReadMicros();
+        auto start = std::chrono::steady_clock::now();
+        bool processed = sensor.process(0);
+        auto stop = std::chrono::steady_clock::now();
+        if (!processed) {
+            break;
+        }
+        // DSP time only: decoding and resampling the file is not firmware work
+        double elapsed = std::chrono::duration<double, std::micro>(stop - start).count() -
+                         (source.getReadMicros() - readMicros);
+        if (timing) {
+            fprintf(timing, "%zu,%.3f\n", blockMicros.size(), elapsed);
+        }
+        blockMicros.push_back(elapsed);
+
+        // Portal calibration requests at their times in the recording
+        bool* const pending[] = {&calibrateQuiet, &calibrateBusy};
+        const float starts[] = {options.calibrateQuietAt, options.calibrateBusyAt};
+        for (size_t i = 0; i < 2; i++) {
+            if (*pending[i] && millis() >= starts[i] * 1000) {
+                *pending[i] = false;
+                if (!calibration.start(i == 0 ? CalibrationPhase::QUIET : CalibrationPhase::BUSY,
+                                       options.calibrateSeconds)) {
+                    fprintf(stderr, "Invalid calibration duration\n");
+                    return 2;
+                }
+            }
+        }
+
+        // handleSoundReadings(): drain everything and feed the controller
+        readings.clear();
+        SoundReading reading;
+        while (sensor.poll(reading)) {
+            controller.addReading(reading.level, reading.chatterConfidence, reading.timestamp);
+            float ambientLevel = controller.feedback().compensate(
+                reading.level, volume, options.noiseFloor ? reading.noiseFloor : 0);
+            if (calibration.addReading(ambientLevel, reading.timestamp)) {
+                VolumeMapping mapping;
+                fprintf(stderr, "Calibration at %.1f s: quiet room %.3f, busy room %.3f\n",
+                        reading.timestamp / 1000.0, calibration.getQuietLevel(), calibration.getBusyLevel());
+                if (calibration.fit(VenueCalibration::DEFAULT_QUIET_VOLUME, VenueCalibration::DEFAULT_BUSY_VOLUME,
+                                    mapping) && controller.setMapping(mapping)) {
+                    fprintf(stderr, "Mapping: level %.3f -> volume %d, level %.3f -> volume %d\n",
+                            mapping.quietLevel, mapping.quietVolume, mapping.busyLevel, mapping.busyVolume);
+                }
+            }
+            readings.push_back(reading);
+        }
+        if (readings.empty()) {
+            continue;
+        }
+
+        // processSound() on the loop's cadence and sendScheduledVolume(),
+        // with a player that accepts every command
+        VolumeDecision decision;
+        bool changed = false;
+        bool decided = options.decisionInterval > 0
+            ? millis() - lastDecision >= options.decisionInterval
+            : millis() - lastDecision >= MIN_DECISION_SPACING && controller.isDecisionDue(millis());
+        if (decided) {
+            lastDecision = millis();
+            decisions++;
+            const SoundReading& latest = sensor.getLatestReading();
+            decision = controller.decide(latest.level, options.noiseFloor ? latest.noiseFloor : 0, volume,
+                                         millis());
+            gatedDecisions += decision.gated ? 1 : 0;
+            surges += decision.surge ? 1 : 0;
+            scheduler.request(decision.newVolume, volume, decision.surge);
+        }
+        int newVolume;
+        if (scheduler.isCommandDue(millis(), newVolume)) {
+            scheduler.onCommandSent(newVolume, true, millis());
+            controller.onVolumeCommanded(volume, newVolume, millis());
+            volume = newVolume;
+            volumeChanges++;
+            changed = true;
+        }
+        for (size_t i = 0; i < readings.size(); i++) {
+            bool last = i + 1 == readings.size();
+            writeRow(csv, readings[i], decided && last ? &decision : nullptr, volume, changed);
+        }
+    }
+
+    if (csv != stdout) {
+        fclose(csv);
+    }
+    if (timing) {
+        fclose(timing);
+    }
+
+    // Processing time per block against the real-time budget
+    if (blockMicros.empty()) {
+        fprintf(stderr, "No complete block in %s\n", options.input.c_str());
+        return 1;
+    }
+    double total = 0;
+    for (double micros : blockMicros) {
+        total += micros;
+    }
+    std::vector<double> sorted = blockMicros;
+    std::sort(sorted.begin(), sorted.end());
+    double mean = total / sorted.size();
+    double budget = SampleSource::CAPTURE_BLOCK_SIZE * 1e6 / SampleSource::CAPTURE_RATE;
+    fprintf(stderr, "%s: %u Hz, %u ch -> %u Hz capture, %zu blocks (%.1f s), %u readings\n",
+            options.input.c_str(), source.getFileRate(), source.getFileChannels(),
+            static_cast<unsigned>(SampleSource::CAPTURE_RATE), sorted.size(), millis() / 1000.0,
+            sensor.getLatestReading().sequence + 1);
+    fprintf(stderr, "Noise floor: %.4f (level %.4f at end)\n", sensor.getLatestReading().noiseFloor,
+            sensor.getLatestReading().level);
+    fprintf(stderr, "Decisions: %u (%u woken by %u level changes)\n", decisions, surges,
+            controller.getChangeCount());
+    fprintf(stderr, "Volume: %d -> %d, %u changes, %u increases held (not chatter), %u transients rejected\n",
+            options.startVolume, volume, volumeChanges, gatedDecisions,
+            sensor.getLatestReading().transientsRejected);
+    const SchedulerCounters& commands = scheduler.getCounters();
+    fprintf(stderr, "Commands: %u issued (%u urgent), %u coalesced, %u suppressed\n", commands.issued,
+            commands.urgent, commands.coalesced, commands.suppressed);
+    const SamplingStats& sampling = sensor.getLatestReading().sampling;
+    fprintf(stderr, "Sampling: ADC active %.1f%%, DSP %.1f%% of blocks, %.1f mA proxy, %u wakes%s\n",
+            sampling.activePercent, sampling.processedPercent, sampling.currentMa, sampling.wakeCount,
+            sampling.lowDuty ? " (low duty at end)" : "");
+    fprintf(stderr, "Block time (us): mean %.1f, p50 %.1f, p99 %.1f, max %.1f (budget %.0f, %.2f%% load)\n",
+            mean, sorted[sorted.size() / 2], sorted[sorted.size() * 99 / 100], sorted.back(),
+            budget, 100.0 * mean / budget);
+    return 0;
+}
+#endif // PIO_UNIT_TESTING
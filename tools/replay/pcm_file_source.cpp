@@ -0,0 +1,244 @@
+#include "pcm_file_source.h"
+#include <Arduino.h>
+#include <chrono>
+
+static uint32_t readLe32(const uint8_t* bytes) {
+    return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (static_cast<uint32_t>(bytes[3]) << 24);
+}
+
+static uint16_t readLe16(const uint8_t* bytes) {
+    return static_cast<uint16_t>(bytes[0] | (bytes[1] << 8));
+}
+
+PcmFileSource::PcmFileSource(const std::string& path, bool raw, uint32_t rawRate, uint16_t rawChannels)
+    : _path(path)
+    , _raw(raw)
+    , _file(nullptr)
+    , _format(Format::PCM_S16)
+    , _rate(rawRate)
+    , _channels(rawChannels)
+    , _bytesPerSample(2)
+    , _dataRemaining(UINT64_MAX)
+    , _gain(1.0f)
+    , _finished(false)
+    , _readMicros(0)
+    , _step(1.0)
+    , _position(0)
+    , _previous()
+    , _next()
+    , _primed(false) {
+}
+
+PcmFileSource::~PcmFileSource() {
+    end();
+}
+
+bool PcmFileSource::begin() {
+    _file = fopen(_path.c_str(), "rb");
+    if (!_file) {
+        _error = "cannot open " + _path;
+        return false;
+    }
+    if (!_raw && !parseWavHeader()) {
+        end();
+        return false;
+    }
+    if (_rate == 0 || _channels == 0) {
+        _error = "invalid sample rate or channel count";
+        end();
+        return false;
+    }
+    _frame.resize(static_cast<size_t>(_bytesPerSample) * _channels);
+    _step = static_cast<double>(_rate) / CAPTURE_RATE;
+    _finished = false;
+    _primed = false;
+    return true;
+}
+
+void PcmFileSource::end() {
+    if (_file) {
+        fclose(_file);
+        _file = nullptr;
+    }
+}
+
+bool PcmFileSource::parseWavHeader() {
+    uint8_t header[12];
+    if (fread(header, 1, sizeof(header), _file) != sizeof(header) ||
+        memcmp(header, "RIFF", 4) != 0 || memcmp(header + 8, "WAVE", 4) != 0) {
+        _error = "not a RIFF/WAVE file";
+        return false;
+    }
+
+    bool haveFormat = false;
+    uint8_t chunk[8];
+    while (fread(chunk, 1, sizeof(chunk), _file) == sizeof(chunk)) {
+        uint32_t size = readLe32(chunk + 4);
+        if (memcmp(chunk, "fmt ", 4) == 0) {
+            uint8_t fmt[40] = {};
+            size_t length = size < sizeof(fmt) ? size : sizeof(fmt);
+            if (size < 16 || fread(fmt, 1, length, _file) != length) {
+                _error = "truncated fmt chunk";
+                return false;
+            }
+            fseek(_file, static_cast<long>(size - length + (size & 1)), SEEK_CUR);
+
+            uint16_t tag = readLe16(fmt);
+            _channels = readLe16(fmt + 2);
+            _rate = readLe32(fmt + 4);
+            uint16_t bits = readLe16(fmt + 14);
+            if (tag == 0xFFFE && size >= 26) {
+                tag = readLe16(fmt + 24); // WAVE_FORMAT_EXTENSIBLE: sub-format GUID
+            }
+            _bytesPerSample = static_cast<uint16_t>((bits + 7) / 8);
+            if (tag == 1 && bits == 8) {
+                _format = Format::PCM_U8;
+            } else if (tag == 1 && bits == 16) {
+                _format = Format::PCM_S16;
+            } else if (tag == 1 && bits == 24) {
+                _format = Format::PCM_S24;
+            } else if (tag == 1 && bits == 32) {
+                _format = Format::PCM_S32;
+            } else if (tag == 3 && bits == 32) {
+                _format = Format::FLOAT32;
+            } else {
+                _error = "unsupported WAV encoding (format " + std::to_string(tag) +
+                         ", " + std::to_string(bits) + " bits)";
+                return false;
+            }
+            haveFormat = true;
+        } else if (memcmp(chunk, "data", 4) == 0) {
+            if (!haveFormat) {
+                _error = "data chunk before fmt chunk";
+                return false;
+            }
+            _dataRemaining = size;
+            return true;
+        } else {
+            fseek(_file, static_cast<long>(size + (size & 1)), SEEK_CUR);
+        }
+    }
+    _error = "no data chunk";
+    return false;
+}
+
+bool PcmFileSource::readFrame(float* values) {
+    if (_dataRemaining < _frame.size() ||
+        fread(_frame.data(), 1, _frame.size(), _file) != _frame.size()) {
+        return false;
+    }
+    _dataRemaining -= _frame.size();
+
+    bool separate = _channels == CHANNELS;
+    float sum = 0;
+    const uint8_t* bytes = _frame.data();
+    for (uint16_t channel = 0; channel < _channels; channel++, bytes += _bytesPerSample) {
+        float sample = 0;
+        switch (_format) {
+        case Format::PCM_U8:
+            sample = (bytes[0] - 128) / 128.0f;
+            break;
+        case Format::PCM_S16:
+            sample = static_cast<int16_t>(readLe16(bytes)) / 32768.0f;
+            break;
+        case Format::PCM_S24:
+            sample = static_cast<int32_t>((bytes[0] << 8) | (bytes[1] << 16) |
+                                          (static_cast<uint32_t>(bytes[2]) << 24)) / 2147483648.0f;
+            break;
+        case Format::PCM_S32:
+            sample = static_cast<int32_t>(readLe32(bytes)) / 2147483648.0f;
+            break;
+        case Format::FLOAT32: {
+            uint32_t bits = readLe32(bytes);
+            memcpy(&sample, &bits, sizeof(sample));
+            break;
+        }
+        }
+        if (separate) {
+            values[channel] = sample;
+        }
+        sum += sample;
+    }
+    if (!separate) {
+        for (size_t channel = 0; channel < CHANNELS; channel++) {
+            values[channel] = sum / _channels;
+        }
+    }
+    return true;
+}
+
+uint16_t PcmFileSource::toAdc(float value) const {
+    float counts = ADC_BIAS + value * _gain * ADC_BIAS;
+    if (counts < 0) {
+        return 0;
+    }
+    if (counts > ADC_MAX) {
+        return ADC_MAX;
+    }
+    return static_cast<uint16_t>(lroundf(counts));
+}
+
+bool PcmFileSource::readBlock(uint16_t* buffer, uint32_t timeoutMs) {
+    (void)timeoutMs;
+    if (!_file || _finished) {
+        return false;
+    }
+    auto start = std::chrono::steady_clock::now();
+    if (!_primed) {
+        if (!readFrame(_previous)) {
+            _finished = true;
+            return false;
+        }
+        memcpy(_next, _previous, sizeof(_next));
+        _position = 1.0; // Fetch a real second frame before interpolating
+        _primed = true;
+    }
+
+    for (size_t i = 0; i < CAPTURE_BLOCK_SIZE; i++) {
+        while (_position >= 1.0) {
+            memcpy(_previous, _next, sizeof(_previous));
+            if (!readFrame(_next)) {
+                // A partial last block is dropped, as the DMA would never deliver it
+                _finished = true;
+                return false;
+            }
+            _position -= 1.0;
+        }
+        for (size_t c = 0; c < CHANNELS; c++) {
+            float value = static_cast<float>(_previous[c] + (_next[c] - _previous[c]) * _position);
+            buffer[c * CAPTURE_BLOCK_SIZE + i] = toAdc(value);
+        }
+        _position += _step;
+    }
+
+    host::advanceMicros(static_cast<uint64_t>(CAPTURE_BLOCK_SIZE) * 1000000 / CAPTURE_RATE);
+    _readMicros += std::chrono::duration<double, std::micro>(
+        std::chrono::steady_clock::now() - start).count();
+    return true;
+}
+
+void PcmFileSource::setGain(float gain) {
+    if (gain > 0) {
+        _gain = gain;
+    }
+}
+
+bool PcmFileSource::isFinished() const {
+    return _finished;
+}
+
+uint32_t PcmFileSource::getFileRate() const {
+    return _rate;
+}
+
+uint16_t PcmFileSource::getFileChannels() const {
+    return _channels;
+}
+
+const std::string& PcmFileSource::getError() const {
+    return _error;
+}
+
+double PcmFileSource::getReadMicros() const {
+    return _readMicros;
+}
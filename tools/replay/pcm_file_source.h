@@ -0,0 +1,69 @@
+#ifndef PCM_FILE_SOURCE_H
+#define PCM_FILE_SOURCE_H
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "sample_source.h"
+
+// Streams a recording as if it came from the ADC: WAV (PCM 8/16/24/32-bit or
+// 32-bit float) or headerless little-endian 16-bit PCM. A file with exactly
+// CHANNELS channels feeds one to each microphone; otherwise its channels are
+// averaged and every microphone hears the same signal. The signal is linearly resampled to CAPTURE_RATE when needed and mapped to
+// 12-bit counts around the ADC's mid-scale bias; full scale of the file spans
+// the ADC range at a gain of 1. Each block read advances the virtual clock by
+// one block period. Resampling has no anti-alias filter, so record at or
+// above the capture rate where content above 16 kHz matters.
+class PcmFileSource : public SampleSource {
+public:
+    PcmFileSource(const std::string& path, bool raw, uint32_t rawRate, uint16_t rawChannels);
+    ~PcmFileSource() override;
+
+    bool begin() override;
+    void end() override;
+    bool readBlock(uint16_t* buffer, uint32_t timeoutMs) override;
+
+    void setGain(float gain);
+    bool isFinished() const;
+
+    uint32_t getFileRate() const;
+    uint16_t getFileChannels() const;
+    const std::string& getError() const;
+
+    // Host time spent inside readBlock() since construction, to keep file
+    // decoding out of processing-time measurements
+    double getReadMicros() const;
+
+    static constexpr uint16_t ADC_BIAS = 2048;
+
+private:
+    enum class Format { PCM_U8, PCM_S16, PCM_S24, PCM_S32, FLOAT32 };
+
+    std::string _path;
+    bool _raw;
+    FILE* _file;
+    Format _format;
+    uint32_t _rate;
+    uint16_t _channels;
+    uint16_t _bytesPerSample;
+    uint64_t _dataRemaining;
+    float _gain;
+    bool _finished;
+    std::string _error;
+    double _readMicros;
+
+    // Resampler state: position between _previous and _next, in input samples
+    double _step;
+    double _position;
+    float _previous[CHANNELS];
+    float _next[CHANNELS];
+    bool _primed;
+
+    std::vector<uint8_t> _frame;
+
+    bool parseWavHeader();
+    bool readFrame(float* values);
+    uint16_t toAdc(float value) const;
+};
+
+#endif // PCM_FILE_SOURCE_H
@@ -0,0 +1,107 @@
+#include "control_metrics.h"
+#include <Arduino.h>
+
+ControlMetrics::ControlMetrics(float band, uint32_t warmupMs)
+    : _band(band)
+    , _warmupMs(warmupMs)
+    , _lastMs(0)
+    , _started(false)
+    , _scoredMs(0)
+    , _outOfBandMs(0)
+    , _outside(false)
+    , _direction(0)
+    , _excursionStartMs(0)
+    , _excursionEndMs(0)
+    , _overshootDirection(0)
+    , _overshoot(0)
+    , _excursions(0)
+    , _convergenceSum(0)
+    , _maxConvergence(0)
+    , _overshoots(0)
+    , _overshootSum(0)
+    , _maxOvershoot(0) {
+}
+
+void ControlMetrics::addSample(uint32_t timestampMs, int volume, float idealVolume) {
+    if (timestampMs < _warmupMs) {
+        return;
+    }
+    if (!_started) {
+        _started = true;
+        _lastMs = timestampMs;
+    }
+    uint32_t elapsed = timestampMs - _lastMs;
+    _lastMs = timestampMs;
+    _scoredMs += elapsed;
+    if (_outside) {
+        _outOfBandMs += elapsed;
+    }
+
+    float error = idealVolume - volume;
+    if (_overshootDirection != 0) {
+        if (timestampMs - _excursionEndMs > OVERSHOOT_WINDOW_MS) {
+            finishOvershoot();
+        } else {
+            _overshoot = max(_overshoot, -_overshootDirection * error);
+        }
+    }
+
+    bool outside = fabsf(error) > _band;
+    if (outside && !_outside) {
+        _outside = true;
+        _direction = error > 0 ? 1 : -1;
+        _excursionStartMs = timestampMs;
+        _excursions++;
+    } else if (!outside && _outside) {
+        _outside = false;
+        float seconds = (timestampMs - _excursionStartMs) / 1000.0f;
+        _convergenceSum += seconds;
+        _maxConvergence = max(_maxConvergence, seconds);
+        if (_overshootDirection != 0) {
+            finishOvershoot();
+        }
+        _overshootDirection = _direction;
+        _overshoot = 0;
+        _excursionEndMs = timestampMs;
+    }
+}
+
+ControlReport ControlMetrics::getReport(const FakeApiClient& api) const {
+    ControlReport report;
+    report.hours = _scoredMs / 3600000.0f;
+    report.outOfBandPercent = _scoredMs > 0 ? 100.0f * _outOfBandMs / _scoredMs : 0.0f;
+    report.excursions = _excursions;
+    uint32_t converged = _excursions - (_outside ? 1 : 0);
+    report.meanConvergenceSeconds = converged > 0 ? static_cast<float>(_convergenceSum / converged) : 0.0f;
+    report.maxConvergenceSeconds = _maxConvergence;
+    // An overshoot still being watched counts with what it reached
+    uint32_t overshoots = _overshoots + (_overshootDirection != 0 ? 1 : 0);
+    double overshootSum = _overshootSum + (_overshootDirection != 0 ? _overshoot : 0.0f);
+    report.meanOvershoot = overshoots > 0 ? static_cast<float>(overshootSum / overshoots) : 0.0f;
+    report.maxOvershoot = _overshootDirection != 0 ? max(_maxOvershoot, _overshoot) : _maxOvershoot;
+
+    report.oscillations = 0;
+    uint32_t mutations = 0;
+    const VolumeMutation* previous = nullptr;
+    for (const VolumeMutation& mutation : api.getMutations()) {
+        if (mutation.timestampMs < _warmupMs) {
+            continue;
+        }
+        mutations++;
+        if (previous && mutation.timestampMs - previous->timestampMs <= OSCILLATION_WINDOW_MS &&
+            (mutation.toVolume > mutation.fromVolume) != (previous->toVolume > previous->fromVolume)) {
+            report.oscillations++;
+        }
+        previous = &mutation;
+    }
+    report.mutationsPerHour = report.hours > 0 ? mutations / report.hours : 0.0f;
+    report.readsPerHour = _lastMs > 0 ? api.getReadCount() / (_lastMs / 3600000.0f) : 0.0f;
+    return report;
+}
+
+void ControlMetrics::finishOvershoot() {
+    _overshoots++;
+    _overshootSum += _overshoot;
+    _maxOvershoot = max(_maxOvershoot, _overshoot);
+    _overshootDirection = 0;
+}
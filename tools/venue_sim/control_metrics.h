@@ -0,0 +1,65 @@
+#ifndef CONTROL_METRICS_H
+#define CONTROL_METRICS_H
+
+#include <stdint.h>
+#include "fake_api_client.h"
+
+struct ControlReport {
+    float hours;                  // Scored time, after the warm-up
+    float outOfBandPercent;       // Volume further than the band from the ideal
+    uint32_t excursions;          // Times it left the band
+    float meanConvergenceSeconds; // Time back into the band, per excursion
+    float maxConvergenceSeconds;
+    float meanOvershoot;          // Steps past the ideal after an excursion
+    float maxOvershoot;
+    uint32_t oscillations;        // Reversals within OSCILLATION_WINDOW_MS
+    float mutationsPerHour;
+    float readsPerHour;
+};
+
+// Scores how the player volume followed the ideal volume (the one the
+// controller would pick hearing only the crowd).
+//
+// An excursion starts when the volume is more than the band away from the
+// ideal and ends when it is back within it; its length is the convergence
+// time. Overshoot is how far the volume went past the ideal, against the
+// excursion's direction, until OVERSHOOT_WINDOW_MS after it ended. An
+// oscillation is a mutation reversing the previous one's direction within
+// OSCILLATION_WINDOW_MS.
+class ControlMetrics {
+public:
+    ControlMetrics(float band, uint32_t warmupMs);
+
+    // Every reading, in time order
+    void addSample(uint32_t timestampMs, int volume, float idealVolume);
+
+    ControlReport getReport(const FakeApiClient& api) const;
+
+    static constexpr uint32_t OVERSHOOT_WINDOW_MS = 120000;
+    static constexpr uint32_t OSCILLATION_WINDOW_MS = 120000;
+
+private:
+    float _band;
+    uint32_t _warmupMs;
+    uint32_t _lastMs;
+    bool _started;
+    uint64_t _scoredMs;
+    uint64_t _outOfBandMs;
+
+    bool _outside;
+    int _direction;              // +1 while the volume is below the ideal
+    uint32_t _excursionStartMs;
+    uint32_t _excursionEndMs;
+    int _overshootDirection;     // Of the last finished excursion, 0 once scored
+    float _overshoot;
+    uint32_t _excursions;
+    double _convergenceSum;
+    float _maxConvergence;
+    uint32_t _overshoots;
+    double _overshootSum;
+    float _maxOvershoot;
+
+    void finishOvershoot();
+};
+
+#endif // CONTROL_METRICS_H
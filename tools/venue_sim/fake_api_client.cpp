@@ -0,0 +1,59 @@
+#include "fake_api_client.h"
+#include <Arduino.h>
+
+FakeApiClient::FakeApiClient(RoomModel& room, int initialVolume)
+    : _room(room)
+    , _volume(initialVolume)
+    , _reads(0)
+    , _manualChanges(0)
+    , _lostReplyRate(0)
+    , _lostReplies(0)
+    , _random(1) {
+    _room.setPlayerVolume(initialVolume);
+}
+
+int FakeApiClient::getCurrentVolume() {
+    _reads++;
+    return _volume;
+}
+
+bool FakeApiClient::setPlayerVolume(int volume) {
+    if (volume < 0 || volume > RoomModel::PLAYER_MAX_VOLUME) {
+        return false;
+    }
+    _mutations.push_back({static_cast<uint32_t>(millis()), _volume, volume});
+    _volume = volume;
+    _room.setPlayerVolume(volume);
+    _random = _random * 1664525u + 1013904223u;
+    if ((_random >> 8) / 16777216.0f < _lostReplyRate) {
+        _lostReplies++;
+        return false;
+    }
+    return true;
+}
+
+void FakeApiClient::setVolumeByHand(int volume) {
+    _volume = constrain(volume, 0, static_cast<int>(RoomModel::PLAYER_MAX_VOLUME));
+    _room.setPlayerVolume(_volume);
+    _manualChanges++;
+}
+
+void FakeApiClient::setLostReplyRate(float share) {
+    _lostReplyRate = share;
+}
+
+const std::vector<VolumeMutation>& FakeApiClient::getMutations() const {
+    return _mutations;
+}
+
+uint32_t FakeApiClient::getReadCount() const {
+    return _reads;
+}
+
+uint32_t FakeApiClient::getManualChangeCount() const {
+    return _manualChanges;
+}
+
+uint32_t FakeApiClient::getLostReplyCount() const {
+    return _lostReplies;
+}
@@ -0,0 +1,45 @@
+#ifndef FAKE_API_CLIENT_H
+#define FAKE_API_CLIENT_H
+
+#include <stdint.h>
+#include <vector>
+#include "room_model.h"
+
+// One setPlayerVolume() call the player applied
+struct VolumeMutation {
+    uint32_t timestampMs;
+    int fromVolume;
+    int toVolume;
+};
+
+// Stands in for APIClient: the same volume calls, answered by the simulated
+// player in the room instead of the Soundtrack API, and every call counted.
+class FakeApiClient {
+public:
+    FakeApiClient(RoomModel& room, int initialVolume);
+
+    int getCurrentVolume();
+    bool setPlayerVolume(int volume);
+    // Staff changing the volume in the app: not one of our calls
+    void setVolumeByHand(int volume);
+    // Share of setPlayerVolume() calls the player applies but that still
+    // fail, as when the reply times out
+    void setLostReplyRate(float share);
+
+    const std::vector<VolumeMutation>& getMutations() const;
+    uint32_t getReadCount() const;
+    uint32_t getManualChangeCount() const;
+    uint32_t getLostReplyCount() const;
+
+private:
+    RoomModel& _room;
+    int _volume;
+    uint32_t _reads;
+    uint32_t _manualChanges;
+    float _lostReplyRate;
+    uint32_t _lostReplies;
+    uint32_t _random;
+    std::vector<VolumeMutation> _mutations;
+};
+
+#endif // FAKE_API_CLIENT_H
@@ -0,0 +1,482 @@
+// Closed-loop venue simulator: a synthetic restaurant (RoomModel) heard
+// through the firmware's SoundSensor, VolumeController deciding as in
+// processSound(), and a FakeApiClient player whose volume feeds back into
+// the room. Scores how well the volume follows the crowd (ControlMetrics).
+//
+//   venue_sim [options] > report.csv
+//   venue_sim --limits tools/venue_sim/limits.txt    (regression check)
+//   venue_sim --flat -26 --limits tools/venue_sim/limits_flat.txt  (steady state)
+//
+// Built by `pio run -e venue_sim` (see platformio.ini for the sources involved).
+
+#include <Arduino.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "sound_sensor.h"
+#include "volume_controller.h"
+#include "volume_scheduler.h"
+#include "room_model.h"
+#include "fake_api_client.h"
+#include "control_metrics.h"
+
+constexpr uint32_t MIN_DECISION_SPACING = 1000;   // SOUND_CHECK_INTERVAL in main.cpp
+constexpr uint32_t VOLUME_CHECK_INTERVAL = 30000; // handleVolumeControl() in main.cpp
+constexpr float REFERENCE_DBFS = -20.0f;
+constexpr uint32_t REFERENCE_MS = 20000;          // Level averaged over the second half
+constexpr uint32_t STAFF_CHECK_MS = 300000;       // Staff notice the music every 5 minutes
+constexpr int STAFF_TOLERANCE = 2;                // Steps off before they reach for the app
+
+// A day from opening at 11:00: lunch rush, afternoon lull, dinner peak
+static const std::vector<CrowdPoint> RESTAURANT_DAY = {
+    {0.0f, -42.0f}, {1.0f, -38.0f}, {1.3f, -24.0f}, {1.5f, -20.0f}, {3.0f, -21.0f}, {3.5f, -34.0f},
+    {6.0f, -36.0f}, {7.0f, -26.0f}, {8.0f, -16.0f}, {10.0f, -18.0f}, {11.0f, -30.0f}, {12.0f, -42.0f}};
+
+struct SimOptions {
+    bool help = false;
+    std::string timelineOutput;
+    std::string limits;
+    float hours = 12.0f;
+    bool flat = false;
+    float flatDbfs = 0;        // Constant crowd instead of the restaurant day
+    RoomSettings room;
+    LevelMode levelMode = LevelMode::LEQ;
+    int sensitivity = 50;
+    float chatterGate = VolumeController::DEFAULT_CHATTER_GATE;
+    ServoSettings servo = VolumeServo::DEFAULT_SETTINGS;
+    uint32_t decisionInterval = 0; // 0: paced by the controller, as on the device
+    uint32_t minDwellMs = VolumeScheduler::DEFAULT_MIN_DWELL_MS;
+    bool staff = false;
+    float staffOffset = 0;     // Steps staff want above the mapping
+    uint32_t overrideHoldMs = VolumeController::DEFAULT_OVERRIDE_HOLD_MS;
+    float lostReplies = 0;     // Share of volume commands applied but reported as failed
+    int startVolume = 8;
+    float band = 1.0f;
+    uint32_t warmupSeconds = 600;
+};
+
+static void printUsage(const char* program) {
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  -h, --help            This text\n"
+            "  -o FILE               Timeline CSV, one row per second\n"
+            "  --limits FILE         Fail (exit 1) if a metric exceeds its limit in FILE\n"
+            "  --hours H             Simulated time, repeating the restaurant day (default 12)\n"
+            "  --seed N              Crowd and group events (default 1)\n"
+            "  --flat DBFS           Crowd steady at DBFS all along, conversations still swelling\n"
+            "                        but no groups coming and going (default: the restaurant day)\n"
+            "  --dynamics on|off     Groups coming and going, conversations swelling (default on)\n"
+            "  --music-db DB         Speaker at the microphone at full volume, dBFS (default -14)\n"
+            "  --db-per-step DB      Player attenuation per volume step (default 2)\n"
+            "  --latency MS          Command to audible change (default 800)\n"
+            "  --mode peak|leq|speech  Level mode (default leq)\n"
+            "  --sensitivity N       0-100 (default 50)\n"
+            "  --chatter-gate C      Min chatter confidence to raise the volume, 0 = off (default 0.5)\n"
+            "  --servo KP,KI,KD      Volume servo gains (default 0.5,0.02,0)\n"
+            "  --deadband D,H[,S]    Servo deadband and hysteresis in volume steps, slew in\n"
+            "                        steps per second (default 0.6,0.6,0.6)\n"
+            "  --interval MS         Fixed time between decisions instead of change-point pacing\n"
+            "  --dwell MS            Minimum time between volume commands (default 10000)\n"
+            "  --staff STEPS         Staff who want the volume this many steps off the mapping\n"
+            "                        and set it by hand when it is 2 or more off (default none)\n"
+            "  --hold MIN            Back-off after a manual change, minutes (default 30)\n"
+            "  --lost-replies P      Share of volume commands the player applies but whose reply\n"
+            "                        is lost, so the call fails (default 0)\n"
+            "  --volume N            Player volume at start (default 8)\n"
+            "  --band B              Volume steps from the ideal that count as on target (default 1)\n"
+            "  --warmup S            Seconds not scored while the models learn (default 600)\n",
+            program);
+}
+
+static bool parseOptions(int argc, char** argv, SimOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            options.help = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            fprintf(stderr, "Missing value for %s\n", arg.c_str());
+            return false;
+        }
+        std::string value = argv[++i];
+
+        if (arg == "-o") {
+            options.timelineOutput = value;
+        } else if (arg == "--limits") {
+            options.limits = value;
+        } else if (arg == "--hours") {
+            options.hours = static_cast<float>(atof(value.c_str()));
+        } else if (arg == "--seed") {
+            options.room.seed = static_cast<uint32_t>(atol(value.c_str()));
+        } else if (arg == "--flat") {
+            options.flat = true;
+            options.flatDbfs = static_cast<float>(atof(value.c_str()));
+            options.room.crowdGroups = false;
+        } else if (arg == "--dynamics") {
+            if (value == "on") options.room.crowdDynamics = true;
+            else if (value == "off") options.room.crowdDynamics = false;
+            else return false;
+        } else if (arg == "--music-db") {
+            options.room.musicDbfsAtMax = static_cast<float>(atof(value.c_str()));
+        } else if (arg == "--db-per-step") {
+            options.room.dbPerStep = static_cast<float>(atof(value.c_str()));
+        } else if (arg == "--latency") {
+            options.room.playerLatencyMs = static_cast<uint32_t>(atol(value.c_str()));
+        } else if (arg == "--mode") {
+            if (value == "peak") options.levelMode = LevelMode::PEAK_TO_PEAK;
+            else if (value == "leq") options.levelMode = LevelMode::LEQ;
+            else if (value == "speech") options.levelMode = LevelMode::SPEECH;
+            else return false;
+        } else if (arg == "--sensitivity") {
+            options.sensitivity = atoi(value.c_str());
+        } else if (arg == "--chatter-gate") {
+            options.chatterGate = static_cast<float>(atof(value.c_str()));
+        } else if (arg == "--servo") {
+            if (sscanf(value.c_str(), "%f,%f,%f", &options.servo.kp, &options.servo.ki,
+                       &options.servo.kd) < 2) {
+                return false;
+            }
+        } else if (arg == "--deadband") {
+            if (sscanf(value.c_str(), "%f,%f,%f", &options.servo.deadband, &options.servo.hysteresis,
+                       &options.servo.maxSlew) < 2) {
+                return false;
+            }
+        } else if (arg == "--interval") {
+            options.decisionInterval = static_cast<uint32_t>(atol(value.c_str()));
+        } else if (arg == "--dwell") {
+            options.minDwellMs = static_cast<uint32_t>(atol(value.c_str()));
+        } else if (arg == "--staff") {
+            options.staff = true;
+            options.staffOffset = static_cast<float>(atof(value.c_str()));
+        } else if (arg == "--hold") {
+            options.overrideHoldMs = static_cast<uint32_t>(atof(value.c_str()) * 60000);
+        } else if (arg == "--lost-replies") {
+            options.lostReplies = static_cast<float>(atof(value.c_str()));
+        } else if (arg == "--volume") {
+            options.startVolume = constrain(atoi(value.c_str()), VolumeController::MIN_VOLUME,
+                                            VolumeController::MAX_VOLUME);
+        } else if (arg == "--band") {
+            options.band = static_cast<float>(atof(value.c_str()));
+        } else if (arg == "--warmup") {
+            options.warmupSeconds = static_cast<uint32_t>(atol(value.c_str()));
+        } else {
+            fprintf(stderr, "Unknown option %s\n", arg.c_str());
+            return false;
+        }
+    }
+    return options.hours > 0 && options.band > 0;
+}
+
+// The simulated day, repeated to cover the run, or a flat crowd. The flat
+// crowd fills the room from the day's opening level during the warm-up, as
+// guests arrive, so the noise floor has seen the empty room like a device
+// that has run before.
+static std::vector<CrowdPoint> buildProfile(const SimOptions& options) {
+    float hours = options.hours;
+    if (options.flat) {
+        float warmupHours = options.warmupSeconds / 3600.0f;
+        float opening = RESTAURANT_DAY.front().dbfs;
+        return {{0.0f, opening}, {warmupHours / 2, opening}, {warmupHours, options.flatDbfs},
+                {hours, options.flatDbfs}};
+    }
+    std::vector<CrowdPoint> profile;
+    float dayHours = RESTAURANT_DAY.back().hour;
+    for (float offset = 0; offset < hours; offset += dayHours) {
+        for (const CrowdPoint& point : RESTAURANT_DAY) {
+            if (offset == 0 || point.hour > 0) {
+                profile.push_back({offset + point.hour, point.dbfs});
+            }
+        }
+    }
+    return profile;
+}
+
+// Level the sensor reports for the crowd alone at REFERENCE_DBFS, or the
+// music alone at full volume. Levels follow the fourth root of power on
+// every mode's scale, so this fixes the crowd's level at any loudness.
+static bool measureReference(const SimOptions& options, bool music, float& level, float& chatterConfidence) {
+    RoomSettings settings = options.room;
+    settings.hvacDbfs = 0;
+    settings.crowdDynamics = false;
+    settings.playerLatencyMs = 0;
+    RoomModel room(settings);
+    room.setCrowdProfile({{0.0f, REFERENCE_DBFS}, {1.0f, REFERENCE_DBFS}});
+    room.setCrowdEnabled(!music);
+    room.setMusicEnabled(music);
+    SoundSensor sensor(room);
+    sensor.setLevelMode(options.levelMode);
+    host::setMicros(0);
+    if (!room.begin() || !sensor.begin()) {
+        return false;
+    }
+    room.setPlayerVolume(RoomModel::PLAYER_MAX_VOLUME);
+
+    double levelSum = 0;
+    double chatterSum = 0;
+    uint32_t count = 0;
+    while (millis() < REFERENCE_MS) {
+        sensor.process(0);
+        SoundReading reading;
+        while (sensor.poll(reading)) {
+            if (reading.timestamp >= REFERENCE_MS / 2) {
+                levelSum += reading.level;
+                chatterSum += reading.chatterConfidence;
+                count++;
+            }
+        }
+    }
+    if (count == 0) {
+        return false;
+    }
+    level = static_cast<float>(levelSum / count);
+    chatterConfidence = static_cast<float>(chatterSum / count);
+    return true;
+}
+
+// name limit per line, # comments; every name must be a reported metric
+static bool checkLimits(const std::string& path, const std::vector<std::pair<const char*, float>>& metrics) {
+    FILE* file = fopen(path.c_str(), "r");
+    if (!file) {
+        fprintf(stderr, "Cannot open %s\n", path.c_str());
+        return false;
+    }
+    bool passed = true;
+    char line[128];
+    while (fgets(line, sizeof(line), file)) {
+        char name[64];
+        float limit;
+        if (line[0] == '#' || sscanf(line, "%63s %f", name, &limit) != 2) {
+            continue;
+        }
+        bool found = false;
+        for (const auto& metric : metrics) {
+            if (strcmp(metric.first, name) == 0) {
+                found = true;
+                if (metric.second > limit) {
+                    fprintf(stderr, "Regression: %s %.2f above %.2f\n", name, metric.second, limit);
+                    passed = false;
+                }
+            }
+        }
+        if (!found) {
+            fprintf(stderr, "Unknown metric %s in %s\n", name, path.c_str());
+            passed = false;
+        }
+    }
+    fclose(file);
+    return passed;
+}
+
+int main(int argc, char** argv) {
+    SimOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 2;
+    }
+    if (options.help) {
+        printUsage(argv[0]);
+        return 0;
+    }
+    auto wallStart = std::chrono::steady_clock::now();
+
+    float referenceLevel;
+    float referenceChatter;
+    float musicLevel;
+    float musicChatter;
+    if (!measureReference(options, false, referenceLevel, referenceChatter) ||
+        !measureReference(options, true, musicLevel, musicChatter)) {
+        fprintf(stderr, "Reference measurement failed\n");
+        return 1;
+    }
+
+    host::setMicros(0);
+    RoomModel room(options.room);
+    room.setCrowdProfile(buildProfile(options));
+    SoundSensor sensor(room);
+    sensor.setLevelMode(options.levelMode);
+    if (!room.begin() || !sensor.begin()) {
+        fprintf(stderr, "Cannot start the room\n");
+        return 1;
+    }
+    FakeApiClient api(room, options.startVolume);
+    api.setLostReplyRate(options.lostReplies);
+
+    VolumeController controller;
+    controller.setSensitivity(options.sensitivity);
+    controller.setChatterGate(options.chatterGate);
+    controller.setAdaptivePacing(options.decisionInterval == 0);
+    if (!controller.setServoSettings(options.servo)) {
+        fprintf(stderr, "Invalid servo settings\n");
+        return 2;
+    }
+    if (!controller.setOverrideHold(options.overrideHoldMs)) {
+        fprintf(stderr, "Invalid hold time\n");
+        return 2;
+    }
+    VolumeScheduler scheduler;
+    if (!scheduler.setMinDwell(options.minDwellMs)) {
+        fprintf(stderr, "Invalid minimum dwell\n");
+        return 2;
+    }
+    ControlMetrics metrics(options.band, options.warmupSeconds * 1000);
+
+    FILE* timeline = nullptr;
+    if (!options.timelineOutput.empty()) {
+        timeline = fopen(options.timelineOutput.c_str(), "w");
+        if (!timeline) {
+            fprintf(stderr, "Cannot open output file\n");
+            return 1;
+        }
+        fprintf(timeline, "time_s,crowd_dbfs,ideal_volume,target_volume,volume,level,noise_floor,chatter\n");
+    }
+
+    const uint32_t endMs = static_cast<uint32_t>(options.hours * 3600000.0f);
+    int lastVolume = api.getCurrentVolume();
+    int targetVolume = lastVolume;
+    unsigned long lastDecision = 0;
+    unsigned long lastVolumeCheck = 0;
+    unsigned long lastStaffCheck = 0;
+    float idealVolume = static_cast<float>(lastVolume);
+    uint32_t detectedOverrides = 0;
+    uint32_t learnedOverrides = 0;
+    uint32_t nextTimelineMs = 0;
+    uint32_t decisions = 0;
+    uint32_t gatedDecisions = 0;
+
+    while (millis() < endMs) {
+        sensor.process(0);
+
+        // handleSoundReadings(), scoring every reading against the crowd alone
+        SoundReading reading;
+        bool hasReading = false;
+        while (sensor.poll(reading)) {
+            hasReading = true;
+            controller.addReading(reading.level, reading.chatterConfidence, reading.timestamp);
+            float crowdDbfs = room.getCrowdDbfs(reading.timestamp);
+            float crowdLevel = referenceLevel * powf(10.0f, (crowdDbfs - REFERENCE_DBFS) / 40.0f);
+            // With staff, what they want is the ideal
+            idealVolume = options.staff
+                ? constrain(controller.getBaseTargetVolume(crowdLevel) + options.staffOffset,
+                            static_cast<float>(VolumeController::MIN_VOLUME),
+                            static_cast<float>(VolumeController::MAX_VOLUME))
+                : controller.getTargetVolume(crowdLevel);
+            metrics.addSample(reading.timestamp, lastVolume, idealVolume);
+            if (timeline && reading.timestamp >= nextTimelineMs) {
+                nextTimelineMs += 1000;
+                fprintf(timeline, "%u,%.2f,%.2f,%d,%d,%.4f,%.4f,%.3f\n", reading.timestamp / 1000, crowdDbfs,
+                        idealVolume, targetVolume, lastVolume, reading.level, reading.noiseFloor,
+                        reading.chatterConfidence);
+            }
+        }
+        if (!hasReading) {
+            continue;
+        }
+
+        // Staff fix the volume in the app when it is clearly off
+        if (options.staff && millis() - lastStaffCheck >= STAFF_CHECK_MS) {
+            lastStaffCheck = millis();
+            int wanted = static_cast<int>(lroundf(idealVolume));
+            if (abs(room.getAudibleVolume() - wanted) >= STAFF_TOLERANCE) {
+                api.setVolumeByHand(wanted);
+            }
+        }
+
+        // handleVolumeControl(): polls the player for changes made elsewhere
+        uint32_t checkInterval = scheduler.isConfirming() ? VolumeScheduler::CONFIRM_MS : VOLUME_CHECK_INTERVAL;
+        if (millis() - lastVolumeCheck >= checkInterval) {
+            lastVolumeCheck = millis();
+            int currentVolume = api.getCurrentVolume();
+            PlayerVolume reported = scheduler.classifyPlayerVolume(currentVolume, lastVolume, millis());
+            if (reported == PlayerVolume::OWN_COMMAND) {
+                lastVolume = currentVolume;
+            } else if (reported == PlayerVolume::MANUAL) {
+                detectedOverrides++;
+                if (controller.onExternalVolumeChange(lastVolume, currentVolume, millis(), 0)) {
+                    learnedOverrides++;
+                }
+                scheduler.onExternalVolumeChange();
+                lastVolume = currentVolume;
+            }
+        }
+
+        // processSound()
+        bool decided = options.decisionInterval > 0
+            ? millis() - lastDecision >= options.decisionInterval
+            : millis() - lastDecision >= MIN_DECISION_SPACING && controller.isDecisionDue(millis());
+        if (decided) {
+            lastDecision = millis();
+            decisions++;
+            VolumeDecision decision = controller.decide(sensor.getSoundLevel(), sensor.getNoiseFloor(),
+                                                        lastVolume, millis());
+            targetVolume = decision.targetVolume;
+            gatedDecisions += decision.gated ? 1 : 0;
+            scheduler.request(decision.newVolume, lastVolume, decision.surge);
+        }
+
+        // sendScheduledVolume()
+        int newVolume;
+        if (scheduler.isCommandDue(millis(), newVolume)) {
+            bool accepted = api.setPlayerVolume(newVolume);
+            scheduler.onCommandSent(newVolume, accepted, millis());
+            if (accepted) {
+                controller.onVolumeCommanded(lastVolume, newVolume, millis());
+                lastVolume = newVolume;
+            }
+        }
+    }
+    if (timeline) {
+        fclose(timeline);
+    }
+
+    ControlReport report = metrics.getReport(api);
+    const std::vector<std::pair<const char*, float>> values = {
+        {"out_of_band_percent", report.outOfBandPercent},
+        {"excursions_per_hour", report.hours > 0 ? report.excursions / report.hours : 0.0f},
+        {"mean_convergence_s", report.meanConvergenceSeconds},
+        {"max_convergence_s", report.maxConvergenceSeconds},
+        {"mean_overshoot", report.meanOvershoot},
+        {"max_overshoot", report.maxOvershoot},
+        {"oscillations_per_hour", report.hours > 0 ? report.oscillations / report.hours : 0.0f},
+        {"mutations_per_hour", report.mutationsPerHour},
+        {"reads_per_hour", report.readsPerHour},
+        {"overrides_per_hour", api.getManualChangeCount() / options.hours},
+    };
+    printf("metric,value\n");
+    for (const auto& value : values) {
+        printf("%s,%.3f\n", value.first, value.second);
+    }
+
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    fprintf(stderr, "Simulated %.1f h in %.1f s; crowd at %.0f dBFS reads level %.3f, chatter %.2f\n",
+            options.hours, wallSeconds, REFERENCE_DBFS, referenceLevel, referenceChatter);
+    float musicPower = musicLevel * musicLevel * musicLevel * musicLevel;
+    fprintf(stderr, "Feedback model at volume %d: %.4f (music alone %.4f), %u observations\n",
+            RoomModel::PLAYER_MAX_VOLUME, controller.feedback().getFeedbackPower(RoomModel::PLAYER_MAX_VOLUME),
+            musicPower, controller.feedback().getObservationCount());
+    fprintf(stderr, "Decisions: %u (%u increases held, not chatter), %zu volume changes, %u reads\n",
+            decisions, gatedDecisions, api.getMutations().size(), api.getReadCount());
+    const SchedulerCounters& commands = scheduler.getCounters();
+    fprintf(stderr, "Commands: %u issued (%u urgent), %u coalesced, %u suppressed\n", commands.issued,
+            commands.urgent, commands.coalesced, commands.suppressed);
+    fprintf(stderr, "Player reads: %u overrides detected (%u manual changes), %u off by our own command, "
+            "%u lost replies\n", detectedOverrides, api.getManualChangeCount(), commands.echoes,
+            api.getLostReplyCount());
+    if (options.staff) {
+        const PreferenceModel& preference = controller.preference().getModel();
+        fprintf(stderr, "Staff: %u manual changes, %u learned; preference %+.2f steps at level %.2f, slope %+.1f\n",
+                api.getManualChangeCount(), learnedOverrides, preference.offset, PreferenceLearner::PIVOT_LEVEL,
+                preference.slope);
+    }
+    fprintf(stderr, "Scored %.1f h: %.1f%% out of band (+-%.1f), %u excursions, convergence mean %.0f s / max %.0f s\n",
+            report.hours, report.outOfBandPercent, options.band, report.excursions,
+            report.meanConvergenceSeconds, report.maxConvergenceSeconds);
+    fprintf(stderr, "Overshoot mean %.2f / max %.2f steps, %u oscillations, %.1f changes and %.1f reads per hour\n",
+            report.meanOvershoot, report.maxOvershoot, report.oscillations, report.mutationsPerHour,
+            report.readsPerHour);
+
+    if (!options.limits.empty() && !checkLimits(options.limits, values)) {
+        return 1;
+    }
+    return 0;
+}
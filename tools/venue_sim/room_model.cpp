@@ -0,0 +1,258 @@
+#include "room_model.h"
+#include <Arduino.h>
+
+static float dbToAmplitude(float db) {
+    return powf(10.0f, db / 20.0f);
+}
+
+RoomModel::RoomModel(const RoomSettings& settings)
+    : _settings(settings)
+    , _crowdEnabled(true)
+    , _musicEnabled(true)
+    , _startMicros(0)
+    , _random(settings.seed * 2654435761u + 1)
+    , _swingDb(0)
+    , _babblePosition(0)
+    , _musicPosition(0)
+    , _hvacPosition(0)
+    , _volume(0)
+    , _pendingVolume(-1)
+    , _pendingAtMs(0) {
+}
+
+bool RoomModel::begin() {
+    if (_profile.empty()) {
+        return false;
+    }
+    _startMicros = host::clockMicros();
+    if (_babble.empty()) {
+        synthesizeBabble();
+        synthesizeMusic();
+        synthesizeHvac();
+    }
+    _events.clear();
+    if (_settings.crowdDynamics && _settings.crowdGroups) {
+        scheduleEvents(static_cast<uint32_t>(_profile.back().hour * 3600000.0f));
+    }
+    return true;
+}
+
+void RoomModel::end() {
+}
+
+bool RoomModel::readBlock(uint16_t* buffer, uint32_t timeoutMs) {
+    (void)timeoutMs;
+    uint32_t now = elapsedMs();
+    if (_pendingVolume >= 0 && static_cast<int32_t>(now - _pendingAtMs) >= 0) {
+        _volume = _pendingVolume;
+        _pendingVolume = -1;
+    }
+
+    // Swings: Ornstein-Uhlenbeck process, stepped once per block
+    const float step = static_cast<float>(BLOCK_MS) / 1000.0f / CROWD_SWING_SECONDS;
+    float gaussian = (uniform() + uniform() + uniform() - 1.5f) * 2.0f;  // Unit variance
+    if (_settings.crowdDynamics) {
+        _swingDb += -_swingDb * step + CROWD_SWING_DB * sqrtf(2 * step) * gaussian;
+    }
+
+    float crowd = _crowdEnabled ? dbToAmplitude(getCrowdDbfs(now) + _swingDb) * FULL_SCALE : 0.0f;
+    float music = _musicEnabled && _volume > 0
+        ? dbToAmplitude(_settings.musicDbfsAtMax - (PLAYER_MAX_VOLUME - _volume) * _settings.dbPerStep) * FULL_SCALE
+        : 0.0f;
+    float hvac = _settings.hvacDbfs < 0 ? dbToAmplitude(_settings.hvacDbfs) * FULL_SCALE : 0.0f;
+
+    for (size_t i = 0; i < CAPTURE_BLOCK_SIZE; i++) {
+        float value = ADC_BIAS + crowd * _babble[_babblePosition] + music * _music[_musicPosition] +
+                      hvac * _hvac[_hvacPosition];
+        value = constrain(value, 0.0f, static_cast<float>(ADC_MAX));
+        buffer[i] = static_cast<uint16_t>(value + 0.5f);
+        // Babble restarts anywhere, so the crowd never repeats exactly
+        if (++_babblePosition == _babble.size()) {
+            _babblePosition = static_cast<size_t>(uniform() * (_babble.size() / 2));
+        }
+        if (++_musicPosition == _music.size()) {
+            _musicPosition = 0;
+        }
+        if (++_hvacPosition == _hvac.size()) {
+            _hvacPosition = 0;
+        }
+    }
+    for (size_t c = 1; c < CHANNELS; c++) {
+        memcpy(buffer + c * CAPTURE_BLOCK_SIZE, buffer, CAPTURE_BLOCK_SIZE * sizeof(uint16_t));
+    }
+
+    host::advanceMicros(static_cast<uint64_t>(CAPTURE_BLOCK_SIZE) * 1000000 / CAPTURE_RATE);
+    return true;
+}
+
+void RoomModel::setCrowdProfile(const std::vector<CrowdPoint>& profile) {
+    _profile = profile;
+}
+
+void RoomModel::setCrowdEnabled(bool enabled) {
+    _crowdEnabled = enabled;
+}
+
+void RoomModel::setMusicEnabled(bool enabled) {
+    _musicEnabled = enabled;
+}
+
+void RoomModel::setPlayerVolume(int volume) {
+    _pendingVolume = constrain(volume, 0, static_cast<int>(PLAYER_MAX_VOLUME));
+    _pendingAtMs = elapsedMs() + _settings.playerLatencyMs;
+}
+
+int RoomModel::getAudibleVolume() const {
+    return _volume;
+}
+
+float RoomModel::getCrowdDbfs(uint32_t timeMs) const {
+    float hour = timeMs / 3600000.0f;
+    float dbfs = _profile.back().dbfs;
+    if (hour <= _profile.front().hour) {
+        dbfs = _profile.front().dbfs;
+    } else {
+        for (size_t i = 1; i < _profile.size(); i++) {
+            if (hour <= _profile[i].hour) {
+                const CrowdPoint& a = _profile[i - 1];
+                const CrowdPoint& b = _profile[i];
+                dbfs = a.dbfs + (b.dbfs - a.dbfs) * (hour - a.hour) / (b.hour - a.hour);
+                break;
+            }
+        }
+    }
+    for (const CrowdEvent& event : _events) {
+        if (timeMs >= event.startMs && timeMs < event.endMs) {
+            dbfs += event.deltaDb;
+        }
+    }
+    return dbfs;
+}
+
+float RoomModel::uniform() {
+    _random = _random * 1664525u + 1013904223u;
+    return (_random >> 8) / 16777216.0f;
+}
+
+uint32_t RoomModel::elapsedMs() const {
+    return static_cast<uint32_t>((host::clockMicros() - _startMicros) / 1000);
+}
+
+void RoomModel::synthesizeBabble() {
+    const float rate = static_cast<float>(CAPTURE_RATE);
+    const float pi = 3.14159265f;
+    _babble.assign(static_cast<size_t>(BABBLE_SECONDS * rate), 0.0f);
+
+    for (size_t talker = 0; talker < CROWD_TALKERS; talker++) {
+        float pitch = 90.0f + 150.0f * uniform();
+        size_t position = static_cast<size_t>(uniform() * rate);
+        while (position < _babble.size()) {
+            // Pause, now and then the end of a sentence
+            float pause = uniform() < 0.15f ? 0.8f + 1.7f * uniform() : 0.05f + 0.2f * uniform();
+            position += static_cast<size_t>(pause * rate);
+            size_t length = static_cast<size_t>((0.12f + 0.18f * uniform()) * rate);
+            bool voiced = uniform() < 0.7f;
+            float amplitude = 0.5f + 0.5f * uniform();
+
+            // Voiced: sawtooth at the pitch through a formant resonator;
+            // fricative: noise above a few kHz
+            float formant = 400.0f + 400.0f * uniform();
+            float radius = 0.97f;
+            float a1 = 2 * radius * cosf(2 * pi * formant / rate);
+            float a2 = -radius * radius;
+            float phase = 0, y1 = 0, y2 = 0, lowpass = 0, previous = 0;
+            for (size_t i = 0; i < length && position + i < _babble.size(); i++) {
+                float envelope = 0.5f - 0.5f * cosf(2 * pi * i / length);
+                float sample;
+                if (voiced) {
+                    phase += pitch * (1.0f + 0.1f * i / length) / rate;
+                    phase -= floorf(phase);
+                    lowpass += 0.2f * (2 * phase - 1 - lowpass);
+                    float resonance = 0.05f * lowpass + a1 * y1 + a2 * y2;
+                    y2 = y1;
+                    y1 = resonance;
+                    sample = lowpass + 0.3f * resonance;
+                } else {
+                    float noise = 2 * uniform() - 1;
+                    sample = noise - previous;  // First difference: tilted to the top
+                    previous = noise;
+                    sample *= 0.5f;
+                }
+                _babble[position + i] += amplitude * envelope * sample;
+            }
+            position += length;
+        }
+    }
+    normalize(_babble);
+}
+
+void RoomModel::synthesizeMusic() {
+    const float rate = static_cast<float>(CAPTURE_RATE);
+    const float pi = 3.14159265f;
+    const float chords[2][3] = {{220.0f, 277.2f, 329.6f}, {196.0f, 246.9f, 293.7f}};
+    _music.assign(static_cast<size_t>(MUSIC_SECONDS * rate), 0.0f);
+
+    float previous = 0;
+    for (size_t i = 0; i < _music.size(); i++) {
+        float t = i / rate;
+        float beat = fmodf(t, 0.5f);
+        float offbeat = fmodf(t + 0.125f, 0.25f);
+        const float* chord = chords[t < MUSIC_SECONDS / 2 ? 0 : 1];
+        float value = sinf(2 * pi * 55.0f * beat) * expf(-beat / 0.12f);
+        value += 0.5f * sinf(2 * pi * chord[0] / 4 * t);
+        for (size_t n = 0; n < 3; n++) {
+            value += 0.2f * sinf(2 * pi * chord[n] * t);
+        }
+        float noise = 2 * uniform() - 1;
+        value += 0.3f * (noise - previous) * expf(-offbeat / 0.02f);
+        previous = noise;
+        _music[i] = value;
+    }
+    normalize(_music);
+}
+
+void RoomModel::synthesizeHvac() {
+    const float rate = static_cast<float>(CAPTURE_RATE);
+    const float pi = 3.14159265f;
+    _hvac.assign(static_cast<size_t>(HVAC_SECONDS * rate), 0.0f);
+
+    float rumble = 0;
+    for (size_t i = 0; i < _hvac.size(); i++) {
+        float t = i / rate;
+        rumble += 0.02f * (2 * uniform() - 1 - rumble);
+        _hvac[i] = sinf(2 * pi * 100.0f * t) + 0.4f * sinf(2 * pi * 200.0f * t) + 4 * rumble;
+    }
+    normalize(_hvac);
+}
+
+void RoomModel::scheduleEvents(uint32_t untilMs) {
+    // Poisson arrivals; each group raises or lowers the room by 2-6 dB for
+    // 10-40 minutes
+    float minutes = 0;
+    for (;;) {
+        minutes += -EVENT_INTERVAL_MINUTES * logf(1.0f - uniform());
+        uint32_t start = static_cast<uint32_t>(minutes * 60000.0f);
+        if (start >= untilMs) {
+            break;
+        }
+        CrowdEvent event;
+        event.startMs = start;
+        event.endMs = start + static_cast<uint32_t>((10.0f + 30.0f * uniform()) * 60000.0f);
+        float magnitude = 2.0f + 4.0f * uniform();
+        event.deltaDb = uniform() < 0.5f ? magnitude : -magnitude;
+        _events.push_back(event);
+    }
+}
+
+void RoomModel::normalize(std::vector<float>& signal) {
+    double sum = 0;
+    for (float value : signal) {
+        sum += static_cast<double>(value) * value;
+    }
+    float rms = static_cast<float>(sqrt(sum / signal.size()));
+    if (rms > 0) {
+        for (float& value : signal) {
+            value /= rms;
+        }
+    }
+}
@@ -0,0 +1,104 @@
+#ifndef ROOM_MODEL_H
+#define ROOM_MODEL_H
+
+#include <stdint.h>
+#include <vector>
+#include "sample_source.h"
+
+// Crowd loudness at one time of the simulated day, linearly interpolated
+struct CrowdPoint {
+    float hour;
+    float dbfs;
+};
+
+struct RoomSettings {
+    float musicDbfsAtMax = -14.0f;  // Speaker at the microphone at full volume
+    float dbPerStep = 2.0f;         // Player attenuation per volume step
+    float hvacDbfs = -50.0f;        // Stationary background; 0 dB off
+    uint32_t playerLatencyMs = 800; // Command to audible change
+    bool crowdDynamics = true;      // Groups and swings on top of the profile
+    bool crowdGroups = true;        // Groups only; swings follow crowdDynamics alone
+    uint32_t seed = 1;
+};
+
+// Synthetic restaurant as heard by the microphone: crowd babble following a
+// loudness profile, the speaker playing music at the player volume, and an
+// HVAC hum. Each part loops over a precomputed buffer with unit RMS, scaled
+// per block, so a simulated hour costs far less than the DSP on it.
+//
+// Babble is CROWD_TALKERS voices, each a run of syllables (voiced pulse
+// trains or fricative noise) and pauses, so the chatter detector hears
+// people. On top of the profile, groups come and go: steps of a few dB that
+// last tens of minutes, and conversations swell and ebb: a random swing of
+// CROWD_SWING_DB over about CROWD_SWING_SECONDS, whose lulls are what the
+// noise-floor tracker needs to tell the crowd from the background. Levels are RMS relative to the ADC's full-scale
+// amplitude. Each block read advances the virtual clock by one block
+// period.
+class RoomModel : public SampleSource {
+public:
+    explicit RoomModel(const RoomSettings& settings);
+
+    bool begin() override;
+    void end() override;
+    bool readBlock(uint16_t* buffer, uint32_t timeoutMs) override;
+
+    void setCrowdProfile(const std::vector<CrowdPoint>& profile);
+    void setCrowdEnabled(bool enabled);
+    void setMusicEnabled(bool enabled);
+
+    // The player's volume from now on, audible after the latency
+    void setPlayerVolume(int volume);
+    int getAudibleVolume() const;
+
+    // Crowd alone at a time since begin(): profile and events, without the
+    // swings, i.e. what the volume should follow
+    float getCrowdDbfs(uint32_t timeMs) const;
+
+    static constexpr int PLAYER_MAX_VOLUME = 16;
+    static constexpr uint16_t ADC_BIAS = 2048;
+    static constexpr float FULL_SCALE = 2047.0f;
+    static constexpr size_t CROWD_TALKERS = 8;
+    static constexpr float BABBLE_SECONDS = 16.0f;
+    static constexpr float MUSIC_SECONDS = 4.0f;   // Two bars at 120 bpm
+    static constexpr float HVAC_SECONDS = 1.0f;
+    static constexpr float EVENT_INTERVAL_MINUTES = 20.0f;  // Mean time between groups
+    static constexpr float CROWD_SWING_DB = 2.0f;           // Standard deviation
+    static constexpr float CROWD_SWING_SECONDS = 30.0f;     // Correlation time
+
+private:
+    struct CrowdEvent {
+        uint32_t startMs;
+        uint32_t endMs;
+        float deltaDb;
+    };
+
+    RoomSettings _settings;
+    std::vector<CrowdPoint> _profile;
+    std::vector<CrowdEvent> _events;
+    bool _crowdEnabled;
+    bool _musicEnabled;
+    uint64_t _startMicros;
+    uint32_t _random;
+    float _swingDb;
+
+    std::vector<float> _babble;
+    std::vector<float> _music;
+    std::vector<float> _hvac;
+    size_t _babblePosition;
+    size_t _musicPosition;
+    size_t _hvacPosition;
+
+    int _volume;
+    int _pendingVolume;
+    uint32_t _pendingAtMs;
+
+    float uniform();
+    uint32_t elapsedMs() const;
+    void synthesizeBabble();
+    void synthesizeMusic();
+    void synthesizeHvac();
+    void scheduleEvents(uint32_t untilMs);  // From the start of the profile
+    static void normalize(std::vector<float>& signal);
+};
+
+#endif // ROOM_MODEL_H